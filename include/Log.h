@@ -12,8 +12,26 @@
 #include <ostream>
 #include <cstdarg>
 #include <map>
+#include <string_view>
+#include <type_traits>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cmath>
 #include "Util.h"
 #include "Singleton.h"
+#include "MPSCQueue.h"
+#include "LogBuffer.h"
+#include "LogFormat.h"
+#include "LogFields.h"
+#include "LogBinary.h"
+#include "LogWriter.h"
+#include "LogIndex.h"
+#include "LogShm.h"
+#include "LogEpoch.h"
+#include "LogRateLimit.h"
+#include "LogSite.h"
 #ifdef _WINDOWS_
 #undef ERROR
 #endif
@@ -30,11 +48,52 @@
 #define LOG_API
 #endif
 
-#define NILESTHUMP_LOG_LEVEL(logger, level) \
-	if(logger->getLevel() <= level) \
-		GameProjectServer::LogEventWrap(GameProjectServer::LogEvent::ptr(\
-		new GameProjectServer::LogEvent(logger, level, __FILE__, __LINE__, 0,\
-		GameProjectServer::GetThreadId(), GameProjectServer::GetFiberId(), time(0)))).getSS()
+//printf风格格式串检查
+#if defined(__GNUC__) || defined(__clang__)
+#define NST_PRINTF_FORMAT(fmt_index, arg_index) __attribute__((format(printf, fmt_index, arg_index)))
+#else
+#define NST_PRINTF_FORMAT(fmt_index, arg_index)
+#endif
+
+//分支预测提示
+#if defined(__GNUC__) || defined(__clang__)
+#define NST_LIKELY(x) __builtin_expect(!!(x), 1)
+#define NST_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define NST_LIKELY(x) (x)
+#define NST_UNLIKELY(x) (x)
+#endif
+
+/***************************************************
+	编译期最低日志级别，取值同LogLevel::Level
+	低于该级别的日志语句条件恒为假，参数不会求值，
+	整条语句被编译器消除，例如发布版本去掉DEBUG日志：
+	-DNILESTHUMP_LOG_COMPILE_LEVEL=2
+***************************************************/
+#ifndef NILESTHUMP_LOG_COMPILE_LEVEL
+#define NILESTHUMP_LOG_COMPILE_LEVEL 1
+#endif
+
+/***************************************************
+	声明调用点的静态LogSite(nst_site)并判断级别，级别不满足时计数后跳过，
+	后面接级别满足时执行的语句；编译期去掉的语句不注册调用点，
+	输出分支标记为不常走，使调用处的热路径保持紧凑。
+	level必须是编译期常量，否则编译失败：nst_site只在首次执行时记录级别，
+	运行期才确定级别时用LogEvent::Acquire构造事件后调用Logger::log。
+	if(cond){}else的写法保证宏后面用户写的else不会与宏内的if配对
+***************************************************/
+#define NILESTHUMP_LOG_SITE_IF(logger, level) \
+	if(std::integral_constant<GameProjectServer::LogLevel::Level, (level)>::value < NILESTHUMP_LOG_COMPILE_LEVEL) {} \
+	else if(static GameProjectServer::LogSite nst_site(__FILE__, __LINE__, level); \
+		!NST_UNLIKELY((logger)->isEnabled(level))) { nst_site.suppress(); } else
+
+#define NILESTHUMP_LOG_WRAP(logger, level) \
+	NILESTHUMP_LOG_SITE_IF(logger, level) \
+		GameProjectServer::LogEventWrap(GameProjectServer::LogEvent::Acquire(logger, level,\
+		__FILE__, __LINE__, GameProjectServer::GetThreadId(), GameProjectServer::GetFiberId()), &nst_site)
+
+//level须为编译期常量，见NILESTHUMP_LOG_SITE_IF
+#define NILESTHUMP_LOG_LEVEL(logger, level) NILESTHUMP_LOG_WRAP(logger, level).getSS()
 
 #define NILESTHUMP_LOG_DEBUG(logger) NILESTHUMP_LOG_LEVEL(logger, GameProjectServer::LogLevel::DEBUG)
 #define NILESTHUMP_LOG_INFO(logger) NILESTHUMP_LOG_LEVEL(logger, GameProjectServer::LogLevel::INFO)
@@ -42,11 +101,21 @@
 #define NILESTHUMP_LOG_ERROR(logger) NILESTHUMP_LOG_LEVEL(logger, GameProjectServer::LogLevel::ERROR)
 #define NILESTHUMP_LOG_FATAL(logger) NILESTHUMP_LOG_LEVEL(logger, GameProjectServer::LogLevel::FATAL)
 
+/***************************************************
+	带结构化字段的日志，kv的值按类型直接编码到事件中，
+	由格式器的%J(JSON)、%K(logfmt)输出，文本格式中用%k附在消息后
+	NILESTHUMP_LOG_KV_INFO(logger).kv("player_id", id).kv("zone", zone).getSS() << "login";
+***************************************************/
+#define NILESTHUMP_LOG_KV_LEVEL(logger, level) NILESTHUMP_LOG_WRAP(logger, level)
+
+#define NILESTHUMP_LOG_KV_DEBUG(logger) NILESTHUMP_LOG_KV_LEVEL(logger, GameProjectServer::LogLevel::DEBUG)
+#define NILESTHUMP_LOG_KV_INFO(logger) NILESTHUMP_LOG_KV_LEVEL(logger, GameProjectServer::LogLevel::INFO)
+#define NILESTHUMP_LOG_KV_WARN(logger) NILESTHUMP_LOG_KV_LEVEL(logger, GameProjectServer::LogLevel::WARN)
+#define NILESTHUMP_LOG_KV_ERROR(logger) NILESTHUMP_LOG_KV_LEVEL(logger, GameProjectServer::LogLevel::ERROR)
+#define NILESTHUMP_LOG_KV_FATAL(logger) NILESTHUMP_LOG_KV_LEVEL(logger, GameProjectServer::LogLevel::FATAL)
+
 #define NILESTHUMP_LOG_FMT_LEVEL(logger, level, fmt, ...) \
-	if(logger->getLevel() <= level) \
-		GameProjectServer::LogEventWrap(GameProjectServer::LogEvent::ptr(\
-		new GameProjectServer::LogEvent(logger, level, __FILE__, __LINE__, 0,\
-		GameProjectServer::GetThreadId(), GameProjectServer::GetFiberId(), time(0)))).getEvent()->format(fmt, ##__VA_ARGS__)
+	NILESTHUMP_LOG_WRAP(logger, level).getEvent()->format(fmt, ##__VA_ARGS__)
 
 #define NILESTHUMP_LOG_FMT_DEBUG(logger, fmt, ...) NILESTHUMP_LOG_FMT_LEVEL(logger, GameProjectServer::LogLevel::DEBUG, fmt, ##__VA_ARGS__)
 #define NILESTHUMP_LOG_FMT_INFO(logger, fmt, ...) NILESTHUMP_LOG_FMT_LEVEL(logger, GameProjectServer::LogLevel::INFO, fmt, ##__VA_ARGS__)
@@ -54,13 +123,94 @@
 #define NILESTHUMP_LOG_FMT_ERROR(logger, fmt, ...) NILESTHUMP_LOG_FMT_LEVEL(logger, GameProjectServer::LogLevel::ERROR, fmt, ##__VA_ARGS__)
 #define NILESTHUMP_LOG_FMT_FATAL(logger, fmt, ...) NILESTHUMP_LOG_FMT_LEVEL(logger, GameProjectServer::LogLevel::FATAL, fmt, ##__VA_ARGS__)
 
-#define NILESTHUMP_LOG_ROOT() GameProjectServer::LoggerMgr::GetInstance()->getRoot()
+/***************************************************
+	{}风格的格式化日志，参数类型安全，
+	格式串为字面量时在编译期检查参数个数
+	NILESTHUMP_LOG_PRINT_INFO(logger, "player {} hp {}", id, hp);
+***************************************************/
+#define NILESTHUMP_LOG_PRINT_LEVEL(logger, level, fmt, ...) \
+	NILESTHUMP_LOG_WRAP(logger, level).getEvent()->print(\
+		GameProjectServer::LogFormatString<GameProjectServer::LogFormatArgCount(fmt)>{ fmt }, ##__VA_ARGS__)
+
+#define NILESTHUMP_LOG_PRINT_DEBUG(logger, fmt, ...) NILESTHUMP_LOG_PRINT_LEVEL(logger, GameProjectServer::LogLevel::DEBUG, fmt, ##__VA_ARGS__)
+#define NILESTHUMP_LOG_PRINT_INFO(logger, fmt, ...) NILESTHUMP_LOG_PRINT_LEVEL(logger, GameProjectServer::LogLevel::INFO, fmt, ##__VA_ARGS__)
+#define NILESTHUMP_LOG_PRINT_WARN(logger, fmt, ...) NILESTHUMP_LOG_PRINT_LEVEL(logger, GameProjectServer::LogLevel::WARN, fmt, ##__VA_ARGS__)
+#define NILESTHUMP_LOG_PRINT_ERROR(logger, fmt, ...) NILESTHUMP_LOG_PRINT_LEVEL(logger, GameProjectServer::LogLevel::ERROR, fmt, ##__VA_ARGS__)
+#define NILESTHUMP_LOG_PRINT_FATAL(logger, fmt, ...) NILESTHUMP_LOG_PRINT_LEVEL(logger, GameProjectServer::LogLevel::FATAL, fmt, ##__VA_ARGS__)
+
+/***************************************************
+	二进制日志，调用线程只写出调用点id、时间戳与参数原始字节，
+	格式化推迟到logdecode离线进行，格式串使用{}占位符，
+	参数只支持算术类型与字符串，
+	日志器没有BinaryLogAppender时按文本日志输出，
+	调用点统计只计条数，不计字节数
+	NILESTHUMP_LOG_BIN_INFO(logger, "player {} hp {}", id, hp);
+***************************************************/
+#define NILESTHUMP_LOG_BIN_LEVEL(logger, level, fmt, ...) \
+	NILESTHUMP_LOG_SITE_IF(logger, level) \
+		(nst_site.emit(0), (logger)->logBinary([]() -> GameProjectServer::LogBinarySite& { \
+			static GameProjectServer::LogBinarySite s_site(__FILE__, __LINE__, level, fmt); return s_site; }(), \
+			GameProjectServer::LogFormatString<GameProjectServer::LogFormatArgCount(fmt)>{ fmt }, ##__VA_ARGS__))
+
+#define NILESTHUMP_LOG_BIN_DEBUG(logger, fmt, ...) NILESTHUMP_LOG_BIN_LEVEL(logger, GameProjectServer::LogLevel::DEBUG, fmt, ##__VA_ARGS__)
+#define NILESTHUMP_LOG_BIN_INFO(logger, fmt, ...) NILESTHUMP_LOG_BIN_LEVEL(logger, GameProjectServer::LogLevel::INFO, fmt, ##__VA_ARGS__)
+#define NILESTHUMP_LOG_BIN_WARN(logger, fmt, ...) NILESTHUMP_LOG_BIN_LEVEL(logger, GameProjectServer::LogLevel::WARN, fmt, ##__VA_ARGS__)
+#define NILESTHUMP_LOG_BIN_ERROR(logger, fmt, ...) NILESTHUMP_LOG_BIN_LEVEL(logger, GameProjectServer::LogLevel::ERROR, fmt, ##__VA_ARGS__)
+#define NILESTHUMP_LOG_BIN_FATAL(logger, fmt, ...) NILESTHUMP_LOG_BIN_LEVEL(logger, GameProjectServer::LogLevel::FATAL, fmt, ##__VA_ARGS__)
+
+/***************************************************
+	限流的日志宏，每个调用点有自己的静态限流状态，
+	先判断级别，级别满足时才计入限流；
+	输出的日志末尾附上之前被丢弃的条数
+	NILESTHUMP_LOG_EVERY_N(logger, level, n)         每n条输出一条
+	NILESTHUMP_LOG_FIRST_N(logger, level, n)         只输出前n条
+	NILESTHUMP_LOG_EVERY_MS(logger, level, ms)       每ms毫秒最多一条
+	NILESTHUMP_LOG_RATE(logger, level, rate, burst)  令牌桶，每秒rate条，最多连续burst条
+	NILESTHUMP_LOG_EVERY_N(logger, LogLevel::ERROR, 1000) << "decode failed " << id;
+***************************************************/
+#define NILESTHUMP_LOG_LIMITED(logger, level, limiter) \
+	NILESTHUMP_LOG_SITE_IF(logger, level) \
+	if(static limiter; false) {} \
+	else if(uint64_t nst_suppressed = 0; !nst_limiter.allow(nst_suppressed)) {} else \
+		GameProjectServer::LogEventWrap(GameProjectServer::LogEvent::Acquire(logger, level,\
+		__FILE__, __LINE__, GameProjectServer::GetThreadId(), GameProjectServer::GetFiberId()), &nst_site, nst_suppressed).getSS()
+
+#define NILESTHUMP_LOG_EVERY_N(logger, level, n) \
+	NILESTHUMP_LOG_LIMITED(logger, level, GameProjectServer::LogEveryN nst_limiter(n))
+#define NILESTHUMP_LOG_FIRST_N(logger, level, n) \
+	NILESTHUMP_LOG_LIMITED(logger, level, GameProjectServer::LogFirstN nst_limiter(n))
+#define NILESTHUMP_LOG_EVERY_MS(logger, level, ms) \
+	NILESTHUMP_LOG_LIMITED(logger, level, GameProjectServer::LogEveryMs nst_limiter(ms))
+#define NILESTHUMP_LOG_RATE(logger, level, rate, burst) \
+	NILESTHUMP_LOG_LIMITED(logger, level, GameProjectServer::LogTokenBucket nst_limiter(rate, burst))
+
+/***************************************************
+	根日志器与按名称取日志器的宏
+	NILESTHUMP_LOG_ROOT与NILESTHUMP_LOG_GET_LOGGER_STATIC
+	在每个调用点缓存一个句柄，之后的调用只读一次静态变量；
+	日志器创建后不会被移除，句柄一直有效。
+	_STATIC只接受字符串字面量(与""拼接，其他参数编译失败)，
+	NILESTHUMP_LOG_GET_LOGGER每次查找注册表，用于运行期名称
+***************************************************/
+#define NILESTHUMP_LOG_ROOT() \
+	([]() -> const GameProjectServer::Logger::ptr& { \
+		static const GameProjectServer::Logger::ptr s_logger = GameProjectServer::LoggerMgr::GetInstance()->getRoot(); \
+		return s_logger; }())
 #define NILESTHUMP_LOG_GET_LOGGER(name) GameProjectServer::LoggerMgr::GetInstance()->getLogger(name)
+#define NILESTHUMP_LOG_GET_LOGGER_STATIC(name) \
+	([]() -> const GameProjectServer::Logger::ptr& { \
+		static const GameProjectServer::Logger::ptr s_logger = GameProjectServer::LoggerMgr::GetInstance()->getLogger("" name); \
+		return s_logger; }())
 
 namespace GameProjectServer
 {
 	class Logger;
 	class LoggerManager;
+	class BinaryLogAppender;
+	class LogFormatter;
+
+	//格式化后的日志行，引用计数，只读
+	using LogLine = std::shared_ptr<const LogBuffer>;
 
 	//日志级别
 	class LogLevel {
@@ -79,32 +229,156 @@ namespace GameProjectServer
 
 	//日志事件
 	class LogEvent {
+		friend class LogFormatter;
+		friend class RingBufferLogAppender;
 	public:
 		using ptr = std::shared_ptr<LogEvent>;
+		/***************************************************
+			elapse为进程运行时间(毫秒)；time_ns为UTC时间戳(纳秒)，
+			以前这里传入time(0)的秒数，调用者需乘以1000000000
+		***************************************************/
 		LogEvent(std::shared_ptr<Logger> logger, LogLevel::Level level, 
 			const char* file, uint32_t line, uint32_t elapse,
-			uint32_t thread_id, uint32_t fiber_id, std::u16streampos time);
+			uint32_t thread_id, uint32_t fiber_id, uint64_t time_ns);
+		//读取日志时钟作为时间戳与进程运行时间
+		LogEvent(std::shared_ptr<Logger> logger, LogLevel::Level level,
+			const char* file, uint32_t line, uint32_t thread_id, uint32_t fiber_id);
+
+		/***************************************************
+			从当前线程的对象池取出一个事件并初始化，
+			池为空时才分配新对象
+		***************************************************/
+		static LogEvent::ptr Acquire(const std::shared_ptr<Logger>& logger, LogLevel::Level level,
+			const char* file, uint32_t line, uint32_t thread_id, uint32_t fiber_id);
+		//没有其他持有者时放回当前线程的对象池
+		static void Recycle(LogEvent::ptr&& event);
 
 		const char* getFile() const { return m_file; }
 		uint32_t getLine() const { return m_line; }
-		uint32_t getElapse() const { return m_elapse; }
+		uint32_t getElapse() const { return static_cast<uint32_t>(m_elapse / 1000000); }
+		uint64_t getElapseNS() const { return m_elapse; }
 		uint32_t getThreadId() const { return m_threadId; }
 		uint32_t getFiberId() const { return m_fiberId; }
-		std::u16streampos getTime() const { return m_time; }
-		std::string getMessage() const { return m_ss.str(); }
-		std::stringstream& getSS() { return m_ss; }
-		std::shared_ptr<Logger> getLogger() const { return m_logger; }
+		//UTC时间戳(纳秒)，以前为秒
+		uint64_t getTime() const { return m_time; }
+		std::string getMessage() const { return m_ss.buffer().toString(); }
+		const LogBuffer& getMessageBuffer() const { return m_ss.buffer(); }
+		//编码后的结构化字段，用LogFieldsForEach遍历
+		const LogBuffer& getFieldsBuffer() const { return m_fields; }
+		LogStream& getSS() { return m_ss; }
+		const std::shared_ptr<Logger>& getLogger() const { return m_logger; }
 		LogLevel::Level getLevel() const { return m_level; }
-		void format(const char* fmt, ...);
+		void format(const char* fmt, ...) NST_PRINTF_FORMAT(2, 3);
 		void format(const char* fmt, va_list al);
+		//解码二进制日志时还原记录中的时间
+		void setTime(uint64_t time_ns, uint64_t elapse_ns) { m_time = time_ns; m_elapse = elapse_ns; }
+
+		/***************************************************
+			{}风格格式化，参数按类型直接写入消息缓冲区，
+			{{ 和 }} 输出花括号
+		***************************************************/
+		template<class... Args>
+		void print(const char* fmt, const Args&... args)
+		{
+			LogFormatTo(m_ss, fmt, args...);
+		}
+		template<size_t N, class... Args>
+		void print(LogFormatString<N> fmt, const Args&... args)
+		{
+			static_assert(N == sizeof...(Args), "log format placeholder count does not match arguments");
+			LogFormatTo(m_ss, fmt.str, args...);
+		}
+
+		/***************************************************
+			添加一个结构化字段，值按类型直接写入字段缓冲区：
+			整数、浮点数、布尔值与nullptr原样保存，
+			字符串保存原文，输出时按格式转义，
+			其他类型借用消息流的operator<<转成字符串
+		***************************************************/
+		template<class T>
+		LogEvent& kv(std::string_view key, const T& value)
+		{
+			using D = std::decay_t<T>;
+			size_t field;
+			if constexpr (std::is_same_v<D, std::nullptr_t>)
+			{
+				field = LogFieldBegin(m_fields, kLogFieldRaw, key);
+				m_fields.append("null", 4);
+			}
+			else if constexpr (std::is_same_v<D, bool>)
+			{
+				field = LogFieldBegin(m_fields, kLogFieldRaw, key);
+				m_fields.append(value ? "true" : "false");
+			}
+			else if constexpr (std::is_same_v<D, char>)
+			{
+				field = LogFieldBegin(m_fields, kLogFieldString, key);
+				m_fields.append(value);
+			}
+			else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>)
+			{
+				field = LogFieldBegin(m_fields, kLogFieldRaw, key);
+				m_fields.appendInt(value);
+			}
+			else if constexpr (std::is_integral_v<D>)
+			{
+				field = LogFieldBegin(m_fields, kLogFieldRaw, key);
+				m_fields.appendUInt(value);
+			}
+			else if constexpr (std::is_enum_v<D>)
+			{
+				field = LogFieldBegin(m_fields, kLogFieldRaw, key);
+				m_fields.appendInt(static_cast<int64_t>(value));
+			}
+			else if constexpr (std::is_floating_point_v<D>)
+			{
+				//nan与inf不是合法的JSON数字，按字符串输出
+				field = LogFieldBegin(m_fields, std::isfinite(value) ? kLogFieldRaw : kLogFieldString, key);
+				if constexpr (std::is_same_v<D, float>)
+				{
+					m_fields.appendFloat(value);
+				}
+				else
+				{
+					m_fields.appendDouble(static_cast<double>(value));
+				}
+			}
+			else if constexpr (std::is_convertible_v<const T&, const char*>)
+			{
+				const char* str = value;
+				field = LogFieldBegin(m_fields, str ? kLogFieldString : kLogFieldRaw, key);
+				m_fields.append(str ? str : "null");
+			}
+			else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+			{
+				std::string_view str = value;
+				field = LogFieldBegin(m_fields, kLogFieldString, key);
+				m_fields.append(str.data(), str.size());
+			}
+			else
+			{
+				field = LogFieldBegin(m_fields, kLogFieldString, key);
+				LogBuffer& msg = m_ss.buffer();
+				size_t pos = msg.size();
+				m_ss << value;
+				m_fields.append(msg.data() + pos, msg.size() - pos);
+				msg.truncate(pos);
+			}
+			LogFieldEnd(m_fields, field);
+			return *this;
+		}
 	private:
 		const char* m_file = nullptr;      //日志事件发生的文件
 		uint32_t m_line = 0;           //日志事件发生的行号
-		uint32_t m_elapse = 0;         //程序启动到现在的毫秒数
+		uint64_t m_elapse = 0;         //程序启动到现在的纳秒数
 		uint32_t m_threadId = 0;      //线程ID
 		uint32_t m_fiberId = 0;       //协程ID
-		std::u16streampos m_time;            //时间戳
-		std::stringstream m_ss;
+		uint64_t m_time = 0;          //时间戳(纳秒)
+		LogStream m_ss;                //消息内容
+		LogBuffer m_fields;            //结构化字段
+		LogBuffer m_text;              //格式化后的日志行
+		uint32_t m_textFormatter = 0;  //格式化m_text的格式器id，0为未格式化
+		LogLevel::Level m_textLevel = LogLevel::UNKNOW;   //格式化m_text时的级别
 
 		std::shared_ptr<Logger> m_logger;
 		LogLevel::Level m_level;
@@ -112,32 +386,82 @@ namespace GameProjectServer
 
 	class LogEventWrap {
 	public:
-		LogEventWrap(LogEvent::ptr e);
+		/***************************************************
+			site不为空时在调用点统计中计入这条日志，
+			suppressed不为0时在消息末尾附上被限流丢弃的条数
+		***************************************************/
+		LogEventWrap(LogEvent::ptr e, LogSite* site = nullptr, uint64_t suppressed = 0);
 		~LogEventWrap();
-		LogEvent::ptr getEvent() const { return m_event; }
-		std::stringstream& getSS() { return m_event->getSS(); }
+		const LogEvent::ptr& getEvent() const { return m_event; }
+		LogStream& getSS() { return m_event->getSS(); }
+		template<class T>
+		LogEventWrap& kv(std::string_view key, const T& value)
+		{
+			m_event->kv(key, value);
+			return *this;
+		}
 	private:
 		LogEvent::ptr m_event;
+		LogSite* m_site;
+		uint64_t m_suppressed;
 	};
 
 	//日志格式化器
 	class LogFormatter {
 	public:
 		using ptr = std::shared_ptr<LogFormatter>;
+		//日志器的默认格式
+		static constexpr const char* kDefaultPattern = "%d{%H:%M:%S %Y-%m-%d}%T%t%T%F%T[%p]%T[%c]%T<%f:%l>%T%m%n";
 		LogFormatter(const std::string& pattern);
 		/***************************************************
 			为appender提供event信息，返回格式化后的字符串
 			%t:时间		%threadid:线程号	%m:消息   
 			%p:日志级别		%n:换行符		%f:文件名
+			%r:启动后毫秒数	%R:启动后秒数(纳秒精度)	%N:纳秒时间戳
+			%d{...}中可使用strftime格式，另支持
+			%3N:毫秒	%6N:微秒	%9N(%N):纳秒
+			结构化输出：
+			%J:整条日志为一个JSON对象	%K:整条日志为一行logfmt
+			%k:结构化字段(logfmt)，可附在文本格式的消息后
+			%J{...}、%K{...}中的时间格式同%d，省略时输出纳秒时间戳
 		***************************************************/
 		std::string format(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event);
+		/***************************************************
+			按编译好的指令把格式化结果追加到buf末尾，
+			不经过iostream，复用buf时不分配内存
+		***************************************************/
+		void format(LogBuffer& buf, LogLevel::Level level, const LogEvent& event) const;
+		/***************************************************
+			格式化到事件自带的日志行缓冲区并返回，
+			多个appender共用同一格式器时，同一事件只格式化一次，
+			之后的appender直接取用结果
+		***************************************************/
+		const LogBuffer& render(LogLevel::Level level, LogEvent& event) const;
+		//同render，返回与事件共享引用计数的日志行，可在分发结束后继续持有
+		LogLine renderShared(LogLevel::Level level, const LogEvent::ptr& event) const;
 	public:
-		class FormatItem {
-		public:
-			using ptr = std::shared_ptr<FormatItem>;
-			virtual ~FormatItem() {}
-			virtual void format(std::ostream& os, std::shared_ptr<Logger> logger,
-				LogLevel::Level level, LogEvent::ptr event) = 0;
+		//格式化指令
+		enum Op : uint8_t {
+			LITERAL,        //字符串常量
+			MESSAGE,        //消息体
+			LEVEL,          //日志级别
+			ELAPSE,         //累计毫秒数
+			UPTIME,         //累计秒数，纳秒精度
+			TIMESTAMP,      //纳秒时间戳
+			NAME,           //日志名称
+			THREAD_ID,      //线程id
+			FIBER_ID,       //协程id
+			DATETIME,       //时间
+			FILENAME,       //文件名
+			LINE,           //行号
+			JSON,           //JSON对象
+			LOGFMT,         //logfmt
+			FIELDS          //结构化字段
+		};
+		struct Instruction {
+			Op op;
+			uint32_t offset;    //LITERAL: 在m_literals中的偏移	DATETIME/JSON/LOGFMT: m_dateTimes下标
+			uint32_t length;    //LITERAL: 常量长度
 		};
 
 		void init();
@@ -146,9 +470,23 @@ namespace GameProjectServer
 
 		const std::string getPattern() const { return m_pattern; }
 	private:
+		class DateTimeFormatItem;
+
+		void addLiteral(const std::string& str);
+		//JSON与logfmt的整行输出，date_time为kNoDateTime时输出纳秒时间戳
+		void formatJson(LogBuffer& buf, LogLevel::Level level, const LogEvent& event, uint32_t date_time) const;
+		void formatLogfmt(LogBuffer& buf, LogLevel::Level level, const LogEvent& event, uint32_t date_time) const;
+		//时间格式化到线程局部的缓冲区，转义后再写入
+		const LogBuffer& formatDateTime(uint32_t date_time, uint64_t time) const;
+	private:
+		static constexpr uint32_t kNoDateTime = UINT32_MAX;
+
 		std::string m_pattern;                      //日志格式模板
-		std::vector<FormatItem::ptr> m_items; //日志格式化规则集合
+		std::vector<Instruction> m_instructions;    //编译后的格式化指令
+		std::string m_literals;                     //所有字符串常量
+		std::vector<std::shared_ptr<DateTimeFormatItem>> m_dateTimes;   //%d{...}时间格式
 		bool m_error = false;                       //解析日志格式失败标志
+		uint32_t m_id;                              //格式器id，标识事件中已格式化的日志行
 	};
 
 
@@ -156,6 +494,7 @@ namespace GameProjectServer
 	class LogAppender 
 	{
 		friend class Logger;
+		friend class RingBufferLogAppender;
 	public:
 		using ptr = std::shared_ptr<LogAppender>;
 
@@ -163,17 +502,118 @@ namespace GameProjectServer
 		//虚析构函数，确保派生类正确析构
 		virtual ~LogAppender() {}
 		virtual void log(std::shared_ptr<Logger> logger,LogLevel::Level level, LogEvent::ptr event) = 0;
-		void setLevel(LogLevel::Level level) { m_level = level; }
+		//写出缓冲的日志，没有缓冲的appender不需要实现
+		virtual void flush() {}
+		void setLevel(LogLevel::Level level);
 		LogLevel::Level getLevel() const { return m_level; }
+		//任一appender修改级别时递增，日志器据此判断分发表是否过期
+		static uint64_t GetLevelGeneration();
 
 		void setFormatter(LogFormatter::ptr formatter);
-		LogFormatter::ptr getFormatter() const { return m_formatter; }
+		LogFormatter::ptr getFormatter() const;
 
 		virtual std::string toYamlString() = 0;
+	protected:
+		/***************************************************
+			输出时读取格式器，不增加引用计数；
+			须在LogEpoch临界区内使用(日志器分发时已进入)，
+			被替换的格式器在所有临界区退出后才释放
+		***************************************************/
+		LogFormatter* formatter() const { return m_formatterPtr.load(std::memory_order_acquire); }
+	private:
+		//日志器为没有自己格式器的appender设置格式器
+		void inheritFormatter(const LogFormatter::ptr& formatter);
+		//调用者持有m_formatterMutex
+		void publishFormatter(LogFormatter::ptr formatter);
 	protected:
 		LogLevel::Level m_level;               //日志输出级别
 		bool m_hasFormatter;           //是否有自己的日志格式器
+	private:
+		mutable std::mutex m_formatterMutex;    //修改格式器的互斥量
 		LogFormatter::ptr m_formatter; //日志格式化器
+		std::atomic<LogFormatter*> m_formatterPtr{ nullptr };   //供输出时无锁读取
+	};
+
+	//日志队列溢出策略
+	class LogOverflowPolicy {
+	public:
+		enum Policy {
+			BLOCK = 0,              //队列满时阻塞等待
+			DROP_NEWEST = 1,        //队列满时丢弃新日志
+			DROP_BELOW_LEVEL = 2    //队列满时丢弃低于指定级别的日志，其余阻塞
+		};
+		static Policy FromString(const std::string& str);
+		static const char* ToString(Policy policy);
+	};
+
+	/***************************************************
+		日志器的异步事件队列
+		生产者把LogEvent放入无锁环形队列后立即返回，
+		由写线程取出后交给日志器的appender输出，
+		appender只会在写线程中被访问
+	***************************************************/
+	class LogEventQueue {
+	public:
+		LogEventQueue(Logger* logger, size_t capacity);
+		~LogEventQueue();
+
+		//按溢出策略入队，返回false表示日志被丢弃
+		bool push(LogLevel::Level level, LogEvent::ptr&& event);
+
+		void start();
+		//停止写线程，停止后仍留在队列中的日志由调用线程输出
+		void stop();
+
+		void setPolicy(LogOverflowPolicy::Policy policy, LogLevel::Level drop_level);
+		LogOverflowPolicy::Policy getPolicy() const { return (LogOverflowPolicy::Policy)m_policy.load(std::memory_order_relaxed); }
+		LogLevel::Level getDropLevel() const { return (LogLevel::Level)m_dropLevel.load(std::memory_order_relaxed); }
+
+		size_t getCapacity() const { return m_queue.capacity(); }
+		size_t getSize() const { return m_queue.size(); }
+		//按capacity创建的队列的实际容量
+		static size_t RoundCapacity(size_t capacity) { return MPSCQueue<Item>::RoundCapacity(capacity); }
+		uint64_t getDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+		uint64_t getBlockedCount() const { return m_blocked.load(std::memory_order_relaxed); }
+	private:
+		using Item = std::pair<LogLevel::Level, LogEvent::ptr>;
+
+		void notify();
+		void run();
+	private:
+		Logger* m_logger;                           //所属日志器
+		MPSCQueue<Item> m_queue;                    //事件环形队列
+		std::atomic<int> m_policy{ LogOverflowPolicy::BLOCK };  //溢出策略
+		std::atomic<int> m_dropLevel{ LogLevel::WARN };         //DROP_BELOW_LEVEL时的保留级别
+		std::atomic<uint64_t> m_dropped{ 0 };       //因队列满被丢弃的日志数
+		std::atomic<uint64_t> m_blocked{ 0 };       //因队列满而阻塞的入队次数
+
+		std::atomic<bool> m_running{ false };
+		std::atomic<bool> m_waiting{ false };       //写线程是否在等待新日志
+		std::mutex m_mutex;
+		std::condition_variable m_cond;
+		std::thread m_thread;                       //写线程
+	};
+
+	/***************************************************
+		日志器配置快照
+		级别、格式器、appender集合与按级别的分发表一起发布，
+		发布后只读；修改配置时复制一份，修改后原子替换，
+		旧快照由LogEpoch在读者全部退出后释放
+	***************************************************/
+	struct LoggerState
+	{
+		LogLevel::Level level = LogLevel::DEBUG;    //日志器级别
+		LogFormatter::ptr formatter;                //日志格式器
+		std::vector<LogAppender::ptr> appenders;    //日志输出地集合
+		/***************************************************
+			按级别预先筛选的appender，dispatch[level]为
+			接受该级别的appender，分发时只遍历对应的连续数组；
+			appender加入后被修改级别时分发表过期，
+			分发时回退为遍历全部appender并重新发布快照
+		***************************************************/
+		std::vector<LogAppender*> dispatch[LogLevel::FATAL + 1];
+		uint64_t generation = 0;                    //建立分发表时的appender级别版本
+		std::vector<std::shared_ptr<BinaryLogAppender>> binaryAppenders;  //二进制日志输出地
 	};
 
 	//日志器
@@ -184,6 +624,7 @@ namespace GameProjectServer
 		using ptr = std::shared_ptr<Logger>;
 
 		Logger(const std::string& name = "root");
+		~Logger();
 
 		void log(LogLevel::Level level, LogEvent::ptr event);
 
@@ -196,8 +637,18 @@ namespace GameProjectServer
 		void addAppender(LogAppender::ptr appender);
 		void delAppender(LogAppender::ptr appender);
 		void clearAppenders();
-		LogLevel::Level getLevel() const { return m_level; }
-		void setLevel(LogLevel::Level level) { m_level = level; }
+		std::vector<LogAppender::ptr> getAppenders() const;
+		/***************************************************
+			一次性替换级别、格式器与appender集合，
+			其他线程只会看到修改前或修改后的完整配置，
+			formatter为空时保留原格式器
+		***************************************************/
+		void reconfigure(LogLevel::Level level, LogFormatter::ptr formatter,
+			const std::vector<LogAppender::ptr>& appenders);
+		LogLevel::Level getLevel() const { return m_level.load(std::memory_order_relaxed); }
+		void setLevel(LogLevel::Level level);
+		//日志宏的运行期判断，只做一次relaxed读
+		bool isEnabled(LogLevel::Level level) const { return level >= m_level.load(std::memory_order_relaxed); }
 
 		const std::string& getName() const { return m_name; }
 
@@ -206,13 +657,193 @@ namespace GameProjectServer
 
 		LogFormatter::ptr getFormatter() const;
 
+		/***************************************************
+			切换为异步输出，日志事件经无锁队列交给写线程
+			capacity与当前队列不同时先切换回同步输出再换新队列，
+			策略可随时修改；写线程运行期间持有日志器，需调用setSync释放
+		***************************************************/
+		void setAsync(size_t capacity, LogOverflowPolicy::Policy policy = LogOverflowPolicy::BLOCK,
+			LogLevel::Level drop_level = LogLevel::WARN);
+		//切换回同步输出，等待写线程写完队列中的日志
+		void setSync();
+		bool isAsync() const { return m_async.load(std::memory_order_relaxed); }
+
+		uint64_t getDroppedCount() const;
+		uint64_t getBlockedCount() const;
+
+		/***************************************************
+			二进制日志宏的入口
+			有BinaryLogAppender时只把二进制记录交给它们，
+			其余appender不接收这条日志；
+			没有时按{}格式化为文本日志正常输出
+		***************************************************/
+		template<size_t N, class... Args>
+		void logBinary(LogBinarySite& site, LogFormatString<N> fmt, const Args&... args)
+		{
+			static_assert(N == sizeof...(Args), "log format placeholder count does not match arguments");
+			if (!m_hasBinary.load(std::memory_order_relaxed))
+			{
+				LogEventWrap(LogEvent::Acquire(shared_from_this(), static_cast<LogLevel::Level>(site.level),
+					site.file, site.line, GetThreadId(), GetFiberId())).getEvent()->print(fmt.str, args...);
+				return;
+			}
+			uint32_t id = site.id.load(std::memory_order_acquire);
+			if (id == 0)
+			{
+				static constexpr uint8_t types[] = { LogBinaryArgType<Args>()..., 0 };
+				id = LogBinaryRegisterSite(site, types, sizeof...(Args));
+			}
+			LogBuffer& buf = LogBinaryThreadBuffer();
+			LogBinaryBeginEvent(buf, id, getBinaryId());
+			LogBinaryEncode(buf, args...);
+			writeBinary(static_cast<LogLevel::Level>(site.level), id, buf);
+		}
+
+		//日志器在二进制日志中的id，首次使用时注册
+		uint32_t getBinaryId();
+
 		std::string toYamlString();
+	private:
+		void writeBinary(LogLevel::Level level, uint32_t site, const LogBuffer& record);
+		//停止写线程并切换回同步输出，调用者持有m_mutex
+		void stopQueue();
+		//复制当前快照，调用者持有m_mutex
+		std::unique_ptr<LoggerState> copyState() const;
+		//重建分发表后发布新快照，旧快照交给LogEpoch回收，调用者持有m_mutex
+		void publish(std::unique_ptr<LoggerState> state);
+		//将事件交给appender输出，没有appender时交给根日志器
+		void dispatch(LogLevel::Level level, LogEvent::ptr event);
+		friend class LogEventQueue;
 	private:
 		std::string m_name;                        //日志器名称
-		LogLevel::Level m_level;                         //日志器级别
-		std::list<LogAppender::ptr> m_appenders; //日志输出地集合
-		LogFormatter::ptr m_formatter;       //日志格式器
+		std::atomic<LogLevel::Level> m_level;            //日志器级别，与快照中的相同，供日志宏无锁读取
+		std::atomic<LoggerState*> m_state{ nullptr };   //当前配置快照，读者在LogEpoch临界区内访问
+		mutable std::mutex m_mutex;                //修改配置的写者互斥，读者不加锁
+		std::atomic<bool> m_hasBinary{ false };    //快照中是否有二进制日志输出地
 		Logger::ptr m_root = nullptr;                         //根日志器
+		std::atomic<bool> m_async{ false };        //是否异步输出
+		std::unique_ptr<LogEventQueue> m_queue;    //异步事件队列，由m_mutex保护；日志线程在m_async为true时无锁读取
+		std::atomic<uint32_t> m_binaryId{ 0 };     //二进制日志中的日志器id
+	};
+
+	/***************************************************
+		日志刷新策略，满足任一条件即写出缓冲区：
+			newline     每条日志(换行)后写出
+			bytes       缓冲数据达到bytes字节，0为缓冲区写满
+			interval    数据停留超过interval毫秒，0为不限
+			level       日志级别不低于level，UNKNOW为不限
+	***************************************************/
+	struct LogFlushPolicy
+	{
+		bool newline = false;
+		size_t bytes = 0;
+		uint32_t interval = 100;
+		LogLevel::Level level = LogLevel::ERROR;
+
+		bool operator==(const LogFlushPolicy& oth) const
+		{
+			return newline == oth.newline
+				&& bytes == oth.bytes
+				&& interval == oth.interval
+				&& level == oth.level;
+		}
+		//该级别的日志写入后是否立即写出
+		bool flushOn(LogLevel::Level lv) const
+		{
+			return newline || (level != LogLevel::UNKNOW && lv >= level);
+		}
+	};
+
+	/***************************************************
+		合并连续的重复日志
+		同一调用点、同一级别、消息哈希相同的日志与上一条重复时只计数，
+		不格式化也不写入；出现不同的日志、重复持续超过interval毫秒
+		或flush时写出一行"last message repeated N times"
+	***************************************************/
+	class LogRepeatFilter
+	{
+	public:
+		static constexpr uint32_t kDefaultInterval = 1000;
+
+		//0为不合并
+		void setInterval(uint32_t interval) { m_interval.store(interval, std::memory_order_relaxed); }
+		uint32_t getInterval() const { return m_interval.load(std::memory_order_relaxed); }
+		uint64_t getRepeatedCount() const { return m_total.load(std::memory_order_relaxed); }
+
+		//不重复时调用render格式化后写入writer，writer为LogFileWriter或LogGzipWriter
+		template<class Writer, class Render>
+		void write(Writer& writer, LogLevel::Level level, const LogEvent& event, bool flush, Render&& render)
+		{
+			uint64_t interval = m_interval.load(std::memory_order_relaxed) * 1000000ULL;
+			if (!interval)
+			{
+				const LogBuffer& line = render();
+				writer.write(line.data(), line.size(), flush);
+				return;
+			}
+			//结构化字段不同的日志也不合并
+			const LogBuffer& msg = event.getMessageBuffer();
+			const LogBuffer& fields = event.getFieldsBuffer();
+			size_t hash = std::hash<std::string_view>()(std::string_view(msg.data(), msg.size()));
+			if (!fields.empty())
+			{
+				hash ^= std::hash<std::string_view>()(std::string_view(fields.data(), fields.size()))
+					+ static_cast<size_t>(0x9e3779b97f4a7c15ULL) + (hash << 6) + (hash >> 2);
+			}
+			uint64_t now = event.getElapseNS();
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (hash == m_hash && event.getLine() == m_line && event.getFile() == m_file && level == m_lastLevel)
+			{
+				++m_repeated;
+				m_total.fetch_add(1, std::memory_order_relaxed);
+				//重复持续时定期写出计数
+				if (now - m_since >= interval)
+				{
+					writeRepeated(writer, flush);
+					m_since = now;
+				}
+				return;
+			}
+			writeRepeated(writer, false);
+			m_file = event.getFile();
+			m_line = event.getLine();
+			m_lastLevel = level;
+			m_hash = hash;
+			m_since = now;
+			const LogBuffer& line = render();
+			writer.write(line.data(), line.size(), flush);
+		}
+
+		//写出尚未输出的重复计数
+		template<class Writer>
+		void flush(Writer& writer)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			writeRepeated(writer, false);
+		}
+	private:
+		template<class Writer>
+		void writeRepeated(Writer& writer, bool flush)
+		{
+			if (m_repeated)
+			{
+				char buf[64];
+				int len = snprintf(buf, sizeof(buf), "last message repeated %llu times\n",
+					static_cast<unsigned long long>(m_repeated));
+				writer.write(buf, len, flush);
+				m_repeated = 0;
+			}
+		}
+	private:
+		std::atomic<uint32_t> m_interval{ 0 };  //合并间隔(毫秒)
+		std::atomic<uint64_t> m_total{ 0 };     //合并掉的日志总数
+		std::mutex m_mutex;
+		const char* m_file = nullptr;           //上一条日志的调用点
+		uint32_t m_line = 0;
+		LogLevel::Level m_lastLevel = LogLevel::UNKNOW;
+		size_t m_hash = 0;                      //上一条日志消息与字段的哈希
+		uint64_t m_since = 0;                   //开始计数的时间
+		uint64_t m_repeated = 0;                //尚未写出的重复次数
 	};
 
 	//输出到控制台的日志输出地
@@ -221,10 +852,24 @@ namespace GameProjectServer
 		friend class Logger;
 	public:
 		using ptr = std::shared_ptr<StdoutLogAppender>;
+		StdoutLogAppender(size_t buffer_size = LogFileWriter::kDefaultBufferSize);
+		~StdoutLogAppender();
 		virtual void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override;
 		std::string toYamlString() override;
-	private:
 
+		void setFlushPolicy(const LogFlushPolicy& policy);
+		const LogFlushPolicy& getFlushPolicy() const { return m_flushPolicy; }
+		void flush() override { m_repeat.flush(*m_writer); m_writer->flush(); }
+		const LogFileWriter::ptr& getWriter() const { return m_writer; }
+
+		//合并连续重复日志的间隔(毫秒)，0为不合并
+		void setCoalesce(uint32_t interval) { m_repeat.setInterval(interval); }
+		uint32_t getCoalesce() const { return m_repeat.getInterval(); }
+		uint64_t getCoalescedCount() const { return m_repeat.getRepeatedCount(); }
+	private:
+		LogFlushPolicy m_flushPolicy;   //刷新策略
+		LogFileWriter::ptr m_writer;    //带缓冲的标准输出
+		LogRepeatFilter m_repeat;       //重复日志合并
 	};
 
 	//输出到文件的日志输出地
@@ -233,30 +878,412 @@ namespace GameProjectServer
 		friend class Logger;
 	public:
 		using ptr = std::shared_ptr<FileLogAppender>;
-		FileLogAppender(const std::string& filename);
+		/***************************************************
+			compress.enabled为true时按块gzip压缩后写入，
+			压缩在后台线程中进行，压缩器初始化失败时不压缩；
+			index_interval不为0时每约index_interval字节
+			在filename.idx中记录一块的时间范围与最高级别，
+			供logseek按时间与级别查找，压缩的文件不写索引
+		***************************************************/
+		FileLogAppender(const std::string& filename, size_t buffer_size = LogFileWriter::kDefaultBufferSize,
+			const LogCompressPolicy& compress = LogCompressPolicy(), uint32_t index_interval = 0);
+		~FileLogAppender();
 		virtual void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override;
 
-		//重新打开文件，文件打开失败返回false
+		//以追加方式重新打开文件，文件打开失败返回false
 		bool reopen();
 
+		void setFlushPolicy(const LogFlushPolicy& policy);
+		const LogFlushPolicy& getFlushPolicy() const { return m_flushPolicy; }
+		void flush() override;
+		const LogFileWriter::ptr& getWriter() const { return m_writer; }
+		//不压缩时为空
+		const LogGzipWriter::ptr& getGzipWriter() const { return m_gzip; }
+		LogCompressPolicy getCompressPolicy() const { return m_gzip ? m_gzip->getPolicy() : LogCompressPolicy(); }
+		//不写索引时为空
+		const LogFileIndex::ptr& getIndex() const { return m_index; }
+
+		//合并连续重复日志的间隔(毫秒)，0为不合并
+		void setCoalesce(uint32_t interval) { m_repeat.setInterval(interval); }
+		uint32_t getCoalesce() const { return m_repeat.getInterval(); }
+		uint64_t getCoalescedCount() const { return m_repeat.getRepeatedCount(); }
+
+		//按长度与时间轮转日志文件，在后台线程中完成；写索引时不轮转
+		void setRotatePolicy(const LogRotatePolicy& policy);
+		LogRotatePolicy getRotatePolicy() const { return m_writer->getRotatePolicy(); }
+
 		std::string toYamlString() override;
 	private:
 		std::string m_filename;    //日志文件名
-		std::ofstream m_filestream; //文件输出流
+		LogFlushPolicy m_flushPolicy;   //刷新策略
+		LogFileWriter::ptr m_writer;    //带缓冲的文件写入
+		LogGzipWriter::ptr m_gzip;      //分块压缩，写入m_writer
+		LogFileIndex::ptr m_index;      //旁路索引，写入m_writer
+		LogRepeatFilter m_repeat;       //重复日志合并
 	};
 
+	/***************************************************
+		写入内存映射段文件的日志输出地
+		格式化后的日志直接复制到映射内存并推进段头的提交偏移，
+		不经过用户态缓冲区，进程崩溃时已写入的日志由内核写回；
+		段写满后新建下一个段，段文件名为file.序号，
+		序号接在已有的段之后递增，用LogMmapSegment::Read读取
+	***************************************************/
+	class MmapLogAppender : public LogAppender
+	{
+		friend class Logger;
+	public:
+		using ptr = std::shared_ptr<MmapLogAppender>;
+		static constexpr uint64_t kDefaultSegmentSize = 64 * 1024 * 1024;
+
+		MmapLogAppender(const std::string& filename, uint64_t segment_size = kDefaultSegmentSize);
+		virtual void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override;
+
+		//请求内核异步写回当前段，只在需要防止断电丢失时使用
+		void flush() override;
+
+		uint64_t getSegmentSize() const { return m_segmentSize; }
+		//当前段的序号，0为还没有段
+		uint64_t getSegmentIndex();
+		std::string getSegmentName(uint64_t index) const { return m_filename + "." + std::to_string(index); }
+		//段文件创建失败而丢弃的日志数
+		uint64_t getDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+		std::string toYamlString() override;
+	private:
+		//新建下一个段，调用者持有m_mutex
+		bool roll();
+	private:
+		std::string m_filename;         //段文件名前缀
+		uint64_t m_segmentSize;         //段文件大小(含文件头)
+		uint64_t m_lastIndex = 0;       //最后一个段的序号
+		std::mutex m_mutex;
+		LogMmapSegment::ptr m_segment;  //当前段
+		std::atomic<uint64_t> m_dropped{ 0 };
+	};
+
+	/***************************************************
+		飞行记录器日志输出地
+		每个线程保留最近capacity条日志的原始信息(不格式化)，
+		收到不低于dump_level的日志，或调用InstallSignalHandler后
+		进程收到致命信号时，把各线程的记录按时间顺序交给
+		目标appender输出并清空。通常日志器级别设为DEBUG，
+		其他appender设为INFO，DEBUG日志只进入本appender；
+		消息超过kMessageSize字节的部分被截断。
+		线程退出后它的记录保留，记录环由之后的线程复用；
+		写入记录不加锁，输出时丢弃正在被覆盖的记录
+	***************************************************/
+	class RingBufferLogAppender : public LogAppender
+	{
+		friend class Logger;
+	public:
+		using ptr = std::shared_ptr<RingBufferLogAppender>;
+		static constexpr size_t kDefaultCapacity = 256;
+		static constexpr size_t kMessageSize = 256;
+		static constexpr size_t kSignalBufferSize = 64 * 1024;
+
+		//target没有格式器时借用本appender的格式器，不改变target的配置
+		RingBufferLogAppender(LogAppender::ptr target, size_t capacity = kDefaultCapacity,
+			LogLevel::Level dump_level = LogLevel::ERROR);
+		~RingBufferLogAppender();
+		virtual void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override;
+		void flush() override { m_target->flush(); }
+
+		//把各线程的记录按时间顺序交给目标appender输出后清空
+		void dump();
+		/***************************************************
+			为SIGSEGV、SIGABRT等致命信号安装处理函数，先输出
+			所有RingBufferLogAppender的记录，再交还给之前安装的
+			处理函数(没有时按默认方式处理)。信号处理中不等待锁、
+			不使用格式器，记录在预先分配的缓冲区中按固定格式输出：
+			时间(微秒，本地时区偏移取自安装时或上次正常输出时)、
+			线程、协程、级别、日志器、文件:行号、消息，以制表符分隔；
+			不经过目标appender，直接写入目标的文件或标准输出，
+			目标是其他appender或文件被占用时写到标准错误
+		***************************************************/
+		static void InstallSignalHandler();
+
+		size_t getCapacity() const { return m_capacity; }
+		LogLevel::Level getDumpLevel() const { return m_dumpLevel; }
+		const LogAppender::ptr& getTarget() const { return m_target; }
+		uint64_t getDumpCount() const { return m_dumps.load(std::memory_order_relaxed); }
+		//已创建的记录环数，退出线程的记录环由之后的线程复用
+		size_t getRingCount();
+
+		std::string toYamlString() override;
+	private:
+		struct Record;
+		struct Ring;
+
+		//当前线程的记录环，首次使用时创建或复用
+		Ring* getRing();
+		/***************************************************
+			把各线程的记录复制到m_scratch并按时间排序，返回条数，
+			调用者持有m_dumpMutex；in_signal为true时只尝试加锁
+		***************************************************/
+		size_t collect(bool in_signal);
+		//信号处理中按固定格式输出，不分配内存、不等待锁、不调用localtime
+		void dumpInSignal();
+		static void DumpAll();
+	private:
+		LogAppender::ptr m_target;          //输出记录的appender
+		LogFileWriter::ptr m_signalWriter;  //信号处理中写入的目标文件，为空时写标准错误
+		size_t m_capacity;                  //每个线程保留的日志条数
+		LogLevel::Level m_dumpLevel;        //触发输出的日志级别
+		uint64_t m_id;                      //线程局部缓存中标识本appender
+		std::mutex m_mutex;                 //保护m_rings，写入记录时不使用
+		std::vector<std::shared_ptr<Ring>> m_rings;     //各线程的记录
+		std::mutex m_dumpMutex;             //同一时间只有一个线程输出，保护以下输出用的缓冲区
+		std::vector<Record> m_scratch;      //输出时复制的记录，创建记录环时扩容，输出时不再分配
+		std::vector<Record*> m_order;       //按时间排序的m_scratch
+		LogBuffer m_signalBuffer;           //信号处理中格式化的日志，容量预先分配
+		std::atomic<uint64_t> m_dumps{ 0 }; //输出次数
+	};
+
+	/***************************************************
+		异步输出到文件的日志输出地
+		生产者线程只负责格式化并追加到前台缓冲区，
+		后台线程交换缓冲区后将写满的缓冲区写入文件
+	***************************************************/
+	class AsyncLogAppender : public LogAppender
+	{
+		friend class Logger;
+	public:
+		using ptr = std::shared_ptr<AsyncLogAppender>;
+		static constexpr size_t kDefaultBufferSize = 4 * 1024 * 1024;
+		static constexpr uint32_t kDefaultFlushInterval = 1000;
+		static constexpr size_t kMaxPendingBuffers = 16;
+
+		AsyncLogAppender(const std::string& filename, size_t buffer_size = kDefaultBufferSize,
+			uint32_t flush_interval = kDefaultFlushInterval);
+		~AsyncLogAppender();
+		virtual void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override;
+
+		//唤醒后台线程，立即写出前台缓冲区
+		void flush() override;
+
+		size_t getBufferSize() const { return m_bufferSize; }
+		uint32_t getFlushInterval() const { return m_flushInterval; }
+
+		uint64_t getQueuedBytes() const { return m_queuedBytes.load(std::memory_order_relaxed); }
+		uint64_t getDroppedBytes() const { return m_droppedBytes.load(std::memory_order_relaxed); }
+		uint64_t getFlushedBytes() const { return m_flushedBytes.load(std::memory_order_relaxed); }
+
+		std::string toYamlString() override;
+	protected:
+		//mode为后台线程打开文件的方式，总是追加到已有文件末尾，热更新重建appender时不清空文件
+		AsyncLogAppender(const std::string& filename, size_t buffer_size,
+			uint32_t flush_interval, std::ios_base::openmode mode);
+
+		void append(const char* msg, size_t len);
+		//调用者已持有m_mutex，缓冲区积压丢弃时返回false
+		bool appendLocked(const char* msg, size_t len);
+	private:
+		using Buffer = std::string;
+		using BufferPtr = std::unique_ptr<Buffer>;
+
+		void run();
+	protected:
+		std::string m_filename;             //日志文件名
+		size_t m_bufferSize;                //单个缓冲区大小(字节)
+		uint32_t m_flushInterval;           //后台刷新间隔(毫秒)
+		std::ios_base::openmode m_openMode; //文件打开方式
+
+		std::mutex m_mutex;
+	private:
+		std::condition_variable m_cond;
+		BufferPtr m_current;                //前台缓冲区
+		BufferPtr m_next;                   //预备缓冲区
+		std::vector<BufferPtr> m_buffers;   //已写满待写出的缓冲区
+		bool m_running = false;
+		bool m_flushRequested = false;
+		std::thread m_thread;               //后台写线程
+
+		std::atomic<uint64_t> m_queuedBytes{ 0 };   //已进入缓冲区的字节数
+		std::atomic<uint64_t> m_droppedBytes{ 0 };  //缓冲区积压时丢弃的字节数
+		std::atomic<uint64_t> m_flushedBytes{ 0 };  //已写入文件的字节数
+	};
+
+	/***************************************************
+		二进制日志输出地
+		接收二进制日志宏的记录，经AsyncLogAppender的
+		双缓冲由后台线程写入文件，调用点与日志器的定义
+		在文件中首次出现时写出；普通日志事件以TEXT记录写出
+	***************************************************/
+	class BinaryLogAppender : public AsyncLogAppender
+	{
+		friend class Logger;
+	public:
+		using ptr = std::shared_ptr<BinaryLogAppender>;
+
+		BinaryLogAppender(const std::string& filename, size_t buffer_size = kDefaultBufferSize,
+			uint32_t flush_interval = kDefaultFlushInterval);
+		virtual void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override;
+
+		std::string toYamlString() override;
+	private:
+		//写出一条记录，site为0表示记录不引用调用点
+		void appendRecord(uint32_t site, uint32_t logger, const LogBuffer& record);
+		//定义未写出过时写入buf并返回true
+		bool defineSite(LogBuffer& buf, uint32_t site);
+		bool defineLogger(LogBuffer& buf, uint32_t logger);
+	private:
+		std::vector<bool> m_sites;      //已写出定义的调用点
+		std::vector<bool> m_loggers;    //已写出定义的日志器
+	};
+
+	/***************************************************
+		按时间合并各线程缓冲区的日志输出地
+		每个线程格式化后写入自己独占的单生产者环形缓冲区，
+		热路径上没有读-改-写原子操作，也不与其他线程共享缓存行；
+		后台线程定期取出所有缓冲区的日志，按时间戳合并后写入文件。
+		早于当前时间flush_interval的日志才会写出，
+		线程在取时间戳与写入缓冲区之间停顿超过该时间时可能乱序
+	***************************************************/
+	class MergeLogAppender : public LogAppender
+	{
+		friend class Logger;
+	public:
+		using ptr = std::shared_ptr<MergeLogAppender>;
+		static constexpr size_t kDefaultBufferSize = 1024 * 1024;
+		static constexpr uint32_t kDefaultFlushInterval = 100;
+
+		//buffer_size为每个线程的缓冲区大小
+		MergeLogAppender(const std::string& filename, size_t buffer_size = kDefaultBufferSize,
+			uint32_t flush_interval = kDefaultFlushInterval);
+		~MergeLogAppender();
+		virtual void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override;
+
+		//写出所有已进入缓冲区的日志，返回时已写入文件
+		void flush() override;
+
+		size_t getBufferSize() const { return m_bufferSize; }
+		uint32_t getFlushInterval() const { return m_flushInterval; }
+		//已创建的线程缓冲区数，退出线程的缓冲区由之后的线程复用
+		size_t getBufferCount();
+		//缓冲区已满时丢弃的日志数
+		uint64_t getDroppedCount();
+		uint64_t getWrittenCount() const { return m_written.load(std::memory_order_relaxed); }
+
+		std::string toYamlString() override;
+	private:
+		struct Buffer;
+
+		//当前线程的缓冲区，首次使用时创建或复用
+		Buffer* getBuffer();
+		void run();
+	private:
+		std::string m_filename;             //日志文件名
+		size_t m_bufferSize;                //每个线程的缓冲区大小(字节)
+		uint32_t m_flushInterval;           //合并间隔(毫秒)
+		uint64_t m_id;                      //线程局部缓存中标识本appender
+
+		std::mutex m_mutex;
+		std::condition_variable m_cond;
+		std::condition_variable m_flushCond;
+		std::vector<std::shared_ptr<Buffer>> m_buffers;     //各线程的缓冲区
+		bool m_running = false;
+		uint64_t m_flushRequest = 0;        //请求写出的次数
+		uint64_t m_flushDone = 0;           //已完成的写出请求
+		std::thread m_thread;               //后台合并线程
+
+		std::atomic<uint64_t> m_written{ 0 };   //已写入文件的日志数
+	};
+
+	/***************************************************
+		写入共享内存通道的日志输出地
+		同一台机器上的多个进程各自占用通道的一个槽，
+		格式化后的日志写入槽的环形缓冲区后立即返回，
+		由唯一的收集进程(tools/logcollect)按时间顺序写入文件；
+		没有空闲槽或环形缓冲区已满时日志被丢弃并计数
+	***************************************************/
+	class ShmLogAppender : public LogAppender
+	{
+		friend class Logger;
+	public:
+		using ptr = std::shared_ptr<ShmLogAppender>;
+
+		//通道已存在时沿用它的槽数与大小
+		ShmLogAppender(const std::string& channel, uint32_t slot_count = LogShmChannel::kDefaultSlotCount,
+			uint64_t ring_size = LogShmChannel::kDefaultRingSize);
+		//归还槽，尚未取出的日志仍由收集进程写出
+		~ShmLogAppender();
+		virtual void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override;
+
+		const std::string& getChannelName() const { return m_channelName; }
+		const LogShmChannel::ptr& getChannel() const { return m_channel; }
+		//占用的槽，-1为没有
+		int32_t getSlot() const { return m_slot; }
+		//本appender丢弃的日志数
+		uint64_t getDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+		std::string toYamlString() override;
+	private:
+		std::string m_channelName;          //通道名称
+		uint32_t m_slotCount;               //创建通道时的槽数
+		uint64_t m_ringSize;                //创建通道时每个槽的字节数
+		LogShmChannel::ptr m_channel;
+		int32_t m_slot = -1;
+		std::atomic<uint64_t> m_dropped{ 0 };
+	};
+
+	/***************************************************
+		二进制日志解码器
+		读取BinaryLogAppender写出的文件，
+		按给定的LogFormatter还原为文本
+	***************************************************/
+	class BinaryLogDecoder
+	{
+	public:
+		BinaryLogDecoder(LogFormatter::ptr formatter);
+
+		//解码到输入结束，遇到格式错误或不完整的记录时返回false
+		bool decode(std::istream& in, std::ostream& out);
+
+		uint64_t getCount() const { return m_count; }
+		const std::string& getError() const { return m_error; }
+	private:
+		bool readEvent(std::istream& in, LogBuffer& out);
+		bool readText(std::istream& in, LogBuffer& out);
+		bool fail(const std::string& error);
+	private:
+		LogFormatter::ptr m_formatter;
+		std::vector<LogBinarySiteInfo> m_sites;     //按id保存文件中的调用点定义
+		std::vector<Logger::ptr> m_loggers;         //按id保存文件中的日志器
+		uint64_t m_count = 0;                       //已解码的日志条数
+		std::string m_error;
+	};
+
+	/***************************************************
+		日志器注册表
+		名称到日志器的映射以只读快照发布，查找时在LogEpoch
+		临界区内读取快照，不加锁也不构造std::string；
+		新建日志器时在写者锁下复制快照、插入后原子替换
+	***************************************************/
 	class LoggerManager {
 	public:
 		using ptr = std::shared_ptr<LoggerManager>;
+		using LoggerMap = std::map<std::string, Logger::ptr, std::less<>>;
 		LoggerManager();
-		Logger::ptr getLogger(const std::string& name);
+		~LoggerManager();
+		//不存在时创建，多线程同时创建同名日志器得到同一个
+		Logger::ptr getLogger(std::string_view name);
+		//不存在时返回nullptr
+		Logger::ptr findLogger(std::string_view name) const;
 
 		void init();
 		Logger::ptr getRoot() const { return m_root; }
 
 		std::string toYamlString();
+		/***************************************************
+			按格式化出的消息字节数(相同时按输出条数)
+			从大到小输出前top_n个日志调用点的统计，
+			每项为file、line、level、emitted、suppressed、bytes
+		***************************************************/
+		std::string toSiteStatsYamlString(size_t top_n = 20);
 	private:
-		std::map<std::string, Logger::ptr> m_loggers; //日志器集合
+		std::atomic<const LoggerMap*> m_loggers{ nullptr }; //日志器集合快照
+		std::mutex m_mutex;     //新建日志器的写者互斥
 		Logger::ptr m_root; //根日志器
 	};
 
@@ -0,0 +1,203 @@
+// LogBinary.h: 二进制延迟格式化日志的编码
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "LogBuffer.h"
+
+namespace GameProjectServer
+{
+	/***************************************************
+		二进制日志文件格式
+		文件以8字节kLogBinaryMagic开头，之后是连续的记录，
+		每条记录以1字节类型开头，整数按本机字节序写出，
+		字符串为uint32长度+内容：
+			SITE    uint32 id, int32 line, uint8 level,
+			        string file, string fmt, string types
+			LOGGER  uint32 id, string name
+			EVENT   uint32 site, uint32 logger, uint64 time,
+			        uint64 elapse, uint32 thread, uint32 fiber, 参数
+			TEXT    uint32 logger, uint8 level, int32 line,
+			        uint64 time, uint64 elapse, uint32 thread,
+			        uint32 fiber, string file, string message
+		调用点与日志器的定义在文件中首次被引用之前写出，
+		文件不依赖写出它的进程即可解码。
+		每个BinaryLogAppender追加写入时都先写出kLogBinaryMagic，
+		文件可以是多段这样的数据首尾相接，后出现的定义覆盖之前的
+	***************************************************/
+	static constexpr char kLogBinaryMagic[8] = { 'N', 'S', 'T', 'B', 'L', 'O', 'G', '1' };
+
+	//记录类型
+	class LogBinaryRecord {
+	public:
+		enum Type : uint8_t {
+			SITE = 1,       //调用点定义
+			LOGGER = 2,     //日志器定义
+			EVENT = 3,      //二进制日志事件
+			TEXT = 4        //已格式化的文本日志事件
+		};
+	};
+
+	//参数类型，EVENT中参数的编码由调用点的types决定
+	class LogBinaryArg {
+	public:
+		enum Type : uint8_t {
+			BOOL = 1,       //1字节
+			CHAR = 2,       //1字节
+			INT = 3,        //int64
+			UINT = 4,       //uint64
+			FLOAT = 5,      //float
+			DOUBLE = 6,     //double
+			STRING = 7      //uint32长度+内容
+		};
+	};
+
+	//参数类型到LogBinaryArg::Type的映射，只支持算术类型与字符串
+	template<class T>
+	constexpr uint8_t LogBinaryArgType()
+	{
+		using D = std::decay_t<T>;
+		if constexpr (std::is_same_v<D, bool>)
+		{
+			return LogBinaryArg::BOOL;
+		}
+		else if constexpr (std::is_same_v<D, char>)
+		{
+			return LogBinaryArg::CHAR;
+		}
+		else if constexpr ((std::is_integral_v<D> && std::is_signed_v<D>) || std::is_enum_v<D>)
+		{
+			return LogBinaryArg::INT;
+		}
+		else if constexpr (std::is_integral_v<D>)
+		{
+			return LogBinaryArg::UINT;
+		}
+		else if constexpr (std::is_same_v<D, float>)
+		{
+			return LogBinaryArg::FLOAT;
+		}
+		else if constexpr (std::is_floating_point_v<D>)
+		{
+			return LogBinaryArg::DOUBLE;
+		}
+		else if constexpr (std::is_convertible_v<const T&, const char*>
+			|| std::is_convertible_v<const T&, std::string_view>)
+		{
+			return LogBinaryArg::STRING;
+		}
+		else
+		{
+			static_assert(sizeof(T) == 0, "binary log arguments must be arithmetic or string types");
+			return 0;
+		}
+	}
+
+	/***************************************************
+		日志调用点的静态信息，由日志宏定义为静态变量，
+		首次使用时注册得到id，之后事件只写出id
+	***************************************************/
+	struct LogBinarySite
+	{
+		constexpr LogBinarySite(const char* file_, int line_, int level_, const char* fmt_)
+			: file(file_), line(line_), level(level_), fmt(fmt_)
+		{
+		}
+
+		const char* file;
+		int line;
+		int level;
+		const char* fmt;
+		std::atomic<uint32_t> id{ 0 };
+	};
+
+	//注册表中保存的调用点信息
+	struct LogBinarySiteInfo
+	{
+		std::string file;
+		int line = 0;
+		int level = 0;
+		std::string fmt;
+		std::string types;      //每个参数一个LogBinaryArg::Type
+	};
+
+	//注册调用点，返回从1开始的id，多线程同时注册同一调用点时得到同一id
+	uint32_t LogBinaryRegisterSite(LogBinarySite& site, const uint8_t* types, size_t count);
+	//注册日志器名称，同名返回同一id
+	uint32_t LogBinaryRegisterLogger(const std::string& name);
+	bool LogBinaryGetSite(uint32_t id, LogBinarySiteInfo& info);
+	bool LogBinaryGetLogger(uint32_t id, std::string& name);
+
+	//编码二进制记录使用的线程缓冲区，清空后返回
+	LogBuffer& LogBinaryThreadBuffer();
+
+	template<class T>
+	void LogBinaryPut(LogBuffer& buf, const T& v)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "LogBinaryPut requires a trivially copyable type");
+		char* p = buf.prepare(sizeof(T));
+		memcpy(p, &v, sizeof(T));
+		buf.commit(sizeof(T));
+	}
+
+	inline void LogBinaryPutString(LogBuffer& buf, const char* str, size_t len)
+	{
+		LogBinaryPut(buf, static_cast<uint32_t>(len));
+		buf.append(str, len);
+	}
+
+	//写出EVENT记录头，读取日志时钟与线程、协程id
+	void LogBinaryBeginEvent(LogBuffer& buf, uint32_t site, uint32_t logger);
+
+	template<class T>
+	void LogBinaryEncodeArg(LogBuffer& buf, const T& v)
+	{
+		constexpr uint8_t type = LogBinaryArgType<T>();
+		if constexpr (type == LogBinaryArg::BOOL)
+		{
+			buf.append(static_cast<char>(v ? 1 : 0));
+		}
+		else if constexpr (type == LogBinaryArg::CHAR)
+		{
+			buf.append(v);
+		}
+		else if constexpr (type == LogBinaryArg::INT)
+		{
+			LogBinaryPut(buf, static_cast<int64_t>(v));
+		}
+		else if constexpr (type == LogBinaryArg::UINT)
+		{
+			LogBinaryPut(buf, static_cast<uint64_t>(v));
+		}
+		else if constexpr (type == LogBinaryArg::FLOAT)
+		{
+			LogBinaryPut(buf, v);
+		}
+		else if constexpr (type == LogBinaryArg::DOUBLE)
+		{
+			LogBinaryPut(buf, static_cast<double>(v));
+		}
+		else if constexpr (std::is_convertible_v<const T&, const char*>)
+		{
+			const char* str = v;
+			str = str ? str : "(null)";
+			LogBinaryPutString(buf, str, strlen(str));
+		}
+		else
+		{
+			std::string_view str = v;
+			LogBinaryPutString(buf, str.data(), str.size());
+		}
+	}
+
+	template<class... Args>
+	void LogBinaryEncode(LogBuffer& buf, const Args&... args)
+	{
+		(LogBinaryEncodeArg(buf, args), ...);
+	}
+}
\ No newline at end of file
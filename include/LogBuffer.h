@@ -0,0 +1,157 @@
+// LogBuffer.h: 日志格式化使用的可增长字符缓冲区
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <ostream>
+#include <streambuf>
+
+namespace GameProjectServer
+{
+	/***************************************************
+		日志字符缓冲区
+		内容较短时使用内置数组，超出后扩容到堆上，
+		clear只重置长度并保留已申请的容量，
+		反复使用同一个缓冲区时不会再分配内存
+	***************************************************/
+	class LogBuffer
+	{
+	public:
+		static constexpr size_t kInlineSize = 256;
+
+		LogBuffer()
+			: m_data(m_inline), m_capacity(kInlineSize)
+		{
+		}
+		~LogBuffer()
+		{
+			if (m_data != m_inline)
+			{
+				delete[] m_data;
+			}
+		}
+		LogBuffer(const LogBuffer&) = delete;
+		LogBuffer& operator=(const LogBuffer&) = delete;
+
+		void append(const char* str, size_t len)
+		{
+			if (m_size + len > m_capacity)
+			{
+				grow(m_size + len);
+			}
+			memcpy(m_data + m_size, str, len);
+			m_size += len;
+		}
+		void append(const char* str) { append(str, strlen(str)); }
+		void append(const std::string& str) { append(str.data(), str.size()); }
+		void append(char c)
+		{
+			if (m_size + 1 > m_capacity)
+			{
+				grow(m_size + 1);
+			}
+			m_data[m_size++] = c;
+		}
+
+		void appendUInt(uint64_t v);
+		void appendInt(int64_t v);
+		//最短的可还原表示
+		void appendDouble(double v);
+		void appendFloat(float v);
+
+		/***************************************************
+			直接向缓冲区尾部写入时使用：
+			prepare保证尾部至少有n字节可写并返回写入位置，
+			写完后调用commit提交实际写入的字节数
+		***************************************************/
+		char* prepare(size_t n)
+		{
+			if (m_size + n > m_capacity)
+			{
+				grow(m_size + n);
+			}
+			return m_data + m_size;
+		}
+		void commit(size_t n) { m_size += n; }
+
+		char* data() { return m_data; }
+		const char* data() const { return m_data; }
+		size_t size() const { return m_size; }
+		size_t capacity() const { return m_capacity; }
+		bool empty() const { return m_size == 0; }
+		void clear() { m_size = 0; }
+		//丢弃n之后的内容，保留容量
+		void truncate(size_t n)
+		{
+			if (n < m_size)
+			{
+				m_size = n;
+			}
+		}
+		std::string toString() const { return std::string(m_data, m_size); }
+	private:
+		void grow(size_t need);
+	private:
+		char* m_data;                   //当前使用的存储
+		size_t m_size = 0;              //已写入的字节数
+		size_t m_capacity;              //当前存储容量
+		char m_inline[kInlineSize];     //内置存储
+	};
+
+	//把输出写入LogBuffer的streambuf
+	class LogStreamBuf : public std::streambuf
+	{
+	public:
+		LogBuffer& buffer() { return m_buffer; }
+		const LogBuffer& buffer() const { return m_buffer; }
+	protected:
+		int_type overflow(int_type c) override
+		{
+			if (!traits_type::eq_int_type(c, traits_type::eof()))
+			{
+				m_buffer.append(traits_type::to_char_type(c));
+			}
+			return traits_type::not_eof(c);
+		}
+		std::streamsize xsputn(const char* s, std::streamsize n) override
+		{
+			m_buffer.append(s, static_cast<size_t>(n));
+			return n;
+		}
+	private:
+		LogBuffer m_buffer;
+	};
+
+	/***************************************************
+		日志消息流
+		内容写入内置的LogBuffer，短消息不分配内存，
+		reset后可重复使用
+	***************************************************/
+	class LogStream : public std::ostream
+	{
+	public:
+		LogStream()
+			: std::ostream(nullptr)
+		{
+			rdbuf(&m_buf);
+		}
+
+		LogBuffer& buffer() { return m_buf.buffer(); }
+		const LogBuffer& buffer() const { return m_buf.buffer(); }
+
+		//清空内容并恢复默认的格式状态
+		void reset()
+		{
+			m_buf.buffer().clear();
+			clear();
+			flags(std::ios_base::dec | std::ios_base::skipws);
+			precision(6);
+			width(0);
+			fill(' ');
+		}
+	private:
+		LogStreamBuf m_buf;
+	};
+}
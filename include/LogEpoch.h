@@ -0,0 +1,52 @@
+// LogEpoch.h: 基于纪元的延迟回收，供日志器配置的无锁读取使用
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GameProjectServer
+{
+	/***************************************************
+		纪元回收(EBR)
+		读者进入临界区时公布当前全局纪元，退出时撤销；
+		写者把对象从发布位置摘下后调用Retire，对象记录摘下时
+		的纪元，所有公布了不大于该纪元的读者退出后才释放。
+		读者只做一次线程局部访问和一次原子写，不加锁；
+		写者与回收在互斥量下进行，只在修改配置时发生
+	***************************************************/
+	class LogEpoch
+	{
+	public:
+		//读者临界区，可嵌套，只有最外层公布和撤销纪元
+		class Guard
+		{
+		public:
+			Guard();
+			~Guard();
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+		private:
+			struct LogEpochRecord* m_record;
+		};
+
+		//延迟释放ptr，deleter在没有读者可能持有ptr后调用
+		static void Retire(void* ptr, void (*deleter)(void*));
+		template<class T>
+		static void Retire(T* ptr)
+		{
+			Retire(static_cast<void*>(ptr), [](void* p) { delete static_cast<T*>(p); });
+		}
+
+		//释放已没有读者可能持有的对象，Retire时会自动调用
+		static void Reclaim();
+		/***************************************************
+			等待调用前已进入临界区的读者全部退出，
+			调用者自己所在的临界区不计入；
+			调用前修改的标志此后进入的读者都能看到
+		***************************************************/
+		static void Synchronize();
+		//等待释放的对象个数
+		static size_t GetPendingCount();
+		static uint64_t GetEpoch();
+	};
+}
\ No newline at end of file
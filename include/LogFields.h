@@ -0,0 +1,100 @@
+// LogFields.h: 日志事件的结构化字段，以及JSON/logfmt输出使用的转义
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "LogBuffer.h"
+
+namespace GameProjectServer
+{
+	//字段值的类型
+	enum LogFieldType : uint8_t
+	{
+		kLogFieldString = 0,    //字符串，输出时按格式转义并加引号
+		kLogFieldRaw = 1        //数字、布尔值与null，原样输出
+	};
+
+	/***************************************************
+		字段在缓冲区中的编码：
+		[LogFieldHeader][key][value]，头部按字节拷贝，不要求对齐
+		值在写入时就已转成文本，字符串保存原文，
+		转义推迟到格式化，由输出格式决定
+	***************************************************/
+	struct LogFieldHeader
+	{
+		uint8_t type;
+		uint32_t keyLength;
+		uint32_t valueLength;
+	};
+
+	//写入字段头与键，返回头部在缓冲区中的位置，之后直接向缓冲区追加值
+	inline size_t LogFieldBegin(LogBuffer& buf, LogFieldType type, std::string_view key)
+	{
+		size_t offset = buf.size();
+		LogFieldHeader header{ type, static_cast<uint32_t>(key.size()), 0 };
+		buf.append(reinterpret_cast<const char*>(&header), sizeof(header));
+		buf.append(key.data(), key.size());
+		return offset;
+	}
+
+	//值写完后回填值的长度
+	inline void LogFieldEnd(LogBuffer& buf, size_t offset)
+	{
+		LogFieldHeader header;
+		memcpy(&header, buf.data() + offset, sizeof(header));
+		header.valueLength = static_cast<uint32_t>(buf.size() - offset - sizeof(header) - header.keyLength);
+		memcpy(buf.data() + offset, &header, sizeof(header));
+	}
+
+	//按写入顺序遍历字段，f(LogFieldType type, std::string_view key, std::string_view value)
+	template<class F>
+	void LogFieldsForEach(const LogBuffer& buf, F&& f)
+	{
+		const char* p = buf.data();
+		const char* end = p + buf.size();
+		while (p + sizeof(LogFieldHeader) <= end)
+		{
+			LogFieldHeader header;
+			memcpy(&header, p, sizeof(header));
+			p += sizeof(header);
+			std::string_view key(p, header.keyLength);
+			p += header.keyLength;
+			std::string_view value(p, header.valueLength);
+			p += header.valueLength;
+			f(static_cast<LogFieldType>(header.type), key, value);
+		}
+	}
+
+	/***************************************************
+		JSON字符串转义，不含两侧引号
+		查表判断每个字节，连续的无需转义的字节整段拷贝，
+		每次先按8字节检查，整段无需转义时直接跳过；
+		非ASCII字节原样输出
+	***************************************************/
+	void LogEscapeJson(LogBuffer& buf, const char* str, size_t len);
+
+	//写出带引号的JSON字符串
+	inline void LogAppendJsonString(LogBuffer& buf, std::string_view str)
+	{
+		buf.append('"');
+		LogEscapeJson(buf, str.data(), str.size());
+		buf.append('"');
+	}
+
+	/***************************************************
+		logfmt的值，为空或含空白、控制字符、=、"时
+		加引号并按JSON规则转义，否则原样输出
+	***************************************************/
+	void LogAppendLogfmtValue(LogBuffer& buf, std::string_view str);
+
+	//logfmt的键，空白、控制字符、=、"替换为_
+	void LogAppendLogfmtKey(LogBuffer& buf, std::string_view key);
+
+	//把所有字段以 ,"key":value 的形式追加到JSON对象中
+	void LogFieldsToJson(LogBuffer& out, const LogBuffer& fields);
+
+	//把所有字段以 key=value 的形式追加，每个字段前加一个空格
+	void LogFieldsToLogfmt(LogBuffer& out, const LogBuffer& fields);
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+// LogFormat.h: {}风格的类型安全日志格式化
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "LogBuffer.h"
+
+namespace GameProjectServer
+{
+	/***************************************************
+		统计格式串中{}占位符的个数，{{ 和 }} 为转义
+		格式串为字面量时可在编译期求值
+	***************************************************/
+	constexpr size_t LogFormatArgCount(const char* fmt)
+	{
+		size_t count = 0;
+		for (; *fmt; ++fmt)
+		{
+			if (*fmt == '{' && fmt[1] == '{')
+			{
+				++fmt;
+			}
+			else if (*fmt == '{' && fmt[1] == '}')
+			{
+				++count;
+				++fmt;
+			}
+		}
+		return count;
+	}
+
+	//携带占位符个数的格式串，用于在编译期检查参数个数
+	template<size_t N>
+	struct LogFormatString
+	{
+		const char* str;
+	};
+
+	/***************************************************
+		把fmt中下一个占位符之前的文本写入buf，
+		返回占位符之后的位置，没有占位符时返回nullptr
+	***************************************************/
+	const char* LogFormatLiteral(LogBuffer& buf, const char* fmt);
+
+	//按参数类型写入，整数与浮点数不经过iostream
+	template<class T>
+	void LogFormatValue(LogStream& os, const T& v)
+	{
+		using D = std::decay_t<T>;
+		LogBuffer& buf = os.buffer();
+		if constexpr (std::is_same_v<D, bool>)
+		{
+			buf.append(v ? "true" : "false");
+		}
+		else if constexpr (std::is_same_v<D, char>)
+		{
+			buf.append(v);
+		}
+		else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>)
+		{
+			buf.appendInt(v);
+		}
+		else if constexpr (std::is_integral_v<D>)
+		{
+			buf.appendUInt(v);
+		}
+		else if constexpr (std::is_same_v<D, float>)
+		{
+			buf.appendFloat(v);
+		}
+		else if constexpr (std::is_floating_point_v<D>)
+		{
+			buf.appendDouble(static_cast<double>(v));
+		}
+		else if constexpr (std::is_enum_v<D>)
+		{
+			buf.appendInt(static_cast<int64_t>(v));
+		}
+		else if constexpr (std::is_convertible_v<const T&, const char*>)
+		{
+			const char* str = v;
+			buf.append(str ? str : "(null)");
+		}
+		else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+		{
+			std::string_view str = v;
+			buf.append(str.data(), str.size());
+		}
+		else
+		{
+			//其他类型使用operator<<
+			os << v;
+		}
+	}
+
+	template<class... Args>
+	void LogFormatTo(LogStream& os, const char* fmt, const Args&... args)
+	{
+		//多余的参数被忽略，多余的占位符原样输出
+		((fmt = fmt ? LogFormatLiteral(os.buffer(), fmt) : nullptr,
+			fmt ? LogFormatValue(os, args) : void()), ...);
+		while (fmt)
+		{
+			fmt = LogFormatLiteral(os.buffer(), fmt);
+			if (fmt)
+			{
+				os.buffer().append("{}", 2);
+			}
+		}
+	}
+}
@@ -0,0 +1,105 @@
+// LogIndex.h: 日志文件的时间/级别旁路索引
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "LogWriter.h"
+
+namespace GameProjectServer
+{
+	/***************************************************
+		索引文件格式
+		文件以LogIndexHeader开头，之后是定长的LogIndexEntry，
+		整数按本机字节序写出；日志文件每写出约interval字节
+		结束一块并追加一条记录，块的边界总在行首。
+		日志文件中没有被任何记录覆盖的部分(进程崩溃前
+		尚未结束的块、开启索引之前写入的内容)视为未知，查找时总是读取
+	***************************************************/
+	static constexpr char kLogIndexMagic[8] = { 'N', 'S', 'T', 'L', 'I', 'D', 'X', '1' };
+
+	struct LogIndexHeader
+	{
+		char magic[8];          //kLogIndexMagic
+		uint32_t interval;      //写入时的分块字节数
+		uint32_t entrySize;     //sizeof(LogIndexEntry)
+	};
+
+	//一块日志的索引记录
+	struct LogIndexEntry
+	{
+		uint64_t offset;        //块在日志文件中的起始位置
+		uint32_t length;        //块的字节数
+		uint32_t count;         //块中的日志条数
+		uint64_t minTime;       //块中最早的时间戳(纳秒)
+		uint64_t maxTime;       //块中最晚的时间戳(纳秒)
+		uint8_t maxLevel;       //块中最高的日志级别
+		uint8_t reserved[7];
+	};
+
+	static_assert(sizeof(LogIndexEntry) == 40, "log index entry layout changed");
+
+	//查找得到的需要读取的日志文件区间[begin, end)
+	struct LogIndexRange
+	{
+		uint64_t begin;
+		uint64_t end;
+	};
+
+	/***************************************************
+		写入日志文件并维护索引
+		所有写入都经过本对象，写入位置取自LogFileWriter的
+		文件长度，与写入在同一把锁下完成，多线程写入时
+		每行都计入它实际所在的块；不支持文件轮转与压缩
+	***************************************************/
+	class LogFileIndex
+	{
+	public:
+		using ptr = std::unique_ptr<LogFileIndex>;
+		static constexpr uint32_t kDefaultInterval = 64 * 1024;
+
+		/***************************************************
+			打开filename的索引文件(filename.idx)，
+			已有的合法索引文件继续追加，否则重新创建；
+			失败返回nullptr
+		***************************************************/
+		static ptr Open(const std::string& filename, LogFileWriter::ptr target, uint32_t interval);
+		//结束当前块并写出它的记录
+		~LogFileIndex();
+		LogFileIndex(const LogFileIndex&) = delete;
+		LogFileIndex& operator=(const LogFileIndex&) = delete;
+
+		//写入一行日志，time为0时(如重复计数行)不计入时间范围
+		void write(const char* data, size_t len, bool flush, uint64_t time, uint8_t level);
+		void flush();
+
+		uint32_t getInterval() const { return m_interval; }
+		uint64_t getEntryCount() const;
+
+		static std::string GetIndexName(const std::string& filename) { return filename + ".idx"; }
+
+		//读取索引文件中的全部记录，文件不存在或格式不对时返回false，末尾不完整的记录被忽略
+		static bool Load(const std::string& index_file, std::vector<LogIndexEntry>& entries);
+		/***************************************************
+			按时间范围[from, to](纳秒)与最低级别选出需要读取的区间，
+			file_size为日志文件长度，索引没有覆盖的部分总是被选中，
+			相邻的区间合并为一个
+		***************************************************/
+		static std::vector<LogIndexRange> Select(const std::vector<LogIndexEntry>& entries, uint64_t file_size,
+			uint64_t from, uint64_t to, uint8_t min_level);
+	private:
+		LogFileIndex(LogFileWriter::ptr target, LogFileWriter::ptr index, uint32_t interval);
+		//结束当前块，调用者持有m_mutex
+		void closeEntry(uint64_t end, bool flush);
+	private:
+		mutable std::mutex m_mutex;
+		LogFileWriter::ptr m_target;    //日志文件
+		LogFileWriter::ptr m_index;     //索引文件
+		uint32_t m_interval;            //分块字节数
+		LogIndexEntry m_entry;          //当前块
+		uint64_t m_entries = 0;         //已写出的记录数
+	};
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+// LogRateLimit.h: 日志调用点的采样与限流状态，供NILESTHUMP_LOG_EVERY_N等宏使用
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "Util.h"
+
+namespace GameProjectServer
+{
+	/***************************************************
+		每个限流宏的调用点有一个静态的限流对象，
+		allow返回true时输出日志，suppressed为上一条输出之后
+		被丢弃的次数；所有状态都是无锁的原子变量
+	***************************************************/
+
+	//每n次输出一次，被丢弃的调用只做一次relaxed自增
+	class LogEveryN
+	{
+	public:
+		explicit LogEveryN(uint64_t n) : m_n(n ? n : 1) {}
+
+		bool allow(uint64_t& suppressed)
+		{
+			uint64_t count = m_count.fetch_add(1, std::memory_order_relaxed);
+			if (count % m_n)
+			{
+				return false;
+			}
+			suppressed = count ? m_n - 1 : 0;
+			return true;
+		}
+	private:
+		const uint64_t m_n;
+		std::atomic<uint64_t> m_count{ 0 };
+	};
+
+	//只输出前n次，之后的调用只做一次relaxed自增
+	class LogFirstN
+	{
+	public:
+		explicit LogFirstN(uint64_t n) : m_n(n) {}
+
+		bool allow(uint64_t& suppressed)
+		{
+			//输出的都是前n次，之前没有被丢弃的调用
+			suppressed = 0;
+			return m_count.fetch_add(1, std::memory_order_relaxed) < m_n;
+		}
+	private:
+		const uint64_t m_n;
+		std::atomic<uint64_t> m_count{ 0 };
+	};
+
+	//每ms毫秒最多输出一次，被丢弃的调用读一次日志时钟并做一次relaxed自增
+	class LogEveryMs
+	{
+	public:
+		explicit LogEveryMs(uint64_t ms) : m_interval(ms * 1000000ULL) {}
+
+		bool allow(uint64_t& suppressed)
+		{
+			uint64_t now = GetElapseNS();
+			uint64_t next = m_next.load(std::memory_order_relaxed);
+			//同一时刻只有一个线程能推进下次输出时间
+			if (now < next || !m_next.compare_exchange_strong(next, now + m_interval, std::memory_order_relaxed))
+			{
+				m_suppressed.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+			return true;
+		}
+	private:
+		const uint64_t m_interval;                  //输出间隔(纳秒)
+		std::atomic<uint64_t> m_next{ 0 };          //下次允许输出的时间
+		std::atomic<uint64_t> m_suppressed{ 0 };
+	};
+
+	/***************************************************
+		令牌桶，平均每秒rate条，最多连续输出burst条
+		按GCRA实现，只用一个原子变量记录理论到达时间：
+		每条日志把它推后1/rate秒，超出当前时间burst/rate秒时丢弃
+	***************************************************/
+	class LogTokenBucket
+	{
+	public:
+		LogTokenBucket(double rate, uint32_t burst)
+			: m_interval(rate >= 1e9 ? 1 : rate > 1e-9 ? static_cast<uint64_t>(1e9 / rate) : kNever)
+			, m_limit(burst > 1 && burst <= kNever / m_interval ? m_interval * burst : m_interval)
+		{
+		}
+
+		bool allow(uint64_t& suppressed)
+		{
+			uint64_t now = GetElapseNS();
+			uint64_t tat = m_tat.load(std::memory_order_relaxed);
+			uint64_t next;
+			do
+			{
+				next = (tat > now ? tat : now) + m_interval;
+				if (next - now > m_limit)
+				{
+					m_suppressed.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+			} while (!m_tat.compare_exchange_weak(tat, next, std::memory_order_relaxed));
+			suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+			return true;
+		}
+	private:
+		static constexpr uint64_t kNever = 1000000000ULL * 1000000000ULL;
+
+		const uint64_t m_interval;                  //每条日志消耗的时间(纳秒)
+		const uint64_t m_limit;                     //可以预支的时间
+		std::atomic<uint64_t> m_tat{ 0 };           //理论到达时间
+		std::atomic<uint64_t> m_suppressed{ 0 };
+	};
+}
\ No newline at end of file
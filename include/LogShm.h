@@ -0,0 +1,143 @@
+// LogShm.h: 多进程共享内存日志通道与收集器
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "LogWriter.h"
+
+namespace GameProjectServer
+{
+	/***************************************************
+		共享内存日志通道
+		同一台机器上的多个进程按名称打开同一个共享内存段，
+		段内有slot_count个槽，每个进程占用一个槽，
+		槽内是ring_size字节的环形缓冲区：进程内的多个线程
+		以CAS预留空间、复制后单独提交每条记录，不加锁；
+		唯一的收集进程按提交顺序取出并清零已读取的空间。
+		环形缓冲区已满时日志被丢弃并计数，写入进程不等待收集进程。
+		段在第一次打开时创建，之后打开时沿用已有段的槽数与大小，
+		所有进程退出后仍然保留(Linux下为/dev/shm/name)，
+		直到调用Remove；Windows下随最后一个句柄关闭而释放
+	***************************************************/
+	class LogShmChannel
+	{
+		friend class LogShmCollector;
+	public:
+		using ptr = std::unique_ptr<LogShmChannel>;
+		static constexpr uint32_t kDefaultSlotCount = 16;
+		static constexpr uint64_t kDefaultRingSize = 1024 * 1024;
+		static constexpr char kMagic[8] = { 'N', 'S', 'T', 'S', 'H', 'M', 'L', '1' };
+
+		//打开或创建名为name的通道，失败返回nullptr
+		static ptr Open(const std::string& name, uint32_t slot_count = kDefaultSlotCount,
+			uint64_t ring_size = kDefaultRingSize);
+		//删除共享内存段，已打开的进程仍可继续使用
+		static bool Remove(const std::string& name);
+
+		~LogShmChannel();
+		LogShmChannel(const LogShmChannel&) = delete;
+		LogShmChannel& operator=(const LogShmChannel&) = delete;
+
+		//为当前进程占用一个空闲的槽，没有空闲槽时返回-1
+		int32_t acquireSlot();
+		//归还槽，槽中尚未取出的日志仍由收集进程取出
+		void releaseSlot(uint32_t slot);
+		/***************************************************
+			写入一条日志并提交，time为排序用的时间戳(纳秒)；
+			空间不足时丢弃并返回false，可由多个线程同时调用
+		***************************************************/
+		bool append(uint32_t slot, uint64_t time, const char* data, size_t len);
+
+		const std::string& getName() const { return m_name; }
+		uint32_t getSlotCount() const { return m_slotCount; }
+		uint64_t getRingSize() const { return m_ringSize; }
+		//占用槽的进程id，0为空闲
+		uint64_t getOwner(uint32_t slot) const;
+		//槽中因空间不足丢弃的日志数，跨占用者累计
+		uint64_t getDroppedCount(uint32_t slot) const;
+		//槽中已写入尚未被收集进程取出的字节数
+		uint64_t getPendingBytes(uint32_t slot) const;
+	private:
+		LogShmChannel() = default;
+		struct LogShmSlot* getSlot(uint32_t slot) const;
+		char* getRing(uint32_t slot) const;
+	private:
+		std::string m_name;                 //通道名称
+		int m_fd = -1;                      //共享内存对象的描述符
+		void* m_mapping = nullptr;          //Windows下的文件映射对象
+		char* m_base = nullptr;             //映射的起始地址
+		uint64_t m_size = 0;                //映射的字节数
+		uint32_t m_slotCount = 0;           //槽数
+		uint64_t m_ringSize = 0;            //每个槽的环形缓冲区字节数
+		struct LogShmHeader* m_header = nullptr;
+	};
+
+	/***************************************************
+		共享内存日志收集器
+		同一通道同一时间只能有一个收集器，
+		poll取出所有槽中已提交的日志，按时间戳排序后
+		写出早于当前时间delay毫秒的部分，其余留到之后，
+		使各进程的日志在delay内的先后错位被纠正；
+		写入进程退出而没有归还槽(如崩溃)时，取出它留下的日志后
+		回收该槽，崩溃时写到一半的记录及其后的数据被丢弃
+	***************************************************/
+	class LogShmCollector
+	{
+	public:
+		using ptr = std::unique_ptr<LogShmCollector>;
+		static constexpr uint32_t kDefaultDelay = 100;
+
+		/***************************************************
+			打开通道并成为它的收集器，日志写入writer
+			(轮转等由writer的策略决定)；通道已有仍在运行的
+			收集器或打开失败时返回nullptr
+		***************************************************/
+		static ptr Open(const std::string& name, LogFileWriter::ptr writer, uint32_t delay = kDefaultDelay,
+			uint32_t slot_count = LogShmChannel::kDefaultSlotCount,
+			uint64_t ring_size = LogShmChannel::kDefaultRingSize);
+		//写出剩余的日志并放弃收集器身份
+		~LogShmCollector();
+		LogShmCollector(const LogShmCollector&) = delete;
+		LogShmCollector& operator=(const LogShmCollector&) = delete;
+
+		//取出并写出日志，all为true时不等待delay，写出所有已取出的日志；返回写出的条数
+		size_t poll(bool all = false);
+
+		LogShmChannel& getChannel() { return *m_channel; }
+		const LogFileWriter::ptr& getWriter() const { return m_writer; }
+		uint32_t getDelay() const { return m_delay; }
+		uint64_t getWrittenCount() const { return m_written; }
+		//所有槽中丢弃的日志数
+		uint64_t getDroppedCount() const;
+		//回收崩溃进程的槽时丢弃的字节数
+		uint64_t getLostBytes() const { return m_lostBytes; }
+		//已取出尚未写出的日志数
+		size_t getPendingCount() const { return m_pending.size(); }
+	private:
+		LogShmCollector(LogShmChannel::ptr channel, LogFileWriter::ptr writer, uint32_t delay);
+		//取出一个槽中已提交的日志，遇到未提交的记录时返回false
+		bool drain(uint32_t slot);
+	private:
+		//已取出、尚未到写出时间的日志
+		struct Pending
+		{
+			uint64_t time;
+			size_t offset;
+			uint32_t length;
+		};
+
+		LogShmChannel::ptr m_channel;
+		LogFileWriter::ptr m_writer;
+		uint32_t m_delay;                   //写出前等待的时间(毫秒)
+		std::vector<Pending> m_pending;
+		std::string m_data;                 //m_pending引用的日志内容
+		std::string m_retained;             //整理m_data时使用
+		std::vector<uint64_t> m_lastTime;   //各槽取出的上一条日志的排序时间
+		uint64_t m_written = 0;
+		uint64_t m_lostBytes = 0;
+	};
+}
\ No newline at end of file
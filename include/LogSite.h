@@ -0,0 +1,107 @@
+// LogSite.h: 日志调用点统计，用于找出输出量大的日志语句
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace GameProjectServer
+{
+	//一个调用点在一个线程中的计数，只由所属线程写入
+	struct LogSiteCounters
+	{
+		std::atomic<uint64_t> emitted{ 0 };     //输出的日志数
+		std::atomic<uint64_t> suppressed{ 0 };  //级别不满足被跳过的日志数
+		std::atomic<uint64_t> bytes{ 0 };       //格式化出的消息字节数
+
+		static void Add(std::atomic<uint64_t>& counter, uint64_t n)
+		{
+			//只有所属线程写入，不需要读-改-写原子操作
+			counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+		}
+	};
+
+	static constexpr uint32_t kLogSiteChunkSize = 256;
+	static constexpr uint32_t kLogSiteMaxChunks = 1024;
+
+	/***************************************************
+		一个线程的计数块，按调用点id分块分配，
+		分块指针发布后不再改变，汇总线程在全局锁下读取；
+		最后一块供超出容量的调用点使用，不参与汇总
+	***************************************************/
+	struct LogSiteThreadCounters
+	{
+		std::atomic<LogSiteCounters*> chunks[kLogSiteMaxChunks + 1] = {};
+	};
+
+	//当前线程的计数块，常量初始化，访问时不需要线程局部对象的初始化检查
+	inline thread_local LogSiteThreadCounters* t_log_site_counters = nullptr;
+
+	//首次使用时分配当前线程的计数块与分块，线程退出后计数写入丢弃的位置
+	LogSiteCounters& LogSiteAttach(uint32_t id, LogSiteThreadCounters*& counters);
+
+	/***************************************************
+		日志宏的调用点描述
+		每个调用点有一个静态的LogSite，首次执行时注册得到id；
+		计数保存在线程局部的计数块中，热路径只读一次线程局部指针并写本线程的计数，
+		汇总时累加所有线程的计数与已退出线程留下的计数
+	***************************************************/
+	class LogSite
+	{
+	public:
+		LogSite(const char* file, int line, int level);
+		LogSite(const LogSite&) = delete;
+		LogSite& operator=(const LogSite&) = delete;
+
+		//级别不满足被跳过
+		void suppress() { LogSiteCounters::Add(counters().suppressed, 1); }
+		//输出一条日志，bytes为格式化出的消息长度
+		void emit(size_t bytes)
+		{
+			LogSiteCounters& c = counters();
+			LogSiteCounters::Add(c.emitted, 1);
+			LogSiteCounters::Add(c.bytes, bytes);
+		}
+
+		const char* getFile() const { return m_file; }
+		int getLine() const { return m_line; }
+		int getLevel() const { return m_level; }
+		uint32_t getId() const { return m_id; }
+	private:
+		//当前线程中本调用点的计数
+		LogSiteCounters& counters()
+		{
+			LogSiteThreadCounters* counters = t_log_site_counters;
+			if (counters)
+			{
+				LogSiteCounters* chunk = counters->chunks[m_id / kLogSiteChunkSize].load(std::memory_order_relaxed);
+				if (chunk)
+				{
+					return chunk[m_id % kLogSiteChunkSize];
+				}
+			}
+			return LogSiteAttach(m_id, t_log_site_counters);
+		}
+	private:
+		const char* m_file;
+		int m_line;
+		int m_level;
+		uint32_t m_id;
+	};
+
+	//一个调用点的汇总计数
+	struct LogSiteStats
+	{
+		std::string file;
+		int line = 0;
+		int level = 0;
+		uint64_t emitted = 0;
+		uint64_t suppressed = 0;
+		uint64_t bytes = 0;
+	};
+
+	//所有已注册调用点的汇总计数，按id排列
+	std::vector<LogSiteStats> LogSiteCollect();
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+// LogWriter.h: 带用户态缓冲区的日志文件写入
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct z_stream_s;
+
+namespace GameProjectServer
+{
+	/***************************************************
+		日志文件轮转策略，满足任一条件即轮转：
+			size        文件达到size字节，0为不限
+			interval    本地时间跨过当天零点起interval秒的
+			            整数倍时，0为不限
+		轮转时file.N-1改名为file.N，...，file改名为file.1，
+		再新建file；max_files为保留的旧文件数，0为不删除；
+		preallocate为新文件预先分配的磁盘空间(字节)，不改变文件长度
+	***************************************************/
+	struct LogRotatePolicy
+	{
+		uint64_t size = 0;
+		uint32_t interval = 0;
+		uint32_t max_files = 0;
+		uint64_t preallocate = 0;
+
+		bool operator==(const LogRotatePolicy& oth) const
+		{
+			return size == oth.size
+				&& interval == oth.interval
+				&& max_files == oth.max_files
+				&& preallocate == oth.preallocate;
+		}
+		bool enabled() const { return size || interval; }
+	};
+
+	/***************************************************
+		日志文件的分块压缩
+			enabled     是否压缩
+			level       zlib压缩级别，1最快，9压缩率最高
+			block_size  每块未压缩的字节数，达到后交给后台线程压缩
+		每块压缩为一个独立的gzip成员依次追加到文件中，
+		整个文件可直接用gzip/zcat解压，
+		进程崩溃时只丢失尚未写出的块，截断的末尾不影响之前的块
+	***************************************************/
+	struct LogCompressPolicy
+	{
+		static constexpr int kDefaultLevel = 6;
+		static constexpr size_t kDefaultBlockSize = 256 * 1024;
+
+		bool enabled = false;
+		int level = kDefaultLevel;
+		size_t block_size = kDefaultBlockSize;
+
+		bool operator==(const LogCompressPolicy& oth) const
+		{
+			return enabled == oth.enabled
+				&& level == oth.level
+				&& block_size == oth.block_size;
+		}
+	};
+
+	/***************************************************
+		日志文件写入器
+		数据先写入用户态缓冲区，满足刷新条件时才调用系统写入，
+		缓冲区放不下的大块数据与缓冲区内容经一次writev写出，
+		不再复制；多线程写入同一个写入器时由内部互斥量保护
+	***************************************************/
+	class LogFileWriter : public std::enable_shared_from_this<LogFileWriter>
+	{
+	public:
+		using ptr = std::shared_ptr<LogFileWriter>;
+		static constexpr size_t kDefaultBufferSize = 64 * 1024;
+
+		explicit LogFileWriter(size_t buffer_size = kDefaultBufferSize);
+		~LogFileWriter();
+		LogFileWriter(const LogFileWriter&) = delete;
+		LogFileWriter& operator=(const LogFileWriter&) = delete;
+
+		//打开文件，append为false时截断，失败返回false
+		bool open(const std::string& filename, bool append = false);
+		//写入已打开的文件描述符(如标准输出)，不负责关闭
+		void attach(int fd);
+		void close();
+
+		/***************************************************
+			追加数据，flush为true或缓冲数据达到
+			刷新字节数时写出缓冲区
+		***************************************************/
+		void write(const char* data, size_t len, bool flush);
+		void flush();
+		/***************************************************
+			供信号处理函数使用：只尝试加锁，取得锁时把缓冲区
+			与data直接写出，不分配内存也不请求轮转；
+			锁被占用或没有打开文件时返回false
+		***************************************************/
+		bool tryWrite(const char* data, size_t len);
+
+		//缓冲数据达到bytes字节时写出，0为缓冲区写满时
+		void setFlushBytes(size_t bytes);
+		/***************************************************
+			数据在缓冲区中停留超过interval毫秒时写出，0为不限，
+			由公共的后台线程定时检查，写入器须由shared_ptr持有
+		***************************************************/
+		void setFlushInterval(uint32_t interval);
+
+		/***************************************************
+			按策略轮转open打开的文件，改名、新建与预分配
+			由公共的后台线程完成，写入线程只比较文件长度，
+			切换前写入的数据仍写到原文件(已改名)中；
+			写入器须由shared_ptr持有
+		***************************************************/
+		void setRotatePolicy(const LogRotatePolicy& policy);
+		LogRotatePolicy getRotatePolicy() const;
+		//当前文件已写入(含缓冲)的字节数
+		uint64_t getFileSize() const { return m_fileSize.load(std::memory_order_relaxed); }
+		uint64_t getRotateCount() const { return m_rotateCount.load(std::memory_order_relaxed); }
+
+		size_t getBufferSize() const { return m_capacity; }
+		//发起的写入系统调用次数
+		uint64_t getWriteCalls() const { return m_writeCalls.load(std::memory_order_relaxed); }
+		uint64_t getWrittenBytes() const { return m_writtenBytes.load(std::memory_order_relaxed); }
+
+		//后台线程调用：缓冲数据停留超过刷新间隔时写出
+		void flushIfExpired(uint64_t now_ms);
+		/***************************************************
+			轮转线程调用：到达时间点或文件长度超出时轮转，
+			返回下一个按时间轮转的时间点(秒)，0为没有
+		***************************************************/
+		uint64_t rotateIfNeeded(uint64_t now);
+	private:
+		//改名旧文件并打开新文件，失败时继续写原文件
+		void rotate();
+		//写出缓冲区与data，调用者持有m_mutex
+		void writeLocked(const char* data, size_t len);
+	private:
+		mutable std::mutex m_mutex;
+		std::string m_filename;             //open打开的文件名，轮转时使用
+		int m_fd = -1;                      //文件描述符
+		bool m_owned = false;               //是否由写入器关闭
+		std::unique_ptr<char[]> m_buffer;   //用户态缓冲区
+		size_t m_capacity;                  //缓冲区容量
+		size_t m_size = 0;                  //缓冲数据字节数
+		size_t m_flushBytes;                //刷新字节数
+		uint32_t m_flushInterval = 0;       //刷新间隔(毫秒)
+		uint64_t m_pendingSince = 0;        //缓冲区中最早的数据写入的时间(毫秒)
+		bool m_registered = false;          //是否已交给后台线程定时检查
+		LogRotatePolicy m_rotate;           //轮转策略
+		uint64_t m_nextRotate = 0;          //下一个按时间轮转的时间点(秒)
+		bool m_rotateRegistered = false;    //是否已交给轮转线程
+		bool m_rotatePending = false;       //已请求轮转尚未完成
+		std::atomic<uint64_t> m_fileSize{ 0 };
+		std::atomic<uint64_t> m_rotateCount{ 0 };
+
+		std::atomic<uint64_t> m_writeCalls{ 0 };
+		std::atomic<uint64_t> m_writtenBytes{ 0 };
+	};
+
+	/***************************************************
+		分块gzip压缩写入
+		写入线程只把数据追加到当前块，块写满、要求立即写出
+		或停留超过刷新间隔时封块，由本写入器的后台线程
+		压缩成独立的gzip成员后经LogFileWriter写入文件；
+		待压缩的块达到kMaxPendingBlocks时写入线程等待，不丢弃日志
+	***************************************************/
+	class LogGzipWriter
+	{
+	public:
+		using ptr = std::unique_ptr<LogGzipWriter>;
+		static constexpr size_t kMaxPendingBlocks = 4;
+
+		//压缩器初始化失败时返回nullptr
+		static ptr Create(LogFileWriter::ptr target, const LogCompressPolicy& policy);
+		//写出剩余数据后停止后台线程
+		~LogGzipWriter();
+		LogGzipWriter(const LogGzipWriter&) = delete;
+		LogGzipWriter& operator=(const LogGzipWriter&) = delete;
+
+		//追加数据，flush为true时立即封块
+		void write(const char* data, size_t len, bool flush);
+		//封块并等待之前写入的数据都已压缩写出
+		void flush();
+		//当前块停留超过interval毫秒时封块，0为只按块大小封块
+		void setFlushInterval(uint32_t interval);
+
+		const LogCompressPolicy& getPolicy() const { return m_policy; }
+		uint64_t getBlockCount() const { return m_blockCount.load(std::memory_order_relaxed); }
+		//压缩前与压缩后的字节数
+		uint64_t getRawBytes() const { return m_rawBytes.load(std::memory_order_relaxed); }
+		uint64_t getCompressedBytes() const { return m_compressedBytes.load(std::memory_order_relaxed); }
+	private:
+		using Block = std::string;
+		using BlockPtr = std::unique_ptr<Block>;
+
+		LogGzipWriter(LogFileWriter::ptr target, const LogCompressPolicy& policy, z_stream_s* stream);
+		//把当前块交给后台线程，调用者持有m_mutex
+		void seal(std::unique_lock<std::mutex>& lock);
+		void run();
+		//压缩一块并写入文件，只在后台线程中调用
+		void compress(const Block& block);
+	private:
+		LogFileWriter::ptr m_target;        //写入压缩数据的文件
+		LogCompressPolicy m_policy;
+		z_stream_s* m_stream;               //只由后台线程使用
+		std::string m_out;                  //压缩输出缓冲区
+
+		std::mutex m_mutex;
+		std::condition_variable m_cond;     //通知后台线程
+		std::condition_variable m_doneCond; //通知等待写出的线程
+		BlockPtr m_current;                 //正在追加的块
+		uint64_t m_currentSince = 0;        //当前块第一次写入的时间(毫秒)
+		std::vector<BlockPtr> m_blocks;     //已封块待压缩
+		std::vector<BlockPtr> m_free;       //已写出可复用的块
+		uint32_t m_flushInterval = 0;       //刷新间隔(毫秒)
+		uint64_t m_sealed = 0;              //已封块的数量
+		uint64_t m_written = 0;             //已写出的块数量
+		bool m_running = true;
+		std::thread m_thread;               //压缩线程
+
+		std::atomic<uint64_t> m_blockCount{ 0 };
+		std::atomic<uint64_t> m_rawBytes{ 0 };
+		std::atomic<uint64_t> m_compressedBytes{ 0 };
+	};
+
+	/***************************************************
+		内存映射的日志段文件
+		文件创建时即分配好全部大小并映射到内存，
+		开头kHeaderSize字节为文件头，其中的提交偏移在数据
+		复制完成后原子地推进；进程崩溃时已写入映射的数据
+		仍由内核写回文件，读取时以提交偏移为准。
+		append由调用者串行调用
+	***************************************************/
+	class LogMmapSegment
+	{
+	public:
+		using ptr = std::unique_ptr<LogMmapSegment>;
+		static constexpr size_t kHeaderSize = 64;
+		static constexpr char kMagic[8] = { 'N', 'S', 'T', 'M', 'L', 'O', 'G', '1' };
+
+		//创建size字节(含文件头)的段文件，失败返回nullptr
+		static ptr Create(const std::string& filename, uint64_t size, uint64_t index);
+		/***************************************************
+			读取段文件中已提交的数据，文件头不合法时返回false；
+			可用于读取进程崩溃时留下的段文件
+		***************************************************/
+		static bool Read(const std::string& filename, std::string& data);
+
+		//关闭时把文件截断到已提交的长度
+		~LogMmapSegment();
+		LogMmapSegment(const LogMmapSegment&) = delete;
+		LogMmapSegment& operator=(const LogMmapSegment&) = delete;
+
+		//追加并提交，剩余空间不足时不写入并返回false
+		bool append(const char* data, size_t len);
+		//请求内核异步写回，只在需要防止断电丢失时使用
+		void sync();
+
+		uint64_t getIndex() const { return m_index; }
+		//可写入的数据容量，不含文件头
+		uint64_t getCapacity() const { return m_size - kHeaderSize; }
+		uint64_t getCommitted() const;
+	private:
+		LogMmapSegment() = default;
+	private:
+		int m_fd = -1;
+		void* m_mapping = nullptr;      //Windows下的文件映射对象
+		char* m_base = nullptr;         //映射的起始地址
+		uint64_t m_size = 0;            //文件大小
+		uint64_t m_index = 0;           //段序号
+		struct LogMmapHeader* m_header = nullptr;
+	};
+}
\ No newline at end of file
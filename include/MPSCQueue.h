@@ -0,0 +1,123 @@
+// MPSCQueue.h: 有界无锁多生产者单消费者环形队列
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+namespace GameProjectServer
+{
+	/***************************************************
+		有界无锁 MPSC 环形队列
+		每个槽位带一个序号：
+			seq == pos        槽位空闲，可由第pos个生产者写入
+			seq == pos + 1    槽位已写入，可由消费者读取
+		生产者只需对m_tail执行一次fetch_add即可占到槽位，
+		消费者独占m_head，出队时只做普通的load/store
+	***************************************************/
+	template<class T>
+	class MPSCQueue
+	{
+	public:
+		//capacity会向上取整为2的幂
+		explicit MPSCQueue(size_t capacity)
+		{
+			m_capacity = RoundCapacity(capacity);
+			m_mask = m_capacity - 1;
+			m_cells.reset(new Cell[m_capacity]);
+			for (size_t i = 0; i < m_capacity; ++i)
+			{
+				m_cells[i].seq.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+		/***************************************************
+			队列未满时入队，队列已满返回false
+			满判断是近似的：多个生产者同时通过判断时，
+			后占位者会短暂等待消费者腾出槽位
+		***************************************************/
+		bool tryPush(T&& v)
+		{
+			uint64_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_head.load(std::memory_order_acquire) >= m_capacity)
+			{
+				return false;
+			}
+			push(std::move(v));
+			return true;
+		}
+
+		//入队，队列已满时等待消费者腾出槽位
+		void push(T&& v)
+		{
+			uint64_t pos = m_tail.fetch_add(1, std::memory_order_relaxed);
+			Cell& cell = m_cells[pos & m_mask];
+			while (cell.seq.load(std::memory_order_acquire) != pos)
+			{
+				std::this_thread::yield();
+			}
+			cell.data = std::move(v);
+			cell.seq.store(pos + 1, std::memory_order_release);
+		}
+
+		//仅限消费者线程调用，队列为空返回false
+		bool tryPop(T& v)
+		{
+			uint64_t head = m_head.load(std::memory_order_relaxed);
+			Cell& cell = m_cells[head & m_mask];
+			if (cell.seq.load(std::memory_order_acquire) != head + 1)
+			{
+				return false;
+			}
+			v = std::move(cell.data);
+			cell.seq.store(head + m_capacity, std::memory_order_release);
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool full() const
+		{
+			return m_tail.load(std::memory_order_relaxed)
+				- m_head.load(std::memory_order_acquire) >= m_capacity;
+		}
+
+		//近似值，仅用于统计
+		size_t size() const
+		{
+			uint64_t head = m_head.load(std::memory_order_acquire);
+			uint64_t tail = m_tail.load(std::memory_order_relaxed);
+			return tail > head ? static_cast<size_t>(tail - head) : 0;
+		}
+
+		size_t capacity() const { return m_capacity; }
+		//按capacity创建的队列的实际容量
+		static size_t RoundCapacity(size_t capacity)
+		{
+			size_t rounded = 2;
+			while (rounded < capacity)
+			{
+				rounded <<= 1;
+			}
+			return rounded;
+		}
+	private:
+		struct Cell
+		{
+			std::atomic<uint64_t> seq{ 0 };
+			T data;
+		};
+
+		size_t m_capacity = 0;
+		size_t m_mask = 0;
+		std::unique_ptr<Cell[]> m_cells;
+
+		//生产者与消费者的游标分处不同缓存行，避免伪共享
+		alignas(64) std::atomic<uint64_t> m_tail{ 0 };
+		alignas(64) std::atomic<uint64_t> m_head{ 0 };
+	};
+}
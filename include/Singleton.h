@@ -31,7 +31,8 @@ namespace GameProjectServer
 	class SINGLETON_API SingletonPtr
 	{
 		public:
-		static std::shared_ptr<T> GetInstance()
+		//返回引用，调用方不需要持有时不增减引用计数
+		static const std::shared_ptr<T>& GetInstance()
 		{
 			static std::shared_ptr<T> v(new T);
 			return v;
@@ -5,4 +5,10 @@ namespace GameProjectServer
 {
 	uint32_t GetThreadId();
 	uint32_t GetFiberId();
+	//当前时间，自1970-01-01起的纳秒数
+	uint64_t GetCurrentTimeNS();
+	//进程启动至今的纳秒数，单调递增
+	uint64_t GetElapseNS();
+	//一次时钟读取同时得到当前时间与进程运行时间
+	void GetClockNS(uint64_t& time_ns, uint64_t& elapse_ns);
 }
\ No newline at end of file
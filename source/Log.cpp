@@ -8,134 +8,244 @@
 #include <cctype>
 #include <functional>
 #include <ctime>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
 #include <sstream>
+#include <algorithm>
+#include <csignal>
 #include <yaml-cpp/yaml.h>
 
 namespace GameProjectServer
 {
-
-	class MessageFormatItem : public LogFormatter::FormatItem {
-	public:
-		MessageFormatItem(const std::string& str = "") {}
-		void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override {
-			os << event->getMessage();
-		}
-	};
-
-	class LevelFormatItem : public LogFormatter::FormatItem {
+	/***************************************************
+		%d{...}时间格式渲染
+		格式按%3N/%6N/%9N拆成若干段strftime格式，
+		每个线程缓存最近一次渲染出的整段文本，
+		秒(格式中不含秒时为分钟)不变时只复制缓存，
+		再把亚秒位数字就地写入
+	***************************************************/
+	class LogFormatter::DateTimeFormatItem {
 	public:
-		LevelFormatItem(const std::string& str = "") {}
-		void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override {
-			os << LogLevel::ToString(level);
-		}
-	};
+		DateTimeFormatItem(const std::string& format)
+			: m_format(format.empty() ? "%Y-%m-%d %H:%M:%S" : format)
+		{
+			static std::atomic<uint32_t> s_id{ 0 };
+			m_id = ++s_id;
+			std::string seg;
+			for (size_t i = 0; i < m_format.size(); ++i)
+			{
+				if (m_format[i] != '%' || i + 1 >= m_format.size())
+				{
+					seg.append(1, m_format[i]);
+					continue;
+				}
+				char c = m_format[i + 1];
+				int width = 0;
+				if (c == 'N')
+				{
+					width = 9;
+					i += 1;
+				}
+				else if ((c == '3' || c == '6' || c == '9') && i + 2 < m_format.size()
+					&& m_format[i + 2] == 'N')
+				{
+					width = c - '0';
+					i += 2;
+				}
+				else
+				{
+					seg.append(m_format, i, 2);
+					++i;
+					continue;
+				}
+				if (m_segments.size() < kMaxFields)
+				{
+					m_segments.push_back({ seg, width });
+				}
+				seg.clear();
+			}
+			m_segments.push_back({ seg, 0 });
 
-	class ElapseFormatItem : public LogFormatter::FormatItem {
-	public:
-		ElapseFormatItem(const std::string& str = "") {}
-		void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override {
-			os << event->getElapse();
+			//只要格式中有秒级字段，缓存就按秒刷新
+			m_granularity = 60;
+			for (auto& i : m_segments)
+			{
+				for (size_t n = 0; n + 1 < i.format.size(); ++n)
+				{
+					if (i.format[n] != '%')
+					{
+						continue;
+					}
+					char c = i.format[n + 1];
+					if (c == 'E' || c == 'O')
+					{
+						c = n + 2 < i.format.size() ? i.format[n + 2] : c;
+					}
+					if (strchr("STscrX+", c))
+					{
+						m_granularity = 1;
+					}
+					++n;
+				}
+			}
 		}
-	};
 
-	class NameFormatItem : public LogFormatter::FormatItem {
-	public:
-		NameFormatItem(const std::string& str = "") {}
-		void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override {
-			os << event->getLogger()->getName();
+		void format(LogBuffer& buf, uint64_t ns) const
+		{
+			static thread_local Cache s_caches[kCacheSlots];
+			Cache& cache = s_caches[m_id % kCacheSlots];
+			uint64_t sec = ns / 1000000000;
+			uint64_t key = sec / m_granularity;
+			if (cache.id != m_id || cache.key != key)
+			{
+				render(cache, sec);
+				cache.id = m_id;
+				cache.key = key;
+			}
+			char* p = buf.prepare(cache.length);
+			memcpy(p, cache.text, cache.length);
+			if (cache.fields)
+			{
+				//亚秒位不在缓存内，每条日志就地改写
+				uint32_t subsec = static_cast<uint32_t>(ns % 1000000000);
+				for (uint32_t i = 0; i < cache.fields; ++i)
+				{
+					uint32_t v = subsec;
+					for (int n = m_segments[i].width; n < 9; ++n)
+					{
+						v /= 10;
+					}
+					for (int n = m_segments[i].width - 1; n >= 0; --n)
+					{
+						p[cache.positions[i] + n] = static_cast<char>('0' + v % 10);
+						v /= 10;
+					}
+				}
+			}
+			buf.commit(cache.length);
 		}
-	};
+	private:
+		static constexpr uint32_t kCacheSlots = 16;
+		static constexpr uint32_t kMaxFields = 4;
+		static constexpr uint32_t kMaxLength = 128;
 
-	class ThreadIdFormatItem : public LogFormatter::FormatItem {
-	public:
-		ThreadIdFormatItem(const std::string& str = "") {}
-		void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override {
-			os << event->getThreadId();
-		}
-	};
+		struct Segment {
+			std::string format;     //strftime格式
+			int width;              //其后亚秒字段的位数，0表示没有
+		};
 
-	class FiberIdFormatItem : public LogFormatter::FormatItem {
-	public:
-		FiberIdFormatItem(const std::string& str = "") {}
-		void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override {
-			os << event->getFiberId();
-		}
-	};
+		struct Cache {
+			uint32_t id = 0;                    //所属DateTimeFormatItem
+			uint64_t key = 0;                   //缓存对应的秒/分钟
+			uint32_t length = 0;                //text长度
+			uint32_t fields = 0;                //亚秒字段个数
+			uint32_t positions[kMaxFields];     //亚秒字段在text中的位置
+			char text[kMaxLength];
+		};
 
-	class DateTimeFormatItem : public LogFormatter::FormatItem {
-	public:
-		DateTimeFormatItem(const std::string& format = "%Y-%m-%d %H:%M:%S")
-			: m_format(format)
+		void render(Cache& cache, uint64_t sec) const
 		{
-			if (m_format.empty())
-			{
-				m_format = "%Y-%m-%d %H:%M:%S";
-			}
-		}
-		void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override {
 			tm tm_time;
-			time_t t = event->getTime();
+			time_t t = static_cast<time_t>(sec);
 			localtime_s(&tm_time, &t);
-			char buf[64];
-			strftime(buf, sizeof(buf), m_format.c_str(), &tm_time);
-			os << buf;
+			cache.length = 0;
+			cache.fields = 0;
+			for (auto& i : m_segments)
+			{
+				if (!i.format.empty())
+				{
+					cache.length += static_cast<uint32_t>(strftime(cache.text + cache.length,
+						kMaxLength - cache.length, i.format.c_str(), &tm_time));
+				}
+				if (i.width == 0)
+				{
+					continue;
+				}
+				if (cache.length + i.width > kMaxLength)
+				{
+					break;
+				}
+				cache.positions[cache.fields++] = cache.length;
+				cache.length += i.width;
+			}
 		}
 	private:
-		std::string m_format;
+		std::string m_format;               //原始时间格式
+		uint32_t m_id;                      //线程缓存使用的标识
+		uint32_t m_granularity;             //缓存刷新粒度(秒)
+		std::vector<Segment> m_segments;    //按亚秒字段拆分的格式
 	};
 
-	class FilenameFormatItem : public LogFormatter::FormatItem {
-	public:
-		FilenameFormatItem(const std::string& str = "") {}
-		void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override {
-			os << event->getFile();
-		}
-	};
+	LogEvent::LogEvent(std::shared_ptr<Logger> logger, LogLevel::Level level,
+		const char* file, uint32_t line, uint32_t elapse,
+		uint32_t thread_id, uint32_t fiber_id, uint64_t time_ns)
+		: m_file(file), m_line(line), m_elapse(elapse * 1000000ULL),
+		m_threadId(thread_id), m_fiberId(fiber_id), m_time(time_ns), m_logger(logger), m_level(level)
+	{
+	}
 
-	class NewLineFormatItem : public LogFormatter::FormatItem {
-	public:
-		NewLineFormatItem(const std::string& str = "") {}
-		void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override {
-			os << std::endl;
-		}
-	};
+	LogEvent::LogEvent(std::shared_ptr<Logger> logger, LogLevel::Level level,
+		const char* file, uint32_t line, uint32_t thread_id, uint32_t fiber_id)
+		: m_file(file), m_line(line), m_threadId(thread_id), m_fiberId(fiber_id),
+		m_logger(logger), m_level(level)
+	{
+		GetClockNS(m_time, m_elapse);
+	}
 
-	class LineFormatItem : public LogFormatter::FormatItem {
-	public:
-		LineFormatItem(const std::string& str = "") {}
-		void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override {
-			os << event->getLine();
-		}
-	};
+	//线程内的LogEvent对象池
+	struct LogEventPool
+	{
+		static constexpr size_t kMaxSize = 64;
 
-	class StringFormatItem : public LogFormatter::FormatItem {
-	public:
-		StringFormatItem(const std::string& str)
-			: m_string(str)
+		LogEventPool()
 		{
+			events.reserve(kMaxSize);
 		}
-		void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override {
-			os << m_string;
+		~LogEventPool()
+		{
+			alive = false;
 		}
-	private:
-		std::string m_string;
+
+		std::vector<LogEvent::ptr> events;
+		bool alive = true;      //线程退出析构后不再使用
 	};
 
-	class TabFormatItem : public LogFormatter::FormatItem {
-		public:
-		TabFormatItem(const std::string& str = "") {}
-		void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override {
-			os << "\t";
+	static thread_local LogEventPool t_event_pool;
+
+	LogEvent::ptr LogEvent::Acquire(const std::shared_ptr<Logger>& logger, LogLevel::Level level,
+		const char* file, uint32_t line, uint32_t thread_id, uint32_t fiber_id)
+	{
+		if (!t_event_pool.alive || t_event_pool.events.empty())
+		{
+			return std::make_shared<LogEvent>(logger, level, file, line, thread_id, fiber_id);
 		}
-	};
+		LogEvent::ptr event = std::move(t_event_pool.events.back());
+		t_event_pool.events.pop_back();
+		event->m_logger = logger;
+		event->m_level = level;
+		event->m_file = file;
+		event->m_line = line;
+		event->m_threadId = thread_id;
+		event->m_fiberId = fiber_id;
+		GetClockNS(event->m_time, event->m_elapse);
+		return event;
+	}
 
-	LogEvent::LogEvent(std::shared_ptr<Logger> logger, LogLevel::Level level,
-		const char* file, uint32_t line, uint32_t elapse,
-		uint32_t thread_id, uint32_t fiber_id, std::u16streampos time)
-		: m_logger(logger), m_level(level), m_file(file), m_line(line),
-		m_elapse(elapse), m_threadId(thread_id), m_fiberId(fiber_id), m_time(time)
+	void LogEvent::Recycle(LogEvent::ptr&& event)
 	{
+		//仍被异步队列等持有的事件由最后的持有者释放
+		if (!event || event.use_count() != 1 || !t_event_pool.alive
+			|| t_event_pool.events.size() >= LogEventPool::kMaxSize)
+		{
+			event.reset();
+			return;
+		}
+		event->m_logger.reset();
+		event->m_ss.reset();
+		event->m_fields.clear();
+		event->m_textFormatter = 0;
+		t_event_pool.events.push_back(std::move(event));
 	}
 
 	void LogEvent::format(const char* fmt, ...)
@@ -148,50 +258,51 @@ namespace GameProjectServer
 
 	void LogEvent::format(const char* fmt, va_list al)
 	{
-		char* buf = nullptr;
-
-		auto vasprintf = [&fmt, &al](char** str)->int 
-			{
-			va_list args;
-			va_copy(args, al);
-			int len = vsnprintf(nullptr, 0, fmt, args);
-			va_end(args);
-			if (len < 0)
-			{
-				return -1;
-			}
-			*str = new char[len + 1];
-			if (*str == nullptr)
-			{
-				return -1;
-			}
-			return vsnprintf(*str, len + 1, fmt, al);
-			};
-
-		if (int len = vasprintf(&buf); len != -1)
+		//先直接写入消息缓冲区剩余空间，放不下时扩容后再格式化一次
+		LogBuffer& buf = m_ss.buffer();
+		char* p = buf.prepare(128);
+		size_t avail = buf.capacity() - buf.size();
+		va_list args;
+		va_copy(args, al);
+		int len = vsnprintf(p, avail, fmt, args);
+		va_end(args);
+		if (len < 0)
+		{
+			return;
+		}
+		if (static_cast<size_t>(len) >= avail)
 		{
-			m_ss << std::string(buf, len);
-			free(buf);
+			p = buf.prepare(len + 1);
+			vsnprintf(p, len + 1, fmt, al);
 		}
+		buf.commit(len);
 	}
 
 	Logger::Logger(const std::string& name)
 		: m_name(name), m_level(LogLevel::DEBUG)
 	{
-		m_formatter.reset(new LogFormatter("%d{%H:%M:%S %Y-%m-%d}%T%t%T%F%T[%p]%T[%c]%T<%f:%l>%T%m%n")); //默认格式
+		LoggerState* state = new LoggerState;
+		state->formatter.reset(new LogFormatter(LogFormatter::kDefaultPattern)); //默认格式
+		m_state.store(state, std::memory_order_release);
 	}
 
-	void Logger::setFormatter(LogFormatter::ptr formatter)
+	Logger::~Logger()
 	{
-		m_formatter = formatter;
+		m_queue.reset();
+		//日志器析构时已没有其他线程使用
+		delete m_state.load(std::memory_order_acquire);
+	}
 
-		for (auto& i : m_appenders)
+	void Logger::setFormatter(LogFormatter::ptr formatter)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto state = copyState();
+		state->formatter = formatter;
+		for (auto& i : state->appenders)
 		{
-			if (!i->m_hasFormatter)
-			{
-				i->m_formatter = m_formatter;
-			}
+			i->inheritFormatter(formatter);
 		}
+		publish(std::move(state));
 	}
 
 	void Logger::setFormatter(const std::string& pattern)
@@ -208,7 +319,8 @@ namespace GameProjectServer
 
 	LogFormatter::ptr Logger::getFormatter() const
 	{
-		return m_formatter;
+		LogEpoch::Guard guard;
+		return m_state.load(std::memory_order_acquire)->formatter;
 	}
 
 	LogLevel::Level LogLevel::FromString(const std::string& str) 
@@ -245,178 +357,2510 @@ namespace GameProjectServer
 		}
 	}
 
-	LogEventWrap::LogEventWrap(LogEvent::ptr e)
-		: m_event(e)
+	LogOverflowPolicy::Policy LogOverflowPolicy::FromString(const std::string& str)
 	{
+		std::string upper_str = str;
+		transform(upper_str.begin(), upper_str.end(), upper_str.begin(), ::toupper);
+#define XX(policy) \
+		if (upper_str == #policy) {\
+			return LogOverflowPolicy::policy;\
+		}
+		XX(BLOCK)
+		XX(DROP_NEWEST)
+		XX(DROP_BELOW_LEVEL)
+#undef XX
+		return LogOverflowPolicy::BLOCK;
 	}
 
-	LogEventWrap::~LogEventWrap()
+	const char* LogOverflowPolicy::ToString(Policy policy)
 	{
-		m_event->getLogger()->log(m_event->getLevel(), m_event);
+		switch (policy)
+		{
+#define XX(name)\
+			case LogOverflowPolicy::name:\
+				return #name;
+			XX(BLOCK)
+			XX(DROP_NEWEST)
+			XX(DROP_BELOW_LEVEL)
+#undef XX
+			default:
+				return "BLOCK";
+		}
 	}
 
-	void Logger::log(LogLevel::Level level, LogEvent::ptr event)
+	LogEventQueue::LogEventQueue(Logger* logger, size_t capacity)
+		: m_logger(logger), m_queue(capacity)
 	{
-		if (level >= m_level)
+	}
+
+	LogEventQueue::~LogEventQueue()
+	{
+		stop();
+	}
+
+	bool LogEventQueue::push(LogLevel::Level level, LogEvent::ptr&& event)
+	{
+		Item item(level, std::move(event));
+		switch (m_policy.load(std::memory_order_relaxed))
 		{
-			auto self = shared_from_this();
-			if (!m_appenders.empty())
-			{
-				for (auto& appender : m_appenders)
+			case LogOverflowPolicy::DROP_NEWEST:
+				if (!m_queue.tryPush(std::move(item)))
 				{
-					appender->log(self, level, event);
+					m_dropped.fetch_add(1, std::memory_order_relaxed);
+					return false;
 				}
-			}
-			else if (m_root)
-			{
-				m_root->log(level, event);
-			}
+				notify();
+				return true;
+			case LogOverflowPolicy::DROP_BELOW_LEVEL:
+				if (level < m_dropLevel.load(std::memory_order_relaxed))
+				{
+					if (!m_queue.tryPush(std::move(item)))
+					{
+						m_dropped.fetch_add(1, std::memory_order_relaxed);
+						return false;
+					}
+					notify();
+					return true;
+				}
+				break;
+			default:
+				break;
+		}
+		if (m_queue.full())
+		{
+			m_blocked.fetch_add(1, std::memory_order_relaxed);
 		}
+		m_queue.push(std::move(item));
+		notify();
+		return true;
 	}
 
-	void Logger::debug(LogEvent::ptr event)
+	void LogEventQueue::notify()
 	{
-		log(LogLevel::DEBUG, event);
+		//写线程忙碌时不必唤醒，避免每条日志都进入内核
+		if (m_waiting.load())
+		{
+			m_cond.notify_one();
+		}
 	}
 
-	void Logger::info(LogEvent::ptr event)
+	void LogEventQueue::setPolicy(LogOverflowPolicy::Policy policy, LogLevel::Level drop_level)
 	{
-		log(LogLevel::INFO, event);
+		m_policy.store(policy, std::memory_order_relaxed);
+		m_dropLevel.store(drop_level, std::memory_order_relaxed);
 	}
 
-	void Logger::warn(LogEvent::ptr event)
+	void LogEventQueue::start()
 	{
-		log(LogLevel::WARN, event);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_running.load())
+		{
+			return;
+		}
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+		m_running.store(true);
+		m_thread = std::thread(&LogEventQueue::run, this);
 	}
 
-	void Logger::error(LogEvent::ptr event)
+	void LogEventQueue::stop()
 	{
-		log(LogLevel::ERROR, event);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_running.store(false);
+		}
+		m_cond.notify_one();
+		if (!m_thread.joinable())
+		{
+			return;
+		}
+		if (m_thread.get_id() == std::this_thread::get_id())
+		{
+			m_thread.detach();
+			return;
+		}
+		m_thread.join();
+		//写线程退出后才入队的日志
+		Item item;
+		while (m_queue.tryPop(item))
+		{
+			m_logger->dispatch(item.first, item.second);
+			item.second.reset();
+		}
 	}
 
-	void Logger::fatal(LogEvent::ptr event)
+	void LogEventQueue::run()
 	{
-		log(LogLevel::FATAL, event);
+		//写线程运行期间保证日志器存活
+		Logger::ptr self = m_logger->shared_from_this();
+		Item item;
+		while (true)
+		{
+			if (m_queue.tryPop(item))
+			{
+				m_logger->dispatch(item.first, item.second);
+				item.second.reset();
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (!m_running.load() && m_queue.size() == 0)
+			{
+				break;
+			}
+			m_waiting.store(true);
+			if (m_queue.size() == 0 && m_running.load())
+			{
+				//超时兜底，防止错过唤醒
+				m_cond.wait_for(lock, std::chrono::milliseconds(10));
+			}
+			m_waiting.store(false);
+		}
 	}
 
-	void Logger::addAppender(LogAppender::ptr appender)
+	LogEventWrap::LogEventWrap(LogEvent::ptr e, LogSite* site, uint64_t suppressed)
+		: m_event(std::move(e))
+		, m_site(site)
+		, m_suppressed(suppressed)
 	{
-		if (!appender->getFormatter())
+	}
+
+	LogEventWrap::~LogEventWrap()
+	{
+		if (m_suppressed)
+		{
+			m_event->getSS() << " (" << m_suppressed << " suppressed)";
+		}
+		if (m_site)
 		{
-			appender->m_formatter = m_formatter;
+			m_site->emit(m_event->getMessageBuffer().size());
 		}
-		m_appenders.push_back(appender);
+		m_event->getLogger()->log(m_event->getLevel(), m_event);
+		LogEvent::Recycle(std::move(m_event));
 	}
 
-	void Logger::delAppender(LogAppender::ptr appender)
+	void Logger::log(LogLevel::Level level, LogEvent::ptr event)
 	{
-		m_appenders.remove(appender);
+		if (isEnabled(level))
+		{
+			if (m_async.load(std::memory_order_acquire))
+			{
+				//setSync等待临界区内的入队完成后才停止写线程
+				LogEpoch::Guard guard;
+				if (m_async.load(std::memory_order_acquire))
+				{
+					m_queue->push(level, std::move(event));
+					return;
+				}
+			}
+			dispatch(level, event);
+		}
 	}
 
-	void Logger::clearAppenders()
+	void Logger::dispatch(LogLevel::Level level, LogEvent::ptr event)
 	{
-		m_appenders.clear();
+		//快照及其中的appender、格式器在临界区内不会被释放
+		LogEpoch::Guard guard;
+		const LoggerState* state = m_state.load(std::memory_order_acquire);
+		if (state->appenders.empty())
+		{
+			if (m_root)
+			{
+				m_root->log(level, event);
+			}
+			return;
+		}
+		auto self = shared_from_this();
+		if (NST_LIKELY(level >= LogLevel::UNKNOW && level <= LogLevel::FATAL
+			&& state->generation == LogAppender::GetLevelGeneration()))
+		{
+			for (LogAppender* appender : state->dispatch[level])
+			{
+				appender->log(self, level, event);
+			}
+			return;
+		}
+		for (auto& appender : state->appenders)
+		{
+			appender->log(self, level, event);
+		}
+		//分发表过期，没有其他写者时顺带重建，有则留给下一次分发
+		if (m_mutex.try_lock())
+		{
+			std::lock_guard<std::mutex> lock(m_mutex, std::adopt_lock);
+			publish(copyState());
+		}
 	}
 
-	LogAppender::LogAppender()
-		: m_level(LogLevel::DEBUG), m_hasFormatter(false)
+	std::unique_ptr<LoggerState> Logger::copyState() const
 	{
+		const LoggerState* state = m_state.load(std::memory_order_acquire);
+		std::unique_ptr<LoggerState> copy(new LoggerState);
+		copy->level = state->level;
+		copy->formatter = state->formatter;
+		copy->appenders = state->appenders;
+		return copy;
 	}
 
-	void LogAppender::setFormatter(LogFormatter::ptr formatter)
+	void Logger::publish(std::unique_ptr<LoggerState> state)
 	{
-		m_formatter = formatter;
-		if (m_formatter)
+		//先取版本再读级别，期间被修改的级别会使版本不一致，分发时回退
+		state->generation = LogAppender::GetLevelGeneration();
+		state->binaryAppenders.clear();
+		for (auto& appender : state->appenders)
 		{
-			m_hasFormatter = true;
+			if (auto binary = std::dynamic_pointer_cast<BinaryLogAppender>(appender))
+			{
+				state->binaryAppenders.push_back(binary);
+			}
 		}
-		else
+		for (int level = LogLevel::UNKNOW; level <= LogLevel::FATAL; ++level)
 		{
-			m_hasFormatter = false;
+			std::vector<LogAppender*>& table = state->dispatch[level];
+			table.clear();
+			if (level < state->level)
+			{
+				continue;
+			}
+			for (auto& appender : state->appenders)
+			{
+				if (level >= appender->getLevel())
+				{
+					table.push_back(appender.get());
+				}
+			}
 		}
+		m_hasBinary.store(!state->binaryAppenders.empty(), std::memory_order_relaxed);
+		LogLevel::Level level = state->level;
+		LoggerState* old = m_state.exchange(state.release(), std::memory_order_acq_rel);
+		//新快照发布后再放开级别，通过级别判断的日志总能找到对应的分发表
+		m_level.store(level, std::memory_order_release);
+		LogEpoch::Retire(old);
 	}
 
-	FileLogAppender::FileLogAppender(const std::string& filename)
-		: m_filename(filename)
+	void Logger::setLevel(LogLevel::Level level)
 	{
-		reopen();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto state = copyState();
+		state->level = level;
+		publish(std::move(state));
 	}
 
-	bool FileLogAppender::reopen()
+	void Logger::setAsync(size_t capacity, LogOverflowPolicy::Policy policy, LogLevel::Level drop_level)
 	{
-		if (m_filestream)
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_queue && m_queue->getCapacity() != LogEventQueue::RoundCapacity(capacity))
+		{
+			//没有线程再读取旧队列后才替换
+			stopQueue();
+			m_queue.reset();
+		}
+		if (!m_queue)
 		{
-			m_filestream.close();
+			m_queue.reset(new LogEventQueue(this, capacity));
 		}
-		m_filestream.open(m_filename);
-		return !!m_filestream;
+		m_queue->setPolicy(policy, drop_level);
+		m_queue->start();
+		m_async.store(true, std::memory_order_release);
 	}
 
-	void FileLogAppender::log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event)
+	void Logger::setSync()
 	{
-		if (level >= m_level)
+		std::lock_guard<std::mutex> lock(m_mutex);
+		stopQueue();
+	}
+
+	void Logger::stopQueue()
+	{
+		if (!m_queue)
 		{
-			m_filestream << m_formatter->format(logger, level, event);
+			return;
 		}
+		m_async.store(false, std::memory_order_release);
+		//写线程仍在运行，阻塞在满队列上的生产者可以完成入队
+		LogEpoch::Synchronize();
+		m_queue->stop();
+	}
+
+	uint64_t Logger::getDroppedCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_queue ? m_queue->getDroppedCount() : 0;
+	}
+
+	uint64_t Logger::getBlockedCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_queue ? m_queue->getBlockedCount() : 0;
+	}
+
+	void Logger::debug(LogEvent::ptr event)
+	{
+		log(LogLevel::DEBUG, event);
+	}
+
+	void Logger::info(LogEvent::ptr event)
+	{
+		log(LogLevel::INFO, event);
+	}
+
+	void Logger::warn(LogEvent::ptr event)
+	{
+		log(LogLevel::WARN, event);
+	}
+
+	void Logger::error(LogEvent::ptr event)
+	{
+		log(LogLevel::ERROR, event);
+	}
+
+	void Logger::fatal(LogEvent::ptr event)
+	{
+		log(LogLevel::FATAL, event);
+	}
+
+	void Logger::addAppender(LogAppender::ptr appender)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto state = copyState();
+		if (!appender->getFormatter())
+		{
+			appender->inheritFormatter(state->formatter);
+		}
+		state->appenders.push_back(appender);
+		publish(std::move(state));
+	}
+
+	void Logger::delAppender(LogAppender::ptr appender)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto state = copyState();
+		auto it = std::find(state->appenders.begin(), state->appenders.end(), appender);
+		if (it == state->appenders.end())
+		{
+			return;
+		}
+		state->appenders.erase(it);
+		publish(std::move(state));
+	}
+
+	void Logger::clearAppenders()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto state = copyState();
+		state->appenders.clear();
+		publish(std::move(state));
+	}
+
+	std::vector<LogAppender::ptr> Logger::getAppenders() const
+	{
+		LogEpoch::Guard guard;
+		return m_state.load(std::memory_order_acquire)->appenders;
+	}
+
+	void Logger::reconfigure(LogLevel::Level level, LogFormatter::ptr formatter,
+		const std::vector<LogAppender::ptr>& appenders)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto state = copyState();
+		state->level = level;
+		if (formatter)
+		{
+			state->formatter = formatter;
+		}
+		state->appenders = appenders;
+		for (auto& i : state->appenders)
+		{
+			i->inheritFormatter(state->formatter);
+		}
+		publish(std::move(state));
+	}
+
+	uint32_t Logger::getBinaryId()
+	{
+		uint32_t id = m_binaryId.load(std::memory_order_relaxed);
+		if (id == 0)
+		{
+			//同名日志器得到同一id，并发注册结果相同
+			id = LogBinaryRegisterLogger(m_name);
+			m_binaryId.store(id, std::memory_order_relaxed);
+		}
+		return id;
+	}
+
+	void Logger::writeBinary(LogLevel::Level level, uint32_t site, const LogBuffer& record)
+	{
+		uint32_t logger = getBinaryId();
+		LogEpoch::Guard guard;
+		for (auto& i : m_state.load(std::memory_order_acquire)->binaryAppenders)
+		{
+			if (level >= i->m_level)
+			{
+				i->appendRecord(site, logger, record);
+			}
+		}
+	}
+
+	static std::atomic<uint64_t> s_appender_level_generation{ 0 };
+
+	LogAppender::LogAppender()
+		: m_level(LogLevel::DEBUG), m_hasFormatter(false)
+	{
+	}
+
+	void LogAppender::setLevel(LogLevel::Level level)
+	{
+		m_level = level;
+		s_appender_level_generation.fetch_add(1, std::memory_order_release);
+	}
+
+	uint64_t LogAppender::GetLevelGeneration()
+	{
+		return s_appender_level_generation.load(std::memory_order_acquire);
+	}
+
+	void LogAppender::setFormatter(LogFormatter::ptr formatter)
+	{
+		std::lock_guard<std::mutex> lock(m_formatterMutex);
+		m_hasFormatter = formatter != nullptr;
+		publishFormatter(std::move(formatter));
+	}
+
+	LogFormatter::ptr LogAppender::getFormatter() const
+	{
+		std::lock_guard<std::mutex> lock(m_formatterMutex);
+		return m_formatter;
+	}
+
+	void LogAppender::inheritFormatter(const LogFormatter::ptr& formatter)
+	{
+		std::lock_guard<std::mutex> lock(m_formatterMutex);
+		if (!m_hasFormatter && m_formatter != formatter)
+		{
+			publishFormatter(formatter);
+		}
+	}
+
+	void LogAppender::publishFormatter(LogFormatter::ptr formatter)
+	{
+		m_formatterPtr.store(formatter.get(), std::memory_order_release);
+		m_formatter.swap(formatter);
+		//正在输出的线程可能仍在使用旧格式器，交给LogEpoch延迟释放引用
+		if (formatter)
+		{
+			LogEpoch::Retire(new LogFormatter::ptr(std::move(formatter)));
+		}
+	}
+
+	//YAML中输出与默认值不同的刷新策略项
+	static void FlushPolicyToYaml(YAML::Node& node, const LogFlushPolicy& policy, size_t buffer_size)
+	{
+		LogFlushPolicy def;
+		if (buffer_size != LogFileWriter::kDefaultBufferSize)
+		{
+			node["buffer_size"] = buffer_size;
+		}
+		if (policy.newline != def.newline)
+		{
+			node["flush_newline"] = policy.newline;
+		}
+		if (policy.bytes != def.bytes)
+		{
+			node["flush_bytes"] = policy.bytes;
+		}
+		if (policy.interval != def.interval)
+		{
+			node["flush_interval"] = policy.interval;
+		}
+		if (policy.level != def.level)
+		{
+			node["flush_level"] = LogLevel::ToString(policy.level);
+		}
+	}
+
+	//YAML中输出设置了的轮转策略项
+	static void RotatePolicyToYaml(YAML::Node& node, const LogRotatePolicy& policy)
+	{
+		if (policy.size)
+		{
+			node["rotate_size"] = policy.size;
+		}
+		if (policy.interval)
+		{
+			node["rotate_interval"] = policy.interval;
+		}
+		if (policy.max_files)
+		{
+			node["max_files"] = policy.max_files;
+		}
+		if (policy.preallocate)
+		{
+			node["preallocate"] = policy.preallocate;
+		}
+	}
+
+	//YAML中输出重复日志合并设置，interval为0时不输出
+	static void CoalesceToYaml(YAML::Node& node, uint32_t interval)
+	{
+		if (interval)
+		{
+			node["coalesce"] = true;
+			if (interval != LogRepeatFilter::kDefaultInterval)
+			{
+				node["coalesce_interval"] = interval;
+			}
+		}
+	}
+
+	//YAML中输出压缩设置，不压缩时不输出
+	static void CompressToYaml(YAML::Node& node, const LogCompressPolicy& policy)
+	{
+		if (policy.enabled)
+		{
+			node["compress"] = true;
+			node["compress_level"] = policy.level;
+			node["compress_block_size"] = policy.block_size;
+		}
+	}
+
+	//YAML中输出索引设置，不写索引时不输出
+	static void IndexToYaml(YAML::Node& node, uint32_t interval)
+	{
+		if (interval)
+		{
+			node["index"] = true;
+			if (interval != LogFileIndex::kDefaultInterval)
+			{
+				node["index_interval"] = interval;
+			}
+		}
+	}
+
+	//经索引写入日志文件，附带当前日志的时间与级别
+	struct LogIndexSink
+	{
+		LogFileIndex& index;
+		uint64_t time;
+		uint8_t level;
+
+		void write(const char* data, size_t len, bool flush) { index.write(data, len, flush, time, level); }
+	};
+
+	FileLogAppender::FileLogAppender(const std::string& filename, size_t buffer_size,
+		const LogCompressPolicy& compress, uint32_t index_interval)
+		: m_filename(filename)
+		, m_writer(std::make_shared<LogFileWriter>(buffer_size))
+	{
+		reopen();
+		if (compress.enabled)
+		{
+			m_gzip = LogGzipWriter::Create(m_writer, compress);
+			if (!m_gzip)
+			{
+				std::cout << "log file " << filename << " compress init failed, writing uncompressed" << std::endl;
+			}
+		}
+		if (index_interval && m_gzip)
+		{
+			std::cout << "log file " << filename << " is compressed, index is not written" << std::endl;
+		}
+		else if (index_interval)
+		{
+			m_index = LogFileIndex::Open(filename, m_writer, index_interval);
+			if (!m_index)
+			{
+				std::cout << "log file " << filename << " index open failed" << std::endl;
+			}
+		}
+		setFlushPolicy(m_flushPolicy);
+	}
+
+	FileLogAppender::~FileLogAppender()
+	{
+		if (m_gzip)
+		{
+			m_repeat.flush(*m_gzip);
+		}
+		else if (m_index)
+		{
+			LogIndexSink sink{ *m_index, 0, 0 };
+			m_repeat.flush(sink);
+		}
+		else
+		{
+			m_repeat.flush(*m_writer);
+		}
+	}
+
+	void FileLogAppender::setRotatePolicy(const LogRotatePolicy& policy)
+	{
+		//索引中的偏移属于同一个文件，轮转后失效
+		if (m_index && policy.enabled())
+		{
+			std::cout << "log file " << m_filename << " writes an index, rotation is ignored" << std::endl;
+			return;
+		}
+		m_writer->setRotatePolicy(policy);
+	}
+
+	bool FileLogAppender::reopen()
+	{
+		return m_writer->open(m_filename, true);
+	}
+
+	void FileLogAppender::setFlushPolicy(const LogFlushPolicy& policy)
+	{
+		m_flushPolicy = policy;
+		m_writer->setFlushBytes(policy.bytes);
+		m_writer->setFlushInterval(policy.interval);
+		if (m_gzip)
+		{
+			m_gzip->setFlushInterval(policy.interval);
+		}
+	}
+
+	void FileLogAppender::log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event)
+	{
+		if (level >= m_level)
+		{
+			auto render = [&]() -> const LogBuffer& { return formatter()->render(level, *event); };
+			if (m_gzip)
+			{
+				m_repeat.write(*m_gzip, level, *event, m_flushPolicy.flushOn(level), render);
+			}
+			else if (m_index)
+			{
+				LogIndexSink sink{ *m_index, event->getTime(), static_cast<uint8_t>(level) };
+				m_repeat.write(sink, level, *event, m_flushPolicy.flushOn(level), render);
+			}
+			else
+			{
+				m_repeat.write(*m_writer, level, *event, m_flushPolicy.flushOn(level), render);
+			}
+		}
+	}
+
+	void FileLogAppender::flush()
+	{
+		if (m_gzip)
+		{
+			m_repeat.flush(*m_gzip);
+			m_gzip->flush();
+		}
+		else if (m_index)
+		{
+			LogIndexSink sink{ *m_index, 0, 0 };
+			m_repeat.flush(sink);
+			m_index->flush();
+		}
+		else
+		{
+			m_repeat.flush(*m_writer);
+		}
+		m_writer->flush();
+	}
+
+	std::string FileLogAppender::toYamlString()
+	{
+		YAML::Node node;
+		node["type"] = "FileLogAppender";
+		node["file"] = m_filename;
+		FlushPolicyToYaml(node, m_flushPolicy, m_writer->getBufferSize());
+		RotatePolicyToYaml(node, m_writer->getRotatePolicy());
+		CoalesceToYaml(node, m_repeat.getInterval());
+		CompressToYaml(node, getCompressPolicy());
+		IndexToYaml(node, m_index ? m_index->getInterval() : 0);
+		if (m_level != LogLevel::UNKNOW)
+		{
+			node["level"] = LogLevel::ToString(m_level);
+		}
+		LogFormatter::ptr formatter = getFormatter();
+		if (m_hasFormatter && formatter)
+		{
+			node["formatter"] = formatter->getPattern();
+		}
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
+	MmapLogAppender::MmapLogAppender(const std::string& filename, uint64_t segment_size)
+		: m_filename(filename)
+		, m_segmentSize(segment_size ? segment_size : kDefaultSegmentSize)
+	{
+		//接在已有的段之后，不覆盖上次运行(可能是崩溃)留下的段
+		while (std::ifstream(getSegmentName(m_lastIndex + 1)).good())
+		{
+			++m_lastIndex;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		roll();
+	}
+
+	bool MmapLogAppender::roll()
+	{
+		m_segment.reset();
+		m_segment = LogMmapSegment::Create(getSegmentName(m_lastIndex + 1), m_segmentSize, m_lastIndex + 1);
+		if (!m_segment)
+		{
+			return false;
+		}
+		++m_lastIndex;
+		return true;
+	}
+
+	void MmapLogAppender::log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event)
+	{
+		if (level >= m_level)
+		{
+			const LogBuffer& line = formatter()->render(level, *event);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_segment && m_segment->append(line.data(), line.size()))
+			{
+				return;
+			}
+			if (!roll())
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			//超过一个段的日志截断
+			size_t len = line.size() < m_segment->getCapacity() ? line.size() : static_cast<size_t>(m_segment->getCapacity());
+			m_segment->append(line.data(), len);
+		}
+	}
+
+	void MmapLogAppender::flush()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_segment)
+		{
+			m_segment->sync();
+		}
+	}
+
+	uint64_t MmapLogAppender::getSegmentIndex()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_segment ? m_segment->getIndex() : 0;
+	}
+
+	std::string MmapLogAppender::toYamlString()
+	{
+		YAML::Node node;
+		node["type"] = "MmapLogAppender";
+		node["file"] = m_filename;
+		if (m_segmentSize != kDefaultSegmentSize)
+		{
+			node["segment_size"] = m_segmentSize;
+		}
+		if (m_level != LogLevel::UNKNOW)
+		{
+			node["level"] = LogLevel::ToString(m_level);
+		}
+		LogFormatter::ptr formatter = getFormatter();
+		if (m_hasFormatter && formatter)
+		{
+			node["formatter"] = formatter->getPattern();
+		}
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
+	//飞行记录器中的一条日志，只保存原始字段
+	struct RingBufferLogAppender::Record
+	{
+		uint64_t time;
+		uint64_t elapse;
+		uint32_t threadId;
+		uint32_t fiberId;
+		uint32_t line;
+		LogLevel::Level level;
+		const char* file;
+		Logger* logger;                 //由记录环的loggers保持存活
+		uint32_t length;                //消息长度
+		char message[kMessageSize];
+	};
+
+	/***************************************************
+		一个线程的记录环，只有所属线程写入，不加锁；
+		每个位置有一个序号，写入前置为2*pos+1，写完置为2*pos+2
+		(pos为记录的序号)，输出线程复制记录前后各读一次序号，
+		不一致或不是写完的值时丢弃复制的内容
+	***************************************************/
+	struct RingBufferLogAppender::Ring
+	{
+		explicit Ring(size_t capacity)
+			: records(capacity)
+			, seqs(new std::atomic<uint64_t>[capacity]())
+		{
+		}
+
+		std::vector<Record> records;
+		std::unique_ptr<std::atomic<uint64_t>[]> seqs;
+		std::atomic<uint64_t> head{ 0 };    //已写入的记录数，只由所属线程修改
+		uint64_t tail = 0;                  //已输出的位置，只由持有m_dumpMutex的输出线程访问
+		Logger* lastLogger = nullptr;       //上一条记录的日志器，只由所属线程访问
+		std::vector<Logger::ptr> loggers;   //记录引用过的日志器，只由所属线程修改
+		std::atomic<bool> owned{ true };    //是否被某个线程占用
+		std::atomic<bool> closed{ false };  //appender已析构
+	};
+
+	static std::atomic<uint64_t> s_ring_appender_id{ 0 };
+
+	//存活的飞行记录器，供信号处理函数输出；故意不释放
+	static std::mutex& GetRecorderMutex()
+	{
+		static std::mutex* s_mutex = new std::mutex;
+		return *s_mutex;
+	}
+
+	static std::vector<RingBufferLogAppender*>& GetRecorders()
+	{
+		static std::vector<RingBufferLogAppender*>* s_recorders = new std::vector<RingBufferLogAppender*>;
+		return *s_recorders;
+	}
+
+	//本地时间与UTC的差(秒)，在正常上下文中更新，信号处理中只读取
+	static std::atomic<int64_t> s_signal_utc_offset{ 0 };
+
+	//公历日期到1970-01-01起的天数
+	static int64_t LogDaysFromCivil(int64_t y, uint32_t m, uint32_t d)
+	{
+		y -= m <= 2;
+		int64_t era = (y >= 0 ? y : y - 399) / 400;
+		uint32_t yoe = static_cast<uint32_t>(y - era * 400);
+		uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+		uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+		return era * 146097 + static_cast<int64_t>(doe) - 719468;
+	}
+
+	static void UpdateSignalUtcOffset()
+	{
+		time_t now = time(nullptr);
+		tm local;
+		localtime_s(&local, &now);
+		int64_t local_sec = LogDaysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * 86400
+			+ local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+		s_signal_utc_offset.store(local_sec - static_cast<int64_t>(now), std::memory_order_relaxed);
+	}
+
+	static void LogAppendSignalDigits(LogBuffer& buf, uint32_t v, int width)
+	{
+		char* p = buf.prepare(width);
+		for (int i = width - 1; i >= 0; --i)
+		{
+			p[i] = static_cast<char>('0' + v % 10);
+			v /= 10;
+		}
+		buf.commit(width);
+	}
+
+	/***************************************************
+		信号处理中输出时间：YYYY-MM-DD HH:MM:SS.ffffff，
+		只做整数运算，按最近一次更新的UTC偏移换算为本地时间，
+		不调用localtime
+	***************************************************/
+	static void LogAppendSignalTime(LogBuffer& buf, uint64_t ns, int64_t offset)
+	{
+		int64_t sec = static_cast<int64_t>(ns / 1000000000) + offset;
+		int64_t z = (sec >= 0 ? sec : sec - 86399) / 86400 + 719468;
+		uint32_t secs = static_cast<uint32_t>(sec - (z - 719468) * 86400);
+		int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+		uint32_t doe = static_cast<uint32_t>(z - era * 146097);
+		uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+		uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+		uint32_t mp = (5 * doy + 2) / 153;
+		uint32_t d = doy - (153 * mp + 2) / 5 + 1;
+		uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+		int64_t y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+		LogAppendSignalDigits(buf, static_cast<uint32_t>(y), 4);
+		buf.append('-');
+		LogAppendSignalDigits(buf, m, 2);
+		buf.append('-');
+		LogAppendSignalDigits(buf, d, 2);
+		buf.append(' ');
+		LogAppendSignalDigits(buf, secs / 3600, 2);
+		buf.append(':');
+		LogAppendSignalDigits(buf, secs / 60 % 60, 2);
+		buf.append(':');
+		LogAppendSignalDigits(buf, secs % 60, 2);
+		buf.append('.');
+		LogAppendSignalDigits(buf, static_cast<uint32_t>(ns % 1000000000 / 1000), 6);
+	}
+
+	//信号处理中没有可写的目标文件时写标准错误；故意不释放
+	static LogFileWriter& GetSignalStderr()
+	{
+		static LogFileWriter* s_writer = []() {
+			LogFileWriter* writer = new LogFileWriter(4096);
+			writer->attach(2);
+			return writer;
+		}();
+		return *s_writer;
+	}
+
+	RingBufferLogAppender::RingBufferLogAppender(LogAppender::ptr target, size_t capacity, LogLevel::Level dump_level)
+		: m_target(target)
+		, m_capacity(capacity ? capacity : kDefaultCapacity)
+		, m_dumpLevel(dump_level)
+		, m_id(s_ring_appender_id.fetch_add(1, std::memory_order_relaxed) + 1)
+	{
+		//压缩的文件不能直接追加文本，与其他appender一样写标准错误
+		if (auto file = std::dynamic_pointer_cast<FileLogAppender>(m_target))
+		{
+			if (!file->getGzipWriter())
+			{
+				m_signalWriter = file->getWriter();
+			}
+		}
+		else if (auto out = std::dynamic_pointer_cast<StdoutLogAppender>(m_target))
+		{
+			m_signalWriter = out->getWriter();
+		}
+		GetSignalStderr();
+		UpdateSignalUtcOffset();
+		m_signalBuffer.prepare(kSignalBufferSize);
+
+		std::lock_guard<std::mutex> lock(GetRecorderMutex());
+		GetRecorders().push_back(this);
+	}
+
+	RingBufferLogAppender::~RingBufferLogAppender()
+	{
+		{
+			std::lock_guard<std::mutex> lock(GetRecorderMutex());
+			auto& recorders = GetRecorders();
+			recorders.erase(std::remove(recorders.begin(), recorders.end(), this), recorders.end());
+		}
+		//线程局部缓存中仍引用的记录环在线程下次查找时被清除
+		for (auto& i : m_rings)
+		{
+			i->closed.store(true, std::memory_order_release);
+		}
+	}
+
+	RingBufferLogAppender::Ring* RingBufferLogAppender::getRing()
+	{
+		//线程退出时归还记录环，其中的记录保留到被复用的线程覆盖
+		struct Handle
+		{
+			Handle(uint64_t i, std::shared_ptr<Ring> r) : id(i), ring(std::move(r)) {}
+			Handle(Handle&&) = default;
+			Handle& operator=(Handle&&) = default;
+			~Handle()
+			{
+				if (ring)
+				{
+					ring->owned.store(false, std::memory_order_release);
+				}
+			}
+
+			uint64_t id;
+			std::shared_ptr<Ring> ring;
+		};
+		static thread_local std::vector<Handle> s_rings;
+		for (auto& i : s_rings)
+		{
+			if (i.id == m_id)
+			{
+				return i.ring.get();
+			}
+		}
+		s_rings.erase(std::remove_if(s_rings.begin(), s_rings.end(), [](const Handle& h) {
+			return h.ring->closed.load(std::memory_order_acquire);
+		}), s_rings.end());
+
+		std::shared_ptr<Ring> ring;
+		{
+			//输出用的缓冲区随记录环扩容，与输出互斥
+			std::lock_guard<std::mutex> dump_lock(m_dumpMutex);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (auto& i : m_rings)
+			{
+				bool expected = false;
+				if (!i->owned.load(std::memory_order_relaxed)
+					&& i->owned.compare_exchange_strong(expected, true, std::memory_order_acquire))
+				{
+					ring = i;
+					break;
+				}
+			}
+			if (!ring)
+			{
+				ring = std::make_shared<Ring>(m_capacity);
+				m_rings.push_back(ring);
+				m_scratch.resize(m_rings.size() * m_capacity);
+				m_order.resize(m_scratch.size());
+			}
+		}
+		s_rings.emplace_back(m_id, ring);
+		return ring.get();
+	}
+
+	size_t RingBufferLogAppender::getRingCount()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_rings.size();
+	}
+
+	void RingBufferLogAppender::log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event)
+	{
+		if (level < m_level)
+		{
+			return;
+		}
+		Ring* ring = getRing();
+		uint64_t pos = ring->head.load(std::memory_order_relaxed);
+		size_t index = pos % m_capacity;
+		std::atomic<uint64_t>& seq = ring->seqs[index];
+		seq.store(pos * 2 + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		if (ring->lastLogger != logger.get())
+		{
+			//记录只保存裸指针，日志器由记录环持有
+			if (std::find(ring->loggers.begin(), ring->loggers.end(), logger) == ring->loggers.end())
+			{
+				ring->loggers.push_back(logger);
+			}
+			ring->lastLogger = logger.get();
+		}
+		Record& record = ring->records[index];
+		record.time = event->getTime();
+		record.elapse = event->getElapseNS();
+		record.threadId = event->getThreadId();
+		record.fiberId = event->getFiberId();
+		record.line = event->getLine();
+		record.level = level;
+		record.file = event->getFile();
+		record.logger = logger.get();
+		const LogBuffer& message = event->getMessageBuffer();
+		record.length = static_cast<uint32_t>(message.size() < kMessageSize ? message.size() : kMessageSize);
+		memcpy(record.message, message.data(), record.length);
+		seq.store(pos * 2 + 2, std::memory_order_release);
+		ring->head.store(pos + 1, std::memory_order_release);
+		if (level >= m_dumpLevel)
+		{
+			dump();
+		}
+	}
+
+	size_t RingBufferLogAppender::collect(bool in_signal)
+	{
+		//信号处理中持有锁的线程可能已经停止，只尝试加锁
+		std::unique_lock<std::mutex> rings_lock(m_mutex, std::defer_lock);
+		if (!in_signal)
+		{
+			rings_lock.lock();
+		}
+		else if (!rings_lock.try_lock())
+		{
+			return 0;
+		}
+		size_t count = 0;
+		for (auto& ring : m_rings)
+		{
+			//从上次输出之后、仍在环内的最早一条开始取出
+			uint64_t head = ring->head.load(std::memory_order_acquire);
+			uint64_t pos = head - std::min<uint64_t>(head - ring->tail, m_capacity);
+			for (; pos < head; ++pos)
+			{
+				size_t index = pos % m_capacity;
+				std::atomic<uint64_t>& seq = ring->seqs[index];
+				if (seq.load(std::memory_order_acquire) != pos * 2 + 2)
+				{
+					continue;
+				}
+				m_scratch[count] = ring->records[index];
+				std::atomic_thread_fence(std::memory_order_acquire);
+				//复制期间被所属线程覆盖
+				if (seq.load(std::memory_order_relaxed) != pos * 2 + 2)
+				{
+					continue;
+				}
+				m_order[count] = &m_scratch[count];
+				++count;
+			}
+			ring->tail = head;
+		}
+		rings_lock.unlock();
+
+		//按单调的进程运行时间排序，相同时保持各线程内的先后
+		std::sort(m_order.begin(), m_order.begin() + count, [](const Record* a, const Record* b) {
+			return a->elapse != b->elapse ? a->elapse < b->elapse : a < b;
+		});
+		return count;
+	}
+
+	void RingBufferLogAppender::dump()
+	{
+		std::lock_guard<std::mutex> dump_lock(m_dumpMutex);
+		UpdateSignalUtcOffset();
+		size_t count = collect(false);
+		//目标没有自己的格式器时借用本appender的，与日志器为appender设置格式器相同，不改变目标的配置
+		if (LogFormatter::ptr formatter = getFormatter())
+		{
+			m_target->inheritFormatter(formatter);
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			const Record& record = *m_order[i];
+			Logger::ptr logger = record.logger->shared_from_this();
+			LogEvent::ptr event = LogEvent::Acquire(logger, record.level, record.file, record.line,
+				record.threadId, record.fiberId);
+			event->setTime(record.time, record.elapse);
+			event->getSS().buffer().append(record.message, record.length);
+			m_target->log(logger, record.level, event);
+			LogEvent::Recycle(std::move(event));
+		}
+		m_target->flush();
+		m_dumps.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void RingBufferLogAppender::dumpInSignal()
+	{
+		std::unique_lock<std::mutex> dump_lock(m_dumpMutex, std::try_to_lock);
+		if (!dump_lock.owns_lock())
+		{
+			return;
+		}
+		size_t count = collect(true);
+		auto write = [this]() {
+			if (!m_signalWriter || !m_signalWriter->tryWrite(m_signalBuffer.data(), m_signalBuffer.size()))
+			{
+				GetSignalStderr().tryWrite(m_signalBuffer.data(), m_signalBuffer.size());
+			}
+			m_signalBuffer.clear();
+		};
+		int64_t offset = s_signal_utc_offset.load(std::memory_order_relaxed);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const Record& record = *m_order[i];
+			LogAppendSignalTime(m_signalBuffer, record.time, offset);
+			m_signalBuffer.append('\t');
+			m_signalBuffer.appendUInt(record.threadId);
+			m_signalBuffer.append('\t');
+			m_signalBuffer.appendUInt(record.fiberId);
+			m_signalBuffer.append("\t[", 2);
+			m_signalBuffer.append(LogLevel::ToString(record.level));
+			m_signalBuffer.append("]\t[", 3);
+			const std::string& name = record.logger->getName();
+			m_signalBuffer.append(name.data(), name.size());
+			m_signalBuffer.append("]\t<", 3);
+			m_signalBuffer.append(record.file);
+			m_signalBuffer.append(':');
+			m_signalBuffer.appendUInt(record.line);
+			m_signalBuffer.append(">\t", 2);
+			m_signalBuffer.append(record.message, record.length);
+			m_signalBuffer.append('\n');
+			//留出一条日志的余量，不让缓冲区扩容
+			if (m_signalBuffer.size() + kMessageSize * 4 > kSignalBufferSize)
+			{
+				write();
+			}
+		}
+		write();
+		m_dumps.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void RingBufferLogAppender::DumpAll()
+	{
+		std::unique_lock<std::mutex> lock(GetRecorderMutex(), std::try_to_lock);
+		if (!lock.owns_lock())
+		{
+			return;
+		}
+		for (auto recorder : GetRecorders())
+		{
+			recorder->dumpInSignal();
+		}
+	}
+
+	//致命信号与安装前的处理方式
+	static const int s_fatal_signals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL,
+#ifdef SIGBUS
+		SIGBUS,
+#endif
+	};
+	static constexpr size_t kFatalSignalCount = sizeof(s_fatal_signals) / sizeof(s_fatal_signals[0]);
+#ifdef _WIN32
+	static void (*s_previous_handlers[kFatalSignalCount])(int);
+#else
+	static struct sigaction s_previous_actions[kFatalSignalCount];
+#endif
+
+	void RingBufferLogAppender::InstallSignalHandler()
+	{
+		static std::once_flag s_once;
+		std::call_once(s_once, []() {
+			for (size_t i = 0; i < kFatalSignalCount; ++i)
+			{
+				/***************************************************
+					先恢复之前的处理方式再输出，输出过程中再次出错时
+					直接交给它；返回后重新发送的信号(或重新执行出错的
+					指令产生的信号)由之前的处理函数或默认方式处理
+				***************************************************/
+#ifdef _WIN32
+				s_previous_handlers[i] = signal(s_fatal_signals[i], [](int sig) {
+					for (size_t j = 0; j < kFatalSignalCount; ++j)
+					{
+						if (s_fatal_signals[j] == sig)
+						{
+							signal(sig, s_previous_handlers[j] == SIG_ERR ? SIG_DFL : s_previous_handlers[j]);
+						}
+					}
+					DumpAll();
+					raise(sig);
+				});
+#else
+				struct sigaction action;
+				memset(&action, 0, sizeof(action));
+				sigemptyset(&action.sa_mask);
+				action.sa_flags = SA_SIGINFO;
+				action.sa_sigaction = [](int sig, siginfo_t* info, void*) {
+					for (size_t j = 0; j < kFatalSignalCount; ++j)
+					{
+						if (s_fatal_signals[j] == sig)
+						{
+							sigaction(sig, &s_previous_actions[j], nullptr);
+						}
+					}
+					DumpAll();
+					//出错指令产生的信号在返回后再次产生，kill/raise发送的需要重新发送
+					if (info->si_code <= 0)
+					{
+						raise(sig);
+					}
+				};
+				sigaction(s_fatal_signals[i], &action, &s_previous_actions[i]);
+#endif
+			}
+		});
+	}
+
+	std::string RingBufferLogAppender::toYamlString()
+	{
+		YAML::Node node;
+		node["type"] = "RingBufferLogAppender";
+		if (auto file = std::dynamic_pointer_cast<FileLogAppender>(m_target))
+		{
+			node["file"] = YAML::Load(file->toYamlString())["file"];
+		}
+		if (m_capacity != kDefaultCapacity)
+		{
+			node["capacity"] = m_capacity;
+		}
+		node["dump_level"] = LogLevel::ToString(m_dumpLevel);
+		if (m_level != LogLevel::UNKNOW)
+		{
+			node["level"] = LogLevel::ToString(m_level);
+		}
+		LogFormatter::ptr formatter = getFormatter();
+		if (m_hasFormatter && formatter)
+		{
+			node["formatter"] = formatter->getPattern();
+		}
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
+	StdoutLogAppender::StdoutLogAppender(size_t buffer_size)
+		: m_writer(std::make_shared<LogFileWriter>(buffer_size))
+	{
+		m_writer->attach(1);
+		setFlushPolicy(m_flushPolicy);
+	}
+
+	StdoutLogAppender::~StdoutLogAppender()
+	{
+		m_repeat.flush(*m_writer);
+	}
+
+	void StdoutLogAppender::setFlushPolicy(const LogFlushPolicy& policy)
+	{
+		m_flushPolicy = policy;
+		m_writer->setFlushBytes(policy.bytes);
+		m_writer->setFlushInterval(policy.interval);
+	}
+
+	void StdoutLogAppender::log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event)
+	{
+		if (level >= m_level)
+		{
+			m_repeat.write(*m_writer, level, *event, m_flushPolicy.flushOn(level),
+				[&]() -> const LogBuffer& { return formatter()->render(level, *event); });
+		}
+	}
+
+	std::string StdoutLogAppender::toYamlString()
+	{
+		YAML::Node node;
+		node["type"] = "StdoutLogAppender";
+		FlushPolicyToYaml(node, m_flushPolicy, m_writer->getBufferSize());
+		CoalesceToYaml(node, m_repeat.getInterval());
+		if (m_level != LogLevel::UNKNOW)
+		{
+			node["level"] = LogLevel::ToString(m_level);
+		}
+		LogFormatter::ptr formatter = getFormatter();
+		if (m_hasFormatter && formatter)
+		{
+			node["formatter"] = formatter->getPattern();
+		}
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
+	AsyncLogAppender::AsyncLogAppender(const std::string& filename, size_t buffer_size,
+		uint32_t flush_interval)
+		: AsyncLogAppender(filename, buffer_size, flush_interval, std::ios_base::out)
+	{
+	}
+
+	AsyncLogAppender::AsyncLogAppender(const std::string& filename, size_t buffer_size,
+		uint32_t flush_interval, std::ios_base::openmode mode)
+		: m_filename(filename)
+		, m_bufferSize(buffer_size ? buffer_size : kDefaultBufferSize)
+		, m_flushInterval(flush_interval ? flush_interval : kDefaultFlushInterval)
+		, m_openMode(mode | std::ios_base::app)
+		, m_current(new Buffer)
+		, m_next(new Buffer)
+	{
+		m_current->reserve(m_bufferSize);
+		m_next->reserve(m_bufferSize);
+		m_buffers.reserve(kMaxPendingBuffers);
+		m_running = true;
+		m_thread = std::thread(&AsyncLogAppender::run, this);
+	}
+
+	AsyncLogAppender::~AsyncLogAppender()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_running = false;
+		}
+		m_cond.notify_one();
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+	}
+
+	void AsyncLogAppender::log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event)
+	{
+		if (level >= m_level)
+		{
+			const LogBuffer& line = formatter()->render(level, *event);
+			append(line.data(), line.size());
+		}
+	}
+
+	void AsyncLogAppender::append(const char* msg, size_t len)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		appendLocked(msg, len);
+	}
+
+	bool AsyncLogAppender::appendLocked(const char* msg, size_t len)
+	{
+		if (m_current->empty() || m_current->size() + len <= m_bufferSize)
+		{
+			m_current->append(msg, len);
+		}
+		else
+		{
+			//后台线程来不及写出，丢弃新日志，避免缓冲区无限增长
+			if (m_buffers.size() >= kMaxPendingBuffers)
+			{
+				m_droppedBytes.fetch_add(len, std::memory_order_relaxed);
+				return false;
+			}
+			m_buffers.push_back(std::move(m_current));
+			if (m_next)
+			{
+				m_current = std::move(m_next);
+			}
+			else
+			{
+				m_current.reset(new Buffer);
+				m_current->reserve(m_bufferSize);
+			}
+			m_current->append(msg, len);
+			m_cond.notify_one();
+		}
+		m_queuedBytes.fetch_add(len, std::memory_order_relaxed);
+		return true;
+	}
+
+	void AsyncLogAppender::flush()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_flushRequested = true;
+		}
+		m_cond.notify_one();
+	}
+
+	void AsyncLogAppender::run()
+	{
+		std::ofstream filestream(m_filename, m_openMode);
+		if (!filestream)
+		{
+			std::cout << "AsyncLogAppender open file=" << m_filename << " failed" << std::endl;
+		}
+		BufferPtr spare1(new Buffer);
+		BufferPtr spare2(new Buffer);
+		spare1->reserve(m_bufferSize);
+		spare2->reserve(m_bufferSize);
+		std::vector<BufferPtr> to_write;
+		to_write.reserve(kMaxPendingBuffers + 1);
+
+		bool running = true;
+		while (running)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				if (m_buffers.empty() && !m_flushRequested && m_running)
+				{
+					m_cond.wait_for(lock, std::chrono::milliseconds(m_flushInterval));
+				}
+				running = m_running;
+				m_flushRequested = false;
+				//交换前后台缓冲区，之后的写文件操作不再持有锁
+				m_buffers.push_back(std::move(m_current));
+				m_current = std::move(spare1);
+				if (!m_next)
+				{
+					m_next = std::move(spare2);
+				}
+				to_write.swap(m_buffers);
+			}
+
+			for (auto& buf : to_write)
+			{
+				if (buf->empty())
+				{
+					continue;
+				}
+				filestream.write(buf->data(), buf->size());
+				m_flushedBytes.fetch_add(buf->size(), std::memory_order_relaxed);
+			}
+			filestream.flush();
+
+			//回收两块缓冲区作为备用，其余的释放
+			for (auto* spare : { &spare1, &spare2 })
+			{
+				if (!*spare && !to_write.empty())
+				{
+					*spare = std::move(to_write.back());
+					to_write.pop_back();
+					(*spare)->clear();
+				}
+			}
+			to_write.clear();
+		}
+	}
+
+	std::string AsyncLogAppender::toYamlString()
+	{
+		YAML::Node node;
+		node["type"] = "AsyncLogAppender";
+		node["file"] = m_filename;
+		node["buffer_size"] = m_bufferSize;
+		node["flush_interval"] = m_flushInterval;
+		if (m_level != LogLevel::UNKNOW)
+		{
+			node["level"] = LogLevel::ToString(m_level);
+		}
+		LogFormatter::ptr formatter = getFormatter();
+		if (m_hasFormatter && formatter)
+		{
+			node["formatter"] = formatter->getPattern();
+		}
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
+	BinaryLogAppender::BinaryLogAppender(const std::string& filename, size_t buffer_size,
+		uint32_t flush_interval)
+		: AsyncLogAppender(filename, buffer_size, flush_interval, std::ios_base::out | std::ios_base::binary)
+	{
+		//追加到已有文件时也写出文件头，作为新一段数据的开始
+		append(kLogBinaryMagic, sizeof(kLogBinaryMagic));
+	}
+
+	void BinaryLogAppender::log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event)
+	{
+		if (level >= m_level)
+		{
+			LogBuffer& buf = LogBinaryThreadBuffer();
+			uint32_t id = event->getLogger()->getBinaryId();
+			const char* file = event->getFile() ? event->getFile() : "";
+			const LogBuffer& msg = event->getMessageBuffer();
+			buf.append(static_cast<char>(LogBinaryRecord::TEXT));
+			LogBinaryPut(buf, id);
+			LogBinaryPut(buf, static_cast<uint8_t>(level));
+			LogBinaryPut(buf, static_cast<int32_t>(event->getLine()));
+			LogBinaryPut(buf, event->getTime());
+			LogBinaryPut(buf, event->getElapseNS());
+			LogBinaryPut(buf, event->getThreadId());
+			LogBinaryPut(buf, event->getFiberId());
+			LogBinaryPutString(buf, file, strlen(file));
+			LogBinaryPutString(buf, msg.data(), msg.size());
+			appendRecord(0, id, buf);
+		}
+	}
+
+	void BinaryLogAppender::appendRecord(uint32_t site, uint32_t logger, const LogBuffer& record)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		bool site_defined = site == 0 || (site < m_sites.size() && m_sites[site]);
+		bool logger_defined = logger < m_loggers.size() && m_loggers[logger];
+		if (!site_defined || !logger_defined)
+		{
+			//首次引用时先写出定义，定义被丢弃时记录也不写出，保证文件可解码
+			LogBuffer define;
+			if (!site_defined && !defineSite(define, site))
+			{
+				return;
+			}
+			if (!logger_defined && !defineLogger(define, logger))
+			{
+				return;
+			}
+			if (!appendLocked(define.data(), define.size()))
+			{
+				return;
+			}
+			if (!site_defined)
+			{
+				m_sites.resize(std::max<size_t>(m_sites.size(), site + 1));
+				m_sites[site] = true;
+			}
+			if (!logger_defined)
+			{
+				m_loggers.resize(std::max<size_t>(m_loggers.size(), logger + 1));
+				m_loggers[logger] = true;
+			}
+		}
+		appendLocked(record.data(), record.size());
+	}
+
+	bool BinaryLogAppender::defineSite(LogBuffer& buf, uint32_t site)
+	{
+		LogBinarySiteInfo info;
+		if (!LogBinaryGetSite(site, info))
+		{
+			return false;
+		}
+		buf.append(static_cast<char>(LogBinaryRecord::SITE));
+		LogBinaryPut(buf, site);
+		LogBinaryPut(buf, static_cast<int32_t>(info.line));
+		LogBinaryPut(buf, static_cast<uint8_t>(info.level));
+		LogBinaryPutString(buf, info.file.data(), info.file.size());
+		LogBinaryPutString(buf, info.fmt.data(), info.fmt.size());
+		LogBinaryPutString(buf, info.types.data(), info.types.size());
+		return true;
+	}
+
+	bool BinaryLogAppender::defineLogger(LogBuffer& buf, uint32_t logger)
+	{
+		std::string name;
+		if (!LogBinaryGetLogger(logger, name))
+		{
+			return false;
+		}
+		buf.append(static_cast<char>(LogBinaryRecord::LOGGER));
+		LogBinaryPut(buf, logger);
+		LogBinaryPutString(buf, name.data(), name.size());
+		return true;
+	}
+
+	std::string BinaryLogAppender::toYamlString()
+	{
+		YAML::Node node;
+		node["type"] = "BinaryLogAppender";
+		node["file"] = m_filename;
+		node["buffer_size"] = m_bufferSize;
+		node["flush_interval"] = m_flushInterval;
+		if (m_level != LogLevel::UNKNOW)
+		{
+			node["level"] = LogLevel::ToString(m_level);
+		}
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
+	/***************************************************
+		单生产者单消费者的字节环形缓冲区
+		位置只增不减，取模得到下标；每条记录以头部开始并按头部大小对齐，
+		末尾放不下时写入回绕标记，从头开始写
+	***************************************************/
+	struct MergeLogAppender::Buffer
+	{
+		struct Header
+		{
+			uint64_t time;      //日志时间戳(纳秒)
+			uint32_t length;    //日志长度，kWrap为回绕标记
+			uint32_t reserved;
+		};
+		static constexpr uint32_t kWrap = UINT32_MAX;
+
+		explicit Buffer(size_t size)
+			: capacity(size / sizeof(Header) * sizeof(Header))
+			, data(new char[capacity])
+		{
+		}
+
+		//只由所属线程调用，缓冲区已满时返回false
+		bool append(uint64_t time, const char* msg, size_t len)
+		{
+			size_t need = sizeof(Header) + (len + sizeof(Header) - 1) / sizeof(Header) * sizeof(Header);
+			uint64_t pos = head.load(std::memory_order_relaxed);
+			size_t index = pos % capacity;
+			size_t tail_room = capacity - index;
+			size_t total = tail_room < need ? tail_room + need : need;
+			if (need > capacity || pos + total - cachedTail > capacity)
+			{
+				//只有空间看起来不够时才读取消费者的位置
+				cachedTail = tail.load(std::memory_order_acquire);
+				if (need > capacity || pos + total - cachedTail > capacity)
+				{
+					dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+					return false;
+				}
+			}
+			if (tail_room < need)
+			{
+				reinterpret_cast<Header*>(data.get() + index)->length = kWrap;
+				index = 0;
+			}
+			Header* header = reinterpret_cast<Header*>(data.get() + index);
+			header->time = time;
+			header->length = static_cast<uint32_t>(len);
+			memcpy(header + 1, msg, len);
+			head.store(pos + total, std::memory_order_release);
+			return true;
+		}
+
+		//只由后台线程调用，取出当前所有记录
+		template<class F>
+		void drain(F&& f)
+		{
+			uint64_t end = head.load(std::memory_order_acquire);
+			uint64_t pos = tail.load(std::memory_order_relaxed);
+			while (pos < end)
+			{
+				size_t index = pos % capacity;
+				const Header* header = reinterpret_cast<const Header*>(data.get() + index);
+				if (header->length == kWrap)
+				{
+					pos += capacity - index;
+					continue;
+				}
+				f(header->time, reinterpret_cast<const char*>(header + 1), header->length);
+				pos += sizeof(Header) + (header->length + sizeof(Header) - 1) / sizeof(Header) * sizeof(Header);
+			}
+			tail.store(pos, std::memory_order_release);
+		}
+
+		const size_t capacity;
+		std::unique_ptr<char[]> data;
+		std::atomic<bool> owned{ true };    //是否被某个线程占用
+		std::atomic<bool> closed{ false };  //appender已析构
+
+		//生产者与消费者各自写的位置放在不同的缓存行
+		alignas(64) std::atomic<uint64_t> head{ 0 };
+		uint64_t cachedTail = 0;            //生产者看到的消费者位置
+		std::atomic<uint64_t> dropped{ 0 }; //只由生产者修改
+		alignas(64) std::atomic<uint64_t> tail{ 0 };
+		uint64_t lastTime = 0;              //后台线程取出的上一条日志的排序时间
+	};
+
+	static std::atomic<uint64_t> s_merge_appender_id{ 0 };
+
+	MergeLogAppender::MergeLogAppender(const std::string& filename, size_t buffer_size,
+		uint32_t flush_interval)
+		: m_filename(filename)
+		, m_bufferSize(buffer_size ? buffer_size : kDefaultBufferSize)
+		, m_flushInterval(flush_interval ? flush_interval : kDefaultFlushInterval)
+		, m_id(s_merge_appender_id.fetch_add(1, std::memory_order_relaxed) + 1)
+	{
+		m_running = true;
+		m_thread = std::thread(&MergeLogAppender::run, this);
+	}
+
+	MergeLogAppender::~MergeLogAppender()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_running = false;
+		}
+		m_cond.notify_one();
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+		//线程局部缓存中仍引用的缓冲区在线程下次查找时被清除
+		for (auto& i : m_buffers)
+		{
+			i->closed.store(true, std::memory_order_release);
+		}
+	}
+
+	MergeLogAppender::Buffer* MergeLogAppender::getBuffer()
+	{
+		//线程退出时归还缓冲区
+		struct Handle
+		{
+			Handle(uint64_t i, std::shared_ptr<Buffer> b) : id(i), buffer(std::move(b)) {}
+			Handle(Handle&&) = default;
+			Handle& operator=(Handle&&) = default;
+			~Handle()
+			{
+				if (buffer)
+				{
+					buffer->owned.store(false, std::memory_order_release);
+				}
+			}
+
+			uint64_t id;
+			std::shared_ptr<Buffer> buffer;
+		};
+		static thread_local std::vector<Handle> s_buffers;
+		for (auto& i : s_buffers)
+		{
+			if (i.id == m_id)
+			{
+				return i.buffer.get();
+			}
+		}
+		s_buffers.erase(std::remove_if(s_buffers.begin(), s_buffers.end(), [](const Handle& h) {
+			return h.buffer->closed.load(std::memory_order_acquire);
+		}), s_buffers.end());
+
+		std::shared_ptr<Buffer> buffer;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (auto& i : m_buffers)
+			{
+				bool expected = false;
+				if (!i->owned.load(std::memory_order_relaxed)
+					&& i->owned.compare_exchange_strong(expected, true, std::memory_order_acquire))
+				{
+					buffer = i;
+					break;
+				}
+			}
+			if (!buffer)
+			{
+				buffer = std::make_shared<Buffer>(m_bufferSize);
+				m_buffers.push_back(buffer);
+			}
+		}
+		s_buffers.emplace_back(m_id, buffer);
+		return buffer.get();
+	}
+
+	void MergeLogAppender::log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event)
+	{
+		if (level >= m_level)
+		{
+			const LogBuffer& line = formatter()->render(level, *event);
+			getBuffer()->append(event->getTime(), line.data(), line.size());
+		}
+	}
+
+	void MergeLogAppender::flush()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		uint64_t request = ++m_flushRequest;
+		m_cond.notify_one();
+		m_flushCond.wait(lock, [this, request]() { return m_flushDone >= request || !m_running; });
+	}
+
+	size_t MergeLogAppender::getBufferCount()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_buffers.size();
+	}
+
+	uint64_t MergeLogAppender::getDroppedCount()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		uint64_t dropped = 0;
+		for (auto& i : m_buffers)
+		{
+			dropped += i->dropped.load(std::memory_order_relaxed);
+		}
+		return dropped;
+	}
+
+	void MergeLogAppender::run()
+	{
+		std::ofstream filestream(m_filename, std::ios_base::app);
+		if (!filestream)
+		{
+			std::cout << "MergeLogAppender open file=" << m_filename << " failed" << std::endl;
+		}
+		//已取出、尚未到写出时间的日志
+		struct Pending
+		{
+			uint64_t time;
+			size_t offset;
+			uint32_t length;
+		};
+		std::vector<Pending> pending;
+		std::string data;
+		std::string retained;
+		std::vector<std::shared_ptr<Buffer>> buffers;
+
+		bool running = true;
+		while (running)
+		{
+			uint64_t request = 0;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				if (m_running && m_flushRequest == m_flushDone)
+				{
+					m_cond.wait_for(lock, std::chrono::milliseconds(m_flushInterval));
+				}
+				running = m_running;
+				request = m_flushRequest;
+				buffers = m_buffers;
+			}
+
+			//在取出之前确定写出的截止时间，取出过程中新写入的日志都晚于它
+			uint64_t watermark = UINT64_MAX;
+			if (running && request == m_flushDone)
+			{
+				uint64_t now = 0;
+				uint64_t elapse = 0;
+				GetClockNS(now, elapse);
+				watermark = now - m_flushInterval * 1000000ULL;
+			}
+			for (auto& buffer : buffers)
+			{
+				//时钟重新校准时时间戳可能略微回退，排序时间不小于同一线程的上一条，保持线程内的先后
+				Buffer* b = buffer.get();
+				b->drain([&](uint64_t time, const char* msg, uint32_t len) {
+					b->lastTime = time > b->lastTime ? time : b->lastTime;
+					pending.push_back({ b->lastTime, data.size(), len });
+					data.append(msg, len);
+				});
+			}
+
+			//稳定排序保持同一时间的先后
+			std::stable_sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+				return a.time < b.time;
+			});
+			size_t n = 0;
+			for (; n < pending.size() && pending[n].time <= watermark; ++n)
+			{
+				filestream.write(data.data() + pending[n].offset, pending[n].length);
+			}
+			filestream.flush();
+			m_written.fetch_add(n, std::memory_order_relaxed);
+
+			//保留未写出的日志
+			retained.clear();
+			for (size_t i = n; i < pending.size(); ++i)
+			{
+				size_t offset = retained.size();
+				retained.append(data, pending[i].offset, pending[i].length);
+				pending[i].offset = offset;
+			}
+			pending.erase(pending.begin(), pending.begin() + n);
+			data.swap(retained);
+			buffers.clear();
+
+			if (request != m_flushDone)
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_flushDone = request;
+				}
+				m_flushCond.notify_all();
+			}
+		}
+	}
+
+	std::string MergeLogAppender::toYamlString()
+	{
+		YAML::Node node;
+		node["type"] = "MergeLogAppender";
+		node["file"] = m_filename;
+		node["buffer_size"] = m_bufferSize;
+		node["flush_interval"] = m_flushInterval;
+		if (m_level != LogLevel::UNKNOW)
+		{
+			node["level"] = LogLevel::ToString(m_level);
+		}
+		LogFormatter::ptr formatter = getFormatter();
+		if (m_hasFormatter && formatter)
+		{
+			node["formatter"] = formatter->getPattern();
+		}
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
+	ShmLogAppender::ShmLogAppender(const std::string& channel, uint32_t slot_count, uint64_t ring_size)
+		: m_channelName(channel)
+		, m_slotCount(slot_count ? slot_count : LogShmChannel::kDefaultSlotCount)
+		, m_ringSize(ring_size ? ring_size : LogShmChannel::kDefaultRingSize)
+	{
+		m_channel = LogShmChannel::Open(m_channelName, m_slotCount, m_ringSize);
+		if (!m_channel)
+		{
+			std::cout << "ShmLogAppender open channel=" << m_channelName << " failed" << std::endl;
+			return;
+		}
+		m_slot = m_channel->acquireSlot();
+		if (m_slot < 0)
+		{
+			std::cout << "ShmLogAppender channel=" << m_channelName << " has no free slot" << std::endl;
+		}
+	}
+
+	ShmLogAppender::~ShmLogAppender()
+	{
+		if (m_channel && m_slot >= 0)
+		{
+			m_channel->releaseSlot(m_slot);
+		}
+	}
+
+	void ShmLogAppender::log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event)
+	{
+		if (level >= m_level)
+		{
+			if (m_slot < 0)
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			const LogBuffer& line = formatter()->render(level, *event);
+			if (!m_channel->append(m_slot, event->getTime(), line.data(), line.size()))
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	std::string ShmLogAppender::toYamlString()
+	{
+		YAML::Node node;
+		node["type"] = "ShmLogAppender";
+		node["channel"] = m_channelName;
+		if (m_slotCount != LogShmChannel::kDefaultSlotCount)
+		{
+			node["slots"] = m_slotCount;
+		}
+		if (m_ringSize != LogShmChannel::kDefaultRingSize)
+		{
+			node["ring_size"] = m_ringSize;
+		}
+		if (m_level != LogLevel::UNKNOW)
+		{
+			node["level"] = LogLevel::ToString(m_level);
+		}
+		LogFormatter::ptr formatter = getFormatter();
+		if (m_hasFormatter && formatter)
+		{
+			node["formatter"] = formatter->getPattern();
+		}
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
+	template<class T>
+	static bool ReadBinary(std::istream& in, T& v)
+	{
+		return !!in.read(reinterpret_cast<char*>(&v), sizeof(T));
+	}
+
+	static bool ReadBinaryString(std::istream& in, std::string& str)
+	{
+		//长度异常说明文件已损坏，不按其分配内存
+		static const uint32_t kMaxLength = 64 * 1024 * 1024;
+		uint32_t len = 0;
+		if (!ReadBinary(in, len) || len > kMaxLength)
+		{
+			return false;
+		}
+		str.resize(len);
+		return len == 0 || !!in.read(&str[0], len);
+	}
+
+	//调用点与日志器id按注册顺序分配，超过该值说明文件已损坏，不按其分配内存
+	static const uint32_t kMaxBinaryId = 1024 * 1024;
+
+	//读取一个参数，msg不为空时按LogFormatValue的规则写入
+	static bool ReadBinaryArg(std::istream& in, uint8_t type, LogBuffer* msg)
+	{
+		switch (type)
+		{
+			case LogBinaryArg::BOOL:
+			case LogBinaryArg::CHAR:
+			{
+				char c = 0;
+				if (!ReadBinary(in, c))
+				{
+					return false;
+				}
+				if (msg && type == LogBinaryArg::BOOL)
+				{
+					msg->append(c ? "true" : "false");
+				}
+				else if (msg)
+				{
+					msg->append(c);
+				}
+				return true;
+			}
+			case LogBinaryArg::INT:
+			{
+				int64_t v = 0;
+				if (!ReadBinary(in, v))
+				{
+					return false;
+				}
+				if (msg)
+				{
+					msg->appendInt(v);
+				}
+				return true;
+			}
+			case LogBinaryArg::UINT:
+			{
+				uint64_t v = 0;
+				if (!ReadBinary(in, v))
+				{
+					return false;
+				}
+				if (msg)
+				{
+					msg->appendUInt(v);
+				}
+				return true;
+			}
+			case LogBinaryArg::FLOAT:
+			{
+				float v = 0;
+				if (!ReadBinary(in, v))
+				{
+					return false;
+				}
+				if (msg)
+				{
+					msg->appendFloat(v);
+				}
+				return true;
+			}
+			case LogBinaryArg::DOUBLE:
+			{
+				double v = 0;
+				if (!ReadBinary(in, v))
+				{
+					return false;
+				}
+				if (msg)
+				{
+					msg->appendDouble(v);
+				}
+				return true;
+			}
+			case LogBinaryArg::STRING:
+			{
+				std::string v;
+				if (!ReadBinaryString(in, v))
+				{
+					return false;
+				}
+				if (msg)
+				{
+					msg->append(v);
+				}
+				return true;
+			}
+			default:
+				return false;
+		}
+	}
+
+	BinaryLogDecoder::BinaryLogDecoder(LogFormatter::ptr formatter)
+		: m_formatter(formatter)
+	{
+	}
+
+	bool BinaryLogDecoder::fail(const std::string& error)
+	{
+		m_error = error;
+		return false;
+	}
+
+	bool BinaryLogDecoder::decode(std::istream& in, std::ostream& out)
+	{
+		char magic[sizeof(kLogBinaryMagic)];
+		if (!in.read(magic, sizeof(magic)) || memcmp(magic, kLogBinaryMagic, sizeof(magic)) != 0)
+		{
+			return fail("not a binary log file");
+		}
+		LogBuffer buf;
+		for (int type = in.get(); type != std::istream::traits_type::eof(); type = in.get())
+		{
+			buf.clear();
+			if (type == kLogBinaryMagic[0])
+			{
+				//追加写入的下一段数据
+				if (!in.read(magic + 1, sizeof(magic) - 1) || memcmp(magic, kLogBinaryMagic, sizeof(magic)) != 0)
+				{
+					return fail("bad magic in appended segment");
+				}
+			}
+			else if (type == LogBinaryRecord::SITE)
+			{
+				uint32_t id = 0;
+				int32_t line = 0;
+				uint8_t level = 0;
+				LogBinarySiteInfo info;
+				if (!ReadBinary(in, id) || !ReadBinary(in, line) || !ReadBinary(in, level)
+					|| !ReadBinaryString(in, info.file) || !ReadBinaryString(in, info.fmt)
+					|| !ReadBinaryString(in, info.types))
+				{
+					return fail("truncated site record");
+				}
+				if (id > kMaxBinaryId)
+				{
+					return fail("bad site id " + std::to_string(id));
+				}
+				info.line = line;
+				info.level = level;
+				if (m_sites.size() <= id)
+				{
+					m_sites.resize(id + 1);
+				}
+				m_sites[id] = std::move(info);
+			}
+			else if (type == LogBinaryRecord::LOGGER)
+			{
+				uint32_t id = 0;
+				std::string name;
+				if (!ReadBinary(in, id) || !ReadBinaryString(in, name))
+				{
+					return fail("truncated logger record");
+				}
+				if (id > kMaxBinaryId)
+				{
+					return fail("bad logger id " + std::to_string(id));
+				}
+				if (m_loggers.size() <= id)
+				{
+					m_loggers.resize(id + 1);
+				}
+				m_loggers[id] = std::make_shared<Logger>(name);
+			}
+			else if (type == LogBinaryRecord::EVENT)
+			{
+				if (!readEvent(in, buf))
+				{
+					return false;
+				}
+			}
+			else if (type == LogBinaryRecord::TEXT)
+			{
+				if (!readText(in, buf))
+				{
+					return false;
+				}
+			}
+			else
+			{
+				return fail("unknown record type " + std::to_string(type));
+			}
+			if (!buf.empty())
+			{
+				out.write(buf.data(), buf.size());
+			}
+		}
+		return true;
+	}
+
+	bool BinaryLogDecoder::readEvent(std::istream& in, LogBuffer& out)
+	{
+		uint32_t site = 0;
+		uint32_t logger = 0;
+		uint64_t time = 0;
+		uint64_t elapse = 0;
+		uint32_t thread_id = 0;
+		uint32_t fiber_id = 0;
+		if (!ReadBinary(in, site) || !ReadBinary(in, logger) || !ReadBinary(in, time)
+			|| !ReadBinary(in, elapse) || !ReadBinary(in, thread_id) || !ReadBinary(in, fiber_id))
+		{
+			return fail("truncated event record");
+		}
+		//__FILE__不会为空，文件名为空说明调用点未定义
+		if (site >= m_sites.size() || m_sites[site].file.empty())
+		{
+			return fail("event references undefined site " + std::to_string(site));
+		}
+		if (logger >= m_loggers.size() || !m_loggers[logger])
+		{
+			return fail("event references undefined logger " + std::to_string(logger));
+		}
+		const LogBinarySiteInfo& info = m_sites[site];
+		LogEvent event(m_loggers[logger], static_cast<LogLevel::Level>(info.level), info.file.c_str(),
+			info.line, 0, thread_id, fiber_id, time);
+		event.setTime(time, elapse);
+
+		//与LogFormatTo相同：多余的占位符原样输出
+		LogBuffer& msg = event.getSS().buffer();
+		const char* fmt = info.fmt.c_str();
+		for (char type : info.types)
+		{
+			fmt = fmt ? LogFormatLiteral(msg, fmt) : nullptr;
+			if (!ReadBinaryArg(in, static_cast<uint8_t>(type), fmt ? &msg : nullptr))
+			{
+				return fail("truncated event arguments");
+			}
+		}
+		while (fmt)
+		{
+			fmt = LogFormatLiteral(msg, fmt);
+			if (fmt)
+			{
+				msg.append("{}", 2);
+			}
+		}
+		m_formatter->format(out, event.getLevel(), event);
+		++m_count;
+		return true;
+	}
+
+	bool BinaryLogDecoder::readText(std::istream& in, LogBuffer& out)
+	{
+		uint32_t logger = 0;
+		uint8_t level = 0;
+		int32_t line = 0;
+		uint64_t time = 0;
+		uint64_t elapse = 0;
+		uint32_t thread_id = 0;
+		uint32_t fiber_id = 0;
+		std::string file;
+		std::string message;
+		if (!ReadBinary(in, logger) || !ReadBinary(in, level) || !ReadBinary(in, line)
+			|| !ReadBinary(in, time) || !ReadBinary(in, elapse) || !ReadBinary(in, thread_id)
+			|| !ReadBinary(in, fiber_id) || !ReadBinaryString(in, file) || !ReadBinaryString(in, message))
+		{
+			return fail("truncated text record");
+		}
+		if (logger >= m_loggers.size() || !m_loggers[logger])
+		{
+			return fail("text record references undefined logger " + std::to_string(logger));
+		}
+		LogEvent event(m_loggers[logger], static_cast<LogLevel::Level>(level), file.c_str(),
+			line, 0, thread_id, fiber_id, time);
+		event.setTime(time, elapse);
+		event.getSS().buffer().append(message);
+		m_formatter->format(out, event.getLevel(), event);
+		++m_count;
+		return true;
+	}
+
+	LogFormatter::LogFormatter(const std::string& pattern)
+		: m_pattern(pattern)
+	{
+		static std::atomic<uint32_t> s_id{ 0 };
+		m_id = ++s_id;
+		init();
+	}
+
+	const LogBuffer& LogFormatter::render(LogLevel::Level level, LogEvent& event) const
+	{
+		if (event.m_textFormatter != m_id || event.m_textLevel != level)
+		{
+			event.m_text.clear();
+			format(event.m_text, level, event);
+			event.m_textFormatter = m_id;
+			event.m_textLevel = level;
+		}
+		return event.m_text;
+	}
+
+	LogLine LogFormatter::renderShared(LogLevel::Level level, const LogEvent::ptr& event) const
+	{
+		//别名构造，与事件共用控制块，不分配内存
+		return LogLine(event, &render(level, *event));
+	}
+
+	std::string LogFormatter::format(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event)
+	{
+		LogBuffer buf;
+		format(buf, level, *event);
+		return buf.toString();
 	}
 
-	std::string FileLogAppender::toYamlString()
+	void LogFormatter::format(LogBuffer& buf, LogLevel::Level level, const LogEvent& event) const
 	{
-		YAML::Node node;
-		node["type"] = "FileLogAppender";
-		node["file"] = m_filename;
-		if (m_level != LogLevel::UNKNOW)
-		{
-			node["level"] = LogLevel::ToString(m_level);
-		}
-		if (m_hasFormatter && m_formatter) 
+		for (auto& ins : m_instructions)
 		{
-			node["formatter"] = m_formatter->getPattern();
+			switch (ins.op)
+			{
+				case LITERAL:
+					buf.append(m_literals.data() + ins.offset, ins.length);
+					break;
+				case MESSAGE:
+				{
+					const LogBuffer& msg = event.getMessageBuffer();
+					buf.append(msg.data(), msg.size());
+					break;
+				}
+				case LEVEL:
+					buf.append(LogLevel::ToString(level));
+					break;
+				case ELAPSE:
+					buf.appendUInt(event.getElapse());
+					break;
+				case UPTIME:
+				{
+					uint64_t ns = event.getElapseNS();
+					buf.appendUInt(ns / 1000000000);
+					char* p = buf.prepare(10);
+					p[0] = '.';
+					uint32_t frac = static_cast<uint32_t>(ns % 1000000000);
+					for (int n = 9; n > 0; --n)
+					{
+						p[n] = static_cast<char>('0' + frac % 10);
+						frac /= 10;
+					}
+					buf.commit(10);
+					break;
+				}
+				case TIMESTAMP:
+					buf.appendUInt(event.getTime());
+					break;
+				case NAME:
+					buf.append(event.getLogger()->getName());
+					break;
+				case THREAD_ID:
+					buf.appendUInt(event.getThreadId());
+					break;
+				case FIBER_ID:
+					buf.appendUInt(event.getFiberId());
+					break;
+				case DATETIME:
+					m_dateTimes[ins.offset]->format(buf, event.getTime());
+					break;
+				case FILENAME:
+					buf.append(event.getFile());
+					break;
+				case LINE:
+					buf.appendUInt(event.getLine());
+					break;
+				case JSON:
+					formatJson(buf, level, event, ins.offset);
+					break;
+				case LOGFMT:
+					formatLogfmt(buf, level, event, ins.offset);
+					break;
+				case FIELDS:
+					LogFieldsToLogfmt(buf, event.getFieldsBuffer());
+					break;
+			}
 		}
-		std::stringstream ss;
-		ss << node;
-		return ss.str();
 	}
 
-	void StdoutLogAppender::log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event)
+	const LogBuffer& LogFormatter::formatDateTime(uint32_t date_time, uint64_t time) const
 	{
-		if (level >= m_level)
-		{
-			std::cout << m_formatter->format(logger, level, event);
-		}
+		static thread_local LogBuffer t_buf;
+		t_buf.clear();
+		m_dateTimes[date_time]->format(t_buf, time);
+		return t_buf;
 	}
 
-	std::string StdoutLogAppender::toYamlString()
+	void LogFormatter::formatJson(LogBuffer& buf, LogLevel::Level level, const LogEvent& event, uint32_t date_time) const
 	{
-		YAML::Node node;
-		node["type"] = "StdoutLogAppender";
-		if (m_level != LogLevel::UNKNOW)
+		buf.append("{\"time\":", 8);
+		if (date_time == kNoDateTime)
 		{
-			node["level"] = LogLevel::ToString(m_level);
+			buf.appendUInt(event.getTime());
 		}
-		if (m_hasFormatter && m_formatter)
+		else
 		{
-			node["formatter"] = m_formatter->getPattern();
+			const LogBuffer& time = formatDateTime(date_time, event.getTime());
+			LogAppendJsonString(buf, std::string_view(time.data(), time.size()));
 		}
-		std::stringstream ss;
-		ss << node;
-		return ss.str();
+		buf.append(",\"level\":\"", 10);
+		buf.append(LogLevel::ToString(level));
+		buf.append("\",\"logger\":", 11);
+		LogAppendJsonString(buf, event.getLogger()->getName());
+		buf.append(",\"thread\":", 10);
+		buf.appendUInt(event.getThreadId());
+		buf.append(",\"fiber\":", 9);
+		buf.appendUInt(event.getFiberId());
+		buf.append(",\"file\":", 8);
+		LogAppendJsonString(buf, event.getFile());
+		buf.append(",\"line\":", 8);
+		buf.appendUInt(event.getLine());
+		buf.append(",\"msg\":", 7);
+		const LogBuffer& msg = event.getMessageBuffer();
+		LogAppendJsonString(buf, std::string_view(msg.data(), msg.size()));
+		LogFieldsToJson(buf, event.getFieldsBuffer());
+		buf.append('}');
 	}
 
-	LogFormatter::LogFormatter(const std::string& pattern)
-		: m_pattern(pattern)
+	void LogFormatter::formatLogfmt(LogBuffer& buf, LogLevel::Level level, const LogEvent& event, uint32_t date_time) const
 	{
-		init();
+		buf.append("time=", 5);
+		if (date_time == kNoDateTime)
+		{
+			buf.appendUInt(event.getTime());
+		}
+		else
+		{
+			const LogBuffer& time = formatDateTime(date_time, event.getTime());
+			LogAppendLogfmtValue(buf, std::string_view(time.data(), time.size()));
+		}
+		buf.append(" level=", 7);
+		buf.append(LogLevel::ToString(level));
+		buf.append(" logger=", 8);
+		LogAppendLogfmtValue(buf, event.getLogger()->getName());
+		buf.append(" thread=", 8);
+		buf.appendUInt(event.getThreadId());
+		buf.append(" fiber=", 7);
+		buf.appendUInt(event.getFiberId());
+		buf.append(" file=", 6);
+		LogAppendLogfmtValue(buf, event.getFile());
+		buf.append(" line=", 6);
+		buf.appendUInt(event.getLine());
+		buf.append(" msg=", 5);
+		const LogBuffer& msg = event.getMessageBuffer();
+		LogAppendLogfmtValue(buf, std::string_view(msg.data(), msg.size()));
+		LogFieldsToLogfmt(buf, event.getFieldsBuffer());
 	}
 
-	std::string LogFormatter::format(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event)
+	void LogFormatter::addLiteral(const std::string& str)
 	{
-		std::stringstream ss;
-		for (auto& item : m_items)
+		//相邻的常量合并为一条指令
+		if (!m_instructions.empty() && m_instructions.back().op == LITERAL)
 		{
-			item->format(ss, logger, level, event);
+			m_instructions.back().length += static_cast<uint32_t>(str.size());
 		}
-		return ss.str();
+		else
+		{
+			m_instructions.push_back({ LITERAL, static_cast<uint32_t>(m_literals.size()),
+				static_cast<uint32_t>(str.size()) });
+		}
+		m_literals.append(str);
 	}
 
 	/**********************************
@@ -525,27 +2969,35 @@ namespace GameProjectServer
 			%m -- 消息体
 			%p -- 日志级别
 			%r -- 累计毫秒数
+			%R -- 累计秒数(纳秒精度)
+			%N -- 纳秒时间戳
 			%c -- 日志名称
 			%t -- 线程id
 			%n -- 换行
 			%d -- 时间
 			%f -- 文件名
 			%l -- 行号
+			%J -- JSON对象
+			%K -- logfmt
+			%k -- 结构化字段
 		******************************/
-		static std::map<std::string, std::function<FormatItem::ptr(const std::string& str)>> s_format_items = {
-#define XX(str, C) \
-			{ #str, [](const std::string& fmt) { return FormatItem::ptr(std::make_shared<C>(fmt)); } }
-			XX(m, MessageFormatItem),
-			XX(p, LevelFormatItem),
-			XX(r, ElapseFormatItem),
-			XX(c, NameFormatItem),
-			XX(t, ThreadIdFormatItem),
-			XX(n, NewLineFormatItem),
-			XX(d, DateTimeFormatItem),
-			XX(f, FilenameFormatItem),
-			XX(l, LineFormatItem),
-			XX(T, TabFormatItem),
-			XX(F, FiberIdFormatItem)
+		static std::map<std::string, Op> s_format_ops = {
+#define XX(str, op) \
+			{ #str, op }
+			XX(m, MESSAGE),
+			XX(p, LEVEL),
+			XX(r, ELAPSE),
+			XX(R, UPTIME),
+			XX(N, TIMESTAMP),
+			XX(c, NAME),
+			XX(t, THREAD_ID),
+			XX(d, DATETIME),
+			XX(f, FILENAME),
+			XX(l, LINE),
+			XX(F, FIBER_ID),
+			XX(J, JSON),
+			XX(K, LOGFMT),
+			XX(k, FIELDS)
 #undef XX
 		};
 
@@ -553,19 +3005,39 @@ namespace GameProjectServer
 		{
 			if (std::get<2>(i) == 0)
 			{
-				m_items.push_back(FormatItem::ptr(std::make_shared<StringFormatItem>(std::get<0>(i))));
+				addLiteral(std::get<0>(i));
 			}
-			else
+			else if (std::get<0>(i) == "n")
 			{
-				if (auto it = s_format_items.find(std::get<0>(i)); it == s_format_items.end())
-				{
-					m_items.push_back(FormatItem::ptr(std::make_shared<StringFormatItem>("<<error_format %" + std::get<0>(i) + ">>")));
-					m_error = true;
-				}
-				else
+				addLiteral("\n");
+			}
+			else if (std::get<0>(i) == "T")
+			{
+				addLiteral("\t");
+			}
+			else if (auto it = s_format_ops.find(std::get<0>(i)); it == s_format_ops.end())
+			{
+				addLiteral("<<error_format %" + std::get<0>(i) + ">>");
+				m_error = true;
+			}
+			else if (it->second == DATETIME)
+			{
+				m_instructions.push_back({ DATETIME, static_cast<uint32_t>(m_dateTimes.size()), 0 });
+				m_dateTimes.push_back(std::make_shared<DateTimeFormatItem>(std::get<1>(i)));
+			}
+			else if (it->second == JSON || it->second == LOGFMT)
+			{
+				uint32_t date_time = kNoDateTime;
+				if (!std::get<1>(i).empty())
 				{
-					m_items.push_back(it->second(std::get<1>(i)));
+					date_time = static_cast<uint32_t>(m_dateTimes.size());
+					m_dateTimes.push_back(std::make_shared<DateTimeFormatItem>(std::get<1>(i)));
 				}
+				m_instructions.push_back({ it->second, date_time, 0 });
+			}
+			else
+			{
+				m_instructions.push_back({ it->second, 0, 0 });
 			}
 		}
 
@@ -576,24 +3048,51 @@ namespace GameProjectServer
 		m_root.reset(new Logger);
 		m_root->addAppender(LogAppender::ptr(new StdoutLogAppender));
 
-		m_loggers[m_root->getName()] = m_root;
+		LoggerMap* loggers = new LoggerMap;
+		(*loggers)[m_root->getName()] = m_root;
+		m_loggers.store(loggers, std::memory_order_release);
 
 		init();
 	}
 
+	LoggerManager::~LoggerManager()
+	{
+		//停止所有写线程，保证退出前队列中的日志都已输出
+		const LoggerMap* loggers = m_loggers.load(std::memory_order_acquire);
+		for (auto& i : *loggers)
+		{
+			i.second->setSync();
+		}
+		delete loggers;
+	}
+
 	std::string Logger::toYamlString()
 	{
 		YAML::Node node;
 		node["name"] = m_name;
-		if (m_level != LogLevel::UNKNOW)
+		if (getLevel() != LogLevel::UNKNOW)
 		{
-			node["level"] = LogLevel::ToString(m_level);
+			node["level"] = LogLevel::ToString(getLevel());
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (isAsync())
+			{
+				node["queue_size"] = m_queue->getCapacity();
+				node["overflow"] = LogOverflowPolicy::ToString(m_queue->getPolicy());
+				if (m_queue->getPolicy() == LogOverflowPolicy::DROP_BELOW_LEVEL)
+				{
+					node["overflow_level"] = LogLevel::ToString(m_queue->getDropLevel());
+				}
+			}
 		}
-		if (m_formatter)
+		LogEpoch::Guard guard;
+		const LoggerState* state = m_state.load(std::memory_order_acquire);
+		if (state->formatter)
 		{
-			node["formatter"] = m_formatter->getPattern();
+			node["formatter"] = state->formatter->getPattern();
 		}
-		for (auto& appender : m_appenders)
+		for (auto& appender : state->appenders)
 		{
 			node["appenders"].push_back(YAML::Load(appender->toYamlString()));
 		}
@@ -602,32 +3101,78 @@ namespace GameProjectServer
 		return ss.str();
 	}
 
-	Logger::ptr LoggerManager::getLogger(const std::string& name)
+	Logger::ptr LoggerManager::getLogger(std::string_view name)
 	{
-		auto it = m_loggers.find(name);
-		if (it != m_loggers.end())
+		if (Logger::ptr logger = findLogger(name))
+		{
+			return logger;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		//加锁期间其他线程可能已创建
+		const LoggerMap* loggers = m_loggers.load(std::memory_order_acquire);
+		auto it = loggers->find(name);
+		if (it != loggers->end())
 		{
 			return it->second;
 		}
-		Logger::ptr logger(new Logger(name));
+		Logger::ptr logger(new Logger(std::string(name)));
 		logger->m_root = m_root;
-		m_loggers[name] = logger;
+		LoggerMap* copy = new LoggerMap(*loggers);
+		copy->emplace(logger->getName(), logger);
+		m_loggers.store(copy, std::memory_order_release);
+		LogEpoch::Retire(const_cast<LoggerMap*>(loggers));
 		return logger;
 	}
 
+	Logger::ptr LoggerManager::findLogger(std::string_view name) const
+	{
+		LogEpoch::Guard guard;
+		const LoggerMap* loggers = m_loggers.load(std::memory_order_acquire);
+		auto it = loggers->find(name);
+		return it != loggers->end() ? it->second : nullptr;
+	}
+
 	struct LogAppenderDefine
 	{
-		int type = 0;                            //1 File 2 Stdout
+		int type = 0;                            //1 File 2 Stdout 3 Async 4 Binary 5 Mmap 6 RingBuffer 7 Merge 8 Shm
 		LogLevel::Level level = LogLevel::UNKNOW;                           //日志级别
 		std::string formatter;                  //日志格式
-		std::string file;                       //当type = 1时，file为必须项
+		std::string file;                       //当type = 1/3/4/5/7时，file为必须项
+		uint64_t buffer_size = 0;               //缓冲区大小，0为默认值
+		uint32_t flush_interval = 0;            //type = 3/4/7时的刷新间隔(毫秒)，0为默认值
+		LogFlushPolicy flush;                   //type = 1/2时的刷新策略
+		LogRotatePolicy rotate;                 //type = 1时的轮转策略
+		uint32_t coalesce = 0;                  //type = 1/2时合并重复日志的间隔(毫秒)，0为不合并
+		LogCompressPolicy compress;             //type = 1时的分块压缩
+		uint32_t index = 0;                     //type = 1时索引的分块字节数，0为不写索引
+		uint64_t segment_size = 0;              //type = 5时的段文件大小，0为默认值
+		uint64_t capacity = 0;                  //type = 6时每个线程保留的条数，0为默认值
+		LogLevel::Level dump_level = LogLevel::ERROR;   //type = 6时触发输出的级别
+		bool dump_on_signal = true;             //type = 6时是否在致命信号时输出
+		std::string channel;                    //当type = 8时，channel为必须项
+		uint32_t slots = 0;                     //type = 8时创建通道的槽数，0为默认值
+		uint64_t ring_size = 0;                 //type = 8时创建通道的每个槽的字节数，0为默认值
 
 		bool operator==(const LogAppenderDefine& oth) const
 		{
 			return type == oth.type
 				&& level == oth.level
 				&& formatter == oth.formatter
-				&& file == oth.file;
+				&& file == oth.file
+				&& buffer_size == oth.buffer_size
+				&& flush_interval == oth.flush_interval
+				&& flush == oth.flush
+				&& rotate == oth.rotate
+				&& coalesce == oth.coalesce
+				&& compress == oth.compress
+				&& index == oth.index
+				&& segment_size == oth.segment_size
+				&& capacity == oth.capacity
+				&& dump_level == oth.dump_level
+				&& dump_on_signal == oth.dump_on_signal
+				&& channel == oth.channel
+				&& slots == oth.slots
+				&& ring_size == oth.ring_size;
 		}
 	};
 
@@ -637,13 +3182,19 @@ namespace GameProjectServer
 		LogLevel::Level level = LogLevel::UNKNOW;                         //日志器级别
 		std::string formatter;                      //日志格式器
 		std::vector<LogAppenderDefine> appenders; //日志输出地集合
+		uint32_t queue_size = 0;                    //异步队列长度，0为同步输出
+		LogOverflowPolicy::Policy overflow = LogOverflowPolicy::BLOCK;   //队列溢出策略
+		LogLevel::Level overflow_level = LogLevel::WARN;                 //DROP_BELOW_LEVEL时的保留级别
 
 		bool operator==(const LogDefine& oth) const
 		{
 			return name == oth.name
 				&& level == oth.level
 				&& formatter == oth.formatter
-				&& appenders == oth.appenders;
+				&& appenders == oth.appenders
+				&& queue_size == oth.queue_size
+				&& overflow == oth.overflow
+				&& overflow_level == oth.overflow_level;
 		}
 
 		bool operator<(const LogDefine& oth) const
@@ -652,6 +3203,89 @@ namespace GameProjectServer
 		}
 	};
 
+	//File/Stdout appender的缓冲区与刷新策略
+	static void ParseFlushPolicy(const YAML::Node& a, LogAppenderDefine& lad)
+	{
+		if (a["buffer_size"].IsDefined())
+		{
+			lad.buffer_size = a["buffer_size"].as<uint64_t>();
+		}
+		if (a["flush_newline"].IsDefined())
+		{
+			lad.flush.newline = a["flush_newline"].as<bool>();
+		}
+		if (a["flush_bytes"].IsDefined())
+		{
+			lad.flush.bytes = a["flush_bytes"].as<size_t>();
+		}
+		if (a["flush_interval"].IsDefined())
+		{
+			lad.flush.interval = a["flush_interval"].as<uint32_t>();
+		}
+		if (a["flush_level"].IsDefined())
+		{
+			lad.flush.level = LogLevel::FromString(a["flush_level"].as<std::string>());
+		}
+	}
+
+	//File/StdoutLogAppender的重复日志合并
+	static void ParseCoalesce(const YAML::Node& a, LogAppenderDefine& lad)
+	{
+		if (a["coalesce"].IsDefined() && a["coalesce"].as<bool>())
+		{
+			lad.coalesce = a["coalesce_interval"].IsDefined() ?
+				a["coalesce_interval"].as<uint32_t>() : LogRepeatFilter::kDefaultInterval;
+		}
+	}
+
+	//FileLogAppender的轮转策略
+	static void ParseRotatePolicy(const YAML::Node& a, LogAppenderDefine& lad)
+	{
+		if (a["rotate_size"].IsDefined())
+		{
+			lad.rotate.size = a["rotate_size"].as<uint64_t>();
+		}
+		if (a["rotate_interval"].IsDefined())
+		{
+			lad.rotate.interval = a["rotate_interval"].as<uint32_t>();
+		}
+		if (a["max_files"].IsDefined())
+		{
+			lad.rotate.max_files = a["max_files"].as<uint32_t>();
+		}
+		if (a["preallocate"].IsDefined())
+		{
+			lad.rotate.preallocate = a["preallocate"].as<uint64_t>();
+		}
+	}
+
+	//FileLogAppender的分块压缩
+	static void ParseCompress(const YAML::Node& a, LogAppenderDefine& lad)
+	{
+		if (a["compress"].IsDefined() && a["compress"].as<bool>())
+		{
+			lad.compress.enabled = true;
+			if (a["compress_level"].IsDefined())
+			{
+				lad.compress.level = a["compress_level"].as<int>();
+			}
+			if (a["compress_block_size"].IsDefined())
+			{
+				lad.compress.block_size = a["compress_block_size"].as<size_t>();
+			}
+		}
+	}
+
+	//FileLogAppender的旁路索引
+	static void ParseIndex(const YAML::Node& a, LogAppenderDefine& lad)
+	{
+		if (a["index"].IsDefined() && a["index"].as<bool>())
+		{
+			lad.index = a["index_interval"].IsDefined() ?
+				a["index_interval"].as<uint32_t>() : LogFileIndex::kDefaultInterval;
+		}
+	}
+
 	template<>
 	class LexicalCast<std::string, LogDefine>
 	{
@@ -669,6 +3303,18 @@ namespace GameProjectServer
 			ld.level = LogLevel::FromString(node["level"].IsDefined() ?
 				node["level"].as<std::string>() : "");
 			ld.formatter = node["formatter"].IsDefined() ? node["formatter"].as<std::string>() : "";
+			if (node["queue_size"].IsDefined())
+			{
+				ld.queue_size = node["queue_size"].as<uint32_t>();
+			}
+			if (node["overflow"].IsDefined())
+			{
+				ld.overflow = LogOverflowPolicy::FromString(node["overflow"].as<std::string>());
+			}
+			if (node["overflow_level"].IsDefined())
+			{
+				ld.overflow_level = LogLevel::FromString(node["overflow_level"].as<std::string>());
+			}
 			if (node["appenders"].IsDefined())
 			{
 				for (size_t i = 0; i < node["appenders"].size(); ++i)
@@ -694,10 +3340,104 @@ namespace GameProjectServer
 						{
 							lad.formatter = a["formatter"].as<std::string>();
 						}
+						ParseFlushPolicy(a, lad);
+						ParseRotatePolicy(a, lad);
+						ParseCoalesce(a, lad);
+						ParseCompress(a, lad);
+						ParseIndex(a, lad);
 					}
 					else if (type == "StdoutLogAppender")
 					{
 						lad.type = 2;
+						ParseFlushPolicy(a, lad);
+						ParseCoalesce(a, lad);
+					}
+					else if (type == "AsyncLogAppender" || type == "BinaryLogAppender" || type == "MergeLogAppender")
+					{
+						lad.type = type == "AsyncLogAppender" ? 3 : type == "BinaryLogAppender" ? 4 : 7;
+						if (!a["file"].IsDefined())
+						{
+							std::cout << "log appender config error: file is required for " << type << std::endl;
+							continue;
+						}
+						lad.file = a["file"].as<std::string>();
+						if (lad.type != 4 && a["formatter"].IsDefined())
+						{
+							lad.formatter = a["formatter"].as<std::string>();
+						}
+						if (a["buffer_size"].IsDefined())
+						{
+							lad.buffer_size = a["buffer_size"].as<uint64_t>();
+						}
+						if (a["flush_interval"].IsDefined())
+						{
+							lad.flush_interval = a["flush_interval"].as<uint32_t>();
+						}
+					}
+					else if (type == "MmapLogAppender")
+					{
+						lad.type = 5;
+						if (!a["file"].IsDefined())
+						{
+							std::cout << "log appender config error: file is required for MmapLogAppender" << std::endl;
+							continue;
+						}
+						lad.file = a["file"].as<std::string>();
+						if (a["formatter"].IsDefined())
+						{
+							lad.formatter = a["formatter"].as<std::string>();
+						}
+						if (a["segment_size"].IsDefined())
+						{
+							lad.segment_size = a["segment_size"].as<uint64_t>();
+						}
+					}
+					else if (type == "RingBufferLogAppender")
+					{
+						//有file时输出到文件，否则输出到标准输出
+						lad.type = 6;
+						if (a["file"].IsDefined())
+						{
+							lad.file = a["file"].as<std::string>();
+						}
+						if (a["formatter"].IsDefined())
+						{
+							lad.formatter = a["formatter"].as<std::string>();
+						}
+						if (a["capacity"].IsDefined())
+						{
+							lad.capacity = a["capacity"].as<uint64_t>();
+						}
+						if (a["dump_level"].IsDefined())
+						{
+							lad.dump_level = LogLevel::FromString(a["dump_level"].as<std::string>());
+						}
+						if (a["dump_on_signal"].IsDefined())
+						{
+							lad.dump_on_signal = a["dump_on_signal"].as<bool>();
+						}
+					}
+					else if (type == "ShmLogAppender")
+					{
+						lad.type = 8;
+						if (!a["channel"].IsDefined())
+						{
+							std::cout << "log appender config error: channel is required for ShmLogAppender" << std::endl;
+							continue;
+						}
+						lad.channel = a["channel"].as<std::string>();
+						if (a["formatter"].IsDefined())
+						{
+							lad.formatter = a["formatter"].as<std::string>();
+						}
+						if (a["slots"].IsDefined())
+						{
+							lad.slots = a["slots"].as<uint32_t>();
+						}
+						if (a["ring_size"].IsDefined())
+						{
+							lad.ring_size = a["ring_size"].as<uint64_t>();
+						}
 					}
 					else
 					{
@@ -728,6 +3468,15 @@ namespace GameProjectServer
 			{
 				node["formatter"] = ld.formatter;
 			}
+			if (ld.queue_size)
+			{
+				node["queue_size"] = ld.queue_size;
+				node["overflow"] = LogOverflowPolicy::ToString(ld.overflow);
+				if (ld.overflow == LogOverflowPolicy::DROP_BELOW_LEVEL)
+				{
+					node["overflow_level"] = LogLevel::ToString(ld.overflow_level);
+				}
+			}
 			for (auto& a : ld.appenders)
 			{
 				YAML::Node appender_node;
@@ -735,10 +3484,69 @@ namespace GameProjectServer
 				{
 					appender_node["type"] = "FileLogAppender";
 					appender_node["file"] = a.file;
+					FlushPolicyToYaml(appender_node, a.flush,
+						a.buffer_size ? a.buffer_size : LogFileWriter::kDefaultBufferSize);
+					RotatePolicyToYaml(appender_node, a.rotate);
+					CoalesceToYaml(appender_node, a.coalesce);
+					CompressToYaml(appender_node, a.compress);
+					IndexToYaml(appender_node, a.index);
 				}
 				else if (a.type == 2)
 				{
 					appender_node["type"] = "StdoutLogAppender";
+					FlushPolicyToYaml(appender_node, a.flush,
+						a.buffer_size ? a.buffer_size : LogFileWriter::kDefaultBufferSize);
+					CoalesceToYaml(appender_node, a.coalesce);
+				}
+				else if (a.type == 3 || a.type == 4 || a.type == 7)
+				{
+					appender_node["type"] = a.type == 3 ? "AsyncLogAppender"
+						: a.type == 4 ? "BinaryLogAppender" : "MergeLogAppender";
+					appender_node["file"] = a.file;
+					if (a.buffer_size)
+					{
+						appender_node["buffer_size"] = a.buffer_size;
+					}
+					if (a.flush_interval)
+					{
+						appender_node["flush_interval"] = a.flush_interval;
+					}
+				}
+				else if (a.type == 5)
+				{
+					appender_node["type"] = "MmapLogAppender";
+					appender_node["file"] = a.file;
+					if (a.segment_size)
+					{
+						appender_node["segment_size"] = a.segment_size;
+					}
+				}
+				else if (a.type == 6)
+				{
+					appender_node["type"] = "RingBufferLogAppender";
+					if (!a.file.empty())
+					{
+						appender_node["file"] = a.file;
+					}
+					if (a.capacity)
+					{
+						appender_node["capacity"] = a.capacity;
+					}
+					appender_node["dump_level"] = LogLevel::ToString(a.dump_level);
+					appender_node["dump_on_signal"] = a.dump_on_signal;
+				}
+				else if (a.type == 8)
+				{
+					appender_node["type"] = "ShmLogAppender";
+					appender_node["channel"] = a.channel;
+					if (a.slots)
+					{
+						appender_node["slots"] = a.slots;
+					}
+					if (a.ring_size)
+					{
+						appender_node["ring_size"] = a.ring_size;
+					}
 				}
 				if (a.level != LogLevel::UNKNOW)
 				{
@@ -781,27 +3589,81 @@ namespace GameProjectServer
 							if (!(i == *it))
 							{
 								//修改logger
-								//先删除原有的appender
 								logger = NILESTHUMP_LOG_GET_LOGGER(i.name);
 							}
+							else
+							{
+								continue;
+							}
 						}
-						logger->setLevel(i.level);
+						LogFormatter::ptr formatter;
 						if (!i.formatter.empty())
 						{
-							logger->setFormatter(i.formatter);
+							formatter.reset(new LogFormatter(i.formatter));
+							if (formatter->isError())
+							{
+								std::cout << "Logger setFormatter name=" << i.name
+									<< " value=" << i.formatter << " invalid formatter" << std::endl;
+								formatter.reset();
+							}
 						}
 
-						logger->clearAppenders();
+						//新的appender全部创建好后与级别、格式器一起替换，其他线程不会看到中间状态
+						std::vector<LogAppender::ptr> appenders;
 						for (auto& a : i.appenders)
 						{
 							LogAppender::ptr appender;
 							if (a.type == 1)
 							{
-								appender.reset(new FileLogAppender(a.file));
+								FileLogAppender::ptr file(new FileLogAppender(a.file, a.buffer_size, a.compress, a.index));
+								file->setFlushPolicy(a.flush);
+								file->setRotatePolicy(a.rotate);
+								file->setCoalesce(a.coalesce);
+								appender = file;
 							}
 							else if (a.type == 2)
 							{
-								appender.reset(new StdoutLogAppender);
+								StdoutLogAppender::ptr out(new StdoutLogAppender(a.buffer_size));
+								out->setFlushPolicy(a.flush);
+								out->setCoalesce(a.coalesce);
+								appender = out;
+							}
+							else if (a.type == 3)
+							{
+								appender.reset(new AsyncLogAppender(a.file, a.buffer_size, a.flush_interval));
+							}
+							else if (a.type == 4)
+							{
+								appender.reset(new BinaryLogAppender(a.file, a.buffer_size, a.flush_interval));
+							}
+							else if (a.type == 7)
+							{
+								appender.reset(new MergeLogAppender(a.file, a.buffer_size, a.flush_interval));
+							}
+							else if (a.type == 5)
+							{
+								appender.reset(new MmapLogAppender(a.file, a.segment_size));
+							}
+							else if (a.type == 6)
+							{
+								LogAppender::ptr target;
+								if (!a.file.empty())
+								{
+									target.reset(new FileLogAppender(a.file, a.buffer_size));
+								}
+								else
+								{
+									target.reset(new StdoutLogAppender(a.buffer_size));
+								}
+								appender.reset(new RingBufferLogAppender(target, a.capacity, a.dump_level));
+								if (a.dump_on_signal)
+								{
+									RingBufferLogAppender::InstallSignalHandler();
+								}
+							}
+							else if (a.type == 8)
+							{
+								appender.reset(new ShmLogAppender(a.channel, a.slots, a.ring_size));
 							}
 							appender->setLevel(a.level);
 							if (!a.formatter.empty())
@@ -817,7 +3679,16 @@ namespace GameProjectServer
 										" formatter = " << a.formatter << " is invalid" << std::endl;
 								}
 							}
-							logger->addAppender(appender);
+							appenders.push_back(appender);
+						}
+						logger->reconfigure(i.level, formatter, appenders);
+						if (i.queue_size)
+						{
+							logger->setAsync(i.queue_size, i.overflow, i.overflow_level);
+						}
+						else
+						{
+							logger->setSync();
 						}
 					}
 					//修改
@@ -829,8 +3700,8 @@ namespace GameProjectServer
 						{
 							//删除logger
 							auto logger = NILESTHUMP_LOG_GET_LOGGER(i.name);
-							logger->setLevel((LogLevel::Level)100);
-							logger->clearAppenders();
+							logger->setSync();
+							logger->reconfigure((LogLevel::Level)100, nullptr, {});
 						}
 						else
 						{
@@ -850,7 +3721,8 @@ namespace GameProjectServer
 	std::string LoggerManager::toYamlString()
 	{
 		YAML::Node node;
-		for (auto& i : m_loggers)
+		LogEpoch::Guard guard;
+		for (auto& i : *m_loggers.load(std::memory_order_acquire))
 		{
 			node.push_back(YAML::Load(i.second->toYamlString()));
 		}
@@ -859,6 +3731,38 @@ namespace GameProjectServer
 		return ss.str();
 	}
 
+	std::string LoggerManager::toSiteStatsYamlString(size_t top_n)
+	{
+		std::vector<LogSiteStats> stats = LogSiteCollect();
+		auto cost_greater = [](const LogSiteStats& a, const LogSiteStats& b) {
+			return a.bytes != b.bytes ? a.bytes > b.bytes : a.emitted > b.emitted;
+		};
+		if (top_n < stats.size())
+		{
+			std::partial_sort(stats.begin(), stats.begin() + top_n, stats.end(), cost_greater);
+			stats.resize(top_n);
+		}
+		else
+		{
+			std::sort(stats.begin(), stats.end(), cost_greater);
+		}
+		YAML::Node node(YAML::NodeType::Sequence);
+		for (auto& i : stats)
+		{
+			YAML::Node site;
+			site["file"] = i.file;
+			site["line"] = i.line;
+			site["level"] = LogLevel::ToString(static_cast<LogLevel::Level>(i.level));
+			site["emitted"] = i.emitted;
+			site["suppressed"] = i.suppressed;
+			site["bytes"] = i.bytes;
+			node.push_back(site);
+		}
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
 	void LoggerManager::init()
 	{
 
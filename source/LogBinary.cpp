@@ -0,0 +1,105 @@
+#include "LogBinary.h"
+#include "Util.h"
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace GameProjectServer
+{
+	//调用点与日志器注册表，只在首次使用和写出定义时加锁访问
+	struct LogBinaryRegistry
+	{
+		std::mutex mutex;
+		std::deque<LogBinarySiteInfo> sites;
+		std::vector<std::string> loggers;
+		std::unordered_map<std::string, uint32_t> loggerIds;
+	};
+
+	static LogBinaryRegistry& GetRegistry()
+	{
+		static LogBinaryRegistry s_registry;
+		return s_registry;
+	}
+
+	uint32_t LogBinaryRegisterSite(LogBinarySite& site, const uint8_t* types, size_t count)
+	{
+		LogBinaryRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		uint32_t id = site.id.load(std::memory_order_relaxed);
+		if (id)
+		{
+			return id;
+		}
+		LogBinarySiteInfo info;
+		info.file = site.file;
+		info.line = site.line;
+		info.level = site.level;
+		info.fmt = site.fmt;
+		info.types.assign(reinterpret_cast<const char*>(types), count);
+		registry.sites.push_back(std::move(info));
+		id = static_cast<uint32_t>(registry.sites.size());
+		site.id.store(id, std::memory_order_release);
+		return id;
+	}
+
+	uint32_t LogBinaryRegisterLogger(const std::string& name)
+	{
+		LogBinaryRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		auto it = registry.loggerIds.find(name);
+		if (it != registry.loggerIds.end())
+		{
+			return it->second;
+		}
+		registry.loggers.push_back(name);
+		uint32_t id = static_cast<uint32_t>(registry.loggers.size());
+		registry.loggerIds[name] = id;
+		return id;
+	}
+
+	bool LogBinaryGetSite(uint32_t id, LogBinarySiteInfo& info)
+	{
+		LogBinaryRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		if (id == 0 || id > registry.sites.size())
+		{
+			return false;
+		}
+		info = registry.sites[id - 1];
+		return true;
+	}
+
+	bool LogBinaryGetLogger(uint32_t id, std::string& name)
+	{
+		LogBinaryRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		if (id == 0 || id > registry.loggers.size())
+		{
+			return false;
+		}
+		name = registry.loggers[id - 1];
+		return true;
+	}
+
+	LogBuffer& LogBinaryThreadBuffer()
+	{
+		static thread_local LogBuffer s_buffer;
+		s_buffer.clear();
+		return s_buffer;
+	}
+
+	void LogBinaryBeginEvent(LogBuffer& buf, uint32_t site, uint32_t logger)
+	{
+		uint64_t time = 0;
+		uint64_t elapse = 0;
+		GetClockNS(time, elapse);
+		buf.append(static_cast<char>(LogBinaryRecord::EVENT));
+		LogBinaryPut(buf, site);
+		LogBinaryPut(buf, logger);
+		LogBinaryPut(buf, time);
+		LogBinaryPut(buf, elapse);
+		LogBinaryPut(buf, GetThreadId());
+		LogBinaryPut(buf, GetFiberId());
+	}
+}
\ No newline at end of file
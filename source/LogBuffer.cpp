@@ -0,0 +1,84 @@
+#include "LogBuffer.h"
+#include <charconv>
+
+namespace GameProjectServer
+{
+	static const char s_digits[] =
+		"00010203040506070809"
+		"10111213141516171819"
+		"20212223242526272829"
+		"30313233343536373839"
+		"40414243444546474849"
+		"50515253545556575859"
+		"60616263646566676869"
+		"70717273747576777879"
+		"80818283848586878889"
+		"90919293949596979899";
+
+	void LogBuffer::grow(size_t need)
+	{
+		size_t capacity = m_capacity * 2;
+		if (capacity < need)
+		{
+			capacity = need;
+		}
+		char* data = new char[capacity];
+		memcpy(data, m_data, m_size);
+		if (m_data != m_inline)
+		{
+			delete[] m_data;
+		}
+		m_data = data;
+		m_capacity = capacity;
+	}
+
+	void LogBuffer::appendUInt(uint64_t v)
+	{
+		//从低位开始每次转换两位数字
+		char buf[20];
+		char* p = buf + sizeof(buf);
+		while (v >= 100)
+		{
+			size_t idx = (v % 100) * 2;
+			v /= 100;
+			*--p = s_digits[idx + 1];
+			*--p = s_digits[idx];
+		}
+		if (v >= 10)
+		{
+			size_t idx = v * 2;
+			*--p = s_digits[idx + 1];
+			*--p = s_digits[idx];
+		}
+		else
+		{
+			*--p = static_cast<char>('0' + v);
+		}
+		append(p, buf + sizeof(buf) - p);
+	}
+
+	void LogBuffer::appendInt(int64_t v)
+	{
+		if (v < 0)
+		{
+			append('-');
+			appendUInt(0 - static_cast<uint64_t>(v));
+			return;
+		}
+		appendUInt(static_cast<uint64_t>(v));
+	}
+
+	void LogBuffer::appendDouble(double v)
+	{
+		char* p = prepare(32);
+		auto res = std::to_chars(p, p + 32, v);
+		commit(res.ptr - p);
+	}
+
+	void LogBuffer::appendFloat(float v)
+	{
+		char* p = prepare(32);
+		auto res = std::to_chars(p, p + 32, v);
+		commit(res.ptr - p);
+	}
+}
@@ -0,0 +1,209 @@
+#include "LogEpoch.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GameProjectServer
+{
+	/***************************************************
+		每个线程一条的读者记录，挂在全局链表上永不释放，
+		线程退出后标记为空闲，由之后的新线程复用
+	***************************************************/
+	struct LogEpochRecord
+	{
+		std::atomic<uint64_t> epoch{ 0 };   //公布的纪元，0为不在临界区
+		std::atomic<bool> used{ false };    //是否被某个线程占用
+		uint32_t depth = 0;                 //临界区嵌套层数，只由所属线程访问
+		LogEpochRecord* next = nullptr;
+	};
+
+	//待释放的对象
+	struct LogEpochRetired
+	{
+		void* ptr;
+		void (*deleter)(void*);
+		uint64_t epoch;     //摘下时的纪元
+	};
+
+	//全局纪元从1开始，0表示读者不在临界区
+	static std::atomic<uint64_t> s_epoch{ 1 };
+	static std::atomic<LogEpochRecord*> s_records{ nullptr };
+
+	//故意不释放，进程退出时线程局部对象仍可能访问
+	static std::mutex& GetRetiredMutex()
+	{
+		static std::mutex* s_mutex = new std::mutex;
+		return *s_mutex;
+	}
+
+	static std::vector<LogEpochRetired>& GetRetired()
+	{
+		static std::vector<LogEpochRetired>* s_retired = new std::vector<LogEpochRetired>;
+		return *s_retired;
+	}
+
+	static LogEpochRecord* AcquireRecord()
+	{
+		for (LogEpochRecord* r = s_records.load(std::memory_order_acquire); r; r = r->next)
+		{
+			bool expected = false;
+			if (!r->used.load(std::memory_order_relaxed)
+				&& r->used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+			{
+				return r;
+			}
+		}
+		LogEpochRecord* r = new LogEpochRecord;
+		r->used.store(true, std::memory_order_relaxed);
+		LogEpochRecord* head = s_records.load(std::memory_order_relaxed);
+		do
+		{
+			r->next = head;
+		} while (!s_records.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+		return r;
+	}
+
+	//线程退出时归还记录
+	struct LogEpochRecordHolder
+	{
+		LogEpochRecord* record = nullptr;
+
+		~LogEpochRecordHolder()
+		{
+			if (record)
+			{
+				record->epoch.store(0, std::memory_order_release);
+				record->depth = 0;
+				record->used.store(false, std::memory_order_release);
+				record = nullptr;
+			}
+		}
+	};
+
+	static LogEpochRecord* GetLogEpochRecord()
+	{
+		static thread_local LogEpochRecordHolder s_holder;
+		if (!s_holder.record)
+		{
+			s_holder.record = AcquireRecord();
+		}
+		return s_holder.record;
+	}
+
+	LogEpoch::Guard::Guard()
+		: m_record(GetLogEpochRecord())
+	{
+		if (m_record->depth++ == 0)
+		{
+			/***************************************************
+				先公布纪元再读取受保护的指针，fence保证写者
+				在替换指针之后的扫描能看到公布的纪元，
+				或者本线程读到的已是新指针
+			***************************************************/
+			m_record->epoch.store(s_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+		}
+	}
+
+	LogEpoch::Guard::~Guard()
+	{
+		if (--m_record->depth == 0)
+		{
+			m_record->epoch.store(0, std::memory_order_release);
+		}
+	}
+
+	void LogEpoch::Retire(void* ptr, void (*deleter)(void*))
+	{
+		if (!ptr)
+		{
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(GetRetiredMutex());
+			//调用者已替换掉ptr的发布位置，此后进入的读者公布的纪元更大
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			uint64_t epoch = s_epoch.fetch_add(1, std::memory_order_acq_rel);
+			GetRetired().push_back({ ptr, deleter, epoch });
+		}
+		Reclaim();
+	}
+
+	void LogEpoch::Reclaim()
+	{
+		std::vector<LogEpochRetired> ready;
+		{
+			std::lock_guard<std::mutex> lock(GetRetiredMutex());
+			std::vector<LogEpochRetired>& retired = GetRetired();
+			if (retired.empty())
+			{
+				return;
+			}
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			//在临界区中的读者公布的最小纪元
+			uint64_t min_epoch = UINT64_MAX;
+			for (LogEpochRecord* r = s_records.load(std::memory_order_acquire); r; r = r->next)
+			{
+				uint64_t epoch = r->epoch.load(std::memory_order_acquire);
+				if (epoch && epoch < min_epoch)
+				{
+					min_epoch = epoch;
+				}
+			}
+			size_t n = 0;
+			for (size_t i = 0; i < retired.size(); ++i)
+			{
+				if (retired[i].epoch < min_epoch)
+				{
+					ready.push_back(retired[i]);
+				}
+				else
+				{
+					retired[n++] = retired[i];
+				}
+			}
+			retired.resize(n);
+		}
+		//在锁外释放，析构中可能再次Retire
+		for (auto& i : ready)
+		{
+			i.deleter(i.ptr);
+		}
+	}
+
+	void LogEpoch::Synchronize()
+	{
+		//与Guard中的fence配对：读者或者被下面的扫描看到，或者读到调用前的修改
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		uint64_t epoch = s_epoch.fetch_add(1, std::memory_order_acq_rel);
+		LogEpochRecord* self = GetLogEpochRecord();
+		for (LogEpochRecord* r = s_records.load(std::memory_order_acquire); r; r = r->next)
+		{
+			if (r == self)
+			{
+				continue;
+			}
+			while (true)
+			{
+				uint64_t e = r->epoch.load(std::memory_order_acquire);
+				if (!e || e > epoch)
+				{
+					break;
+				}
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	size_t LogEpoch::GetPendingCount()
+	{
+		std::lock_guard<std::mutex> lock(GetRetiredMutex());
+		return GetRetired().size();
+	}
+
+	uint64_t LogEpoch::GetEpoch()
+	{
+		return s_epoch.load(std::memory_order_relaxed);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "LogFields.h"
+
+namespace GameProjectServer
+{
+	/***************************************************
+		每个字节的转义方式
+		json: 0为无需转义，否则为反斜杠后的字符，'u'为\u00XX
+		logfmt: 值中出现时需要加引号
+	***************************************************/
+	struct LogEscapeTable
+	{
+		constexpr LogEscapeTable()
+			: json()
+			, logfmt()
+		{
+			for (int c = 0; c < 0x20; ++c)
+			{
+				json[c] = 'u';
+				logfmt[c] = true;
+			}
+			json['\b'] = 'b';
+			json['\f'] = 'f';
+			json['\n'] = 'n';
+			json['\r'] = 'r';
+			json['\t'] = 't';
+			json['"'] = '"';
+			json['\\'] = '\\';
+			logfmt[' '] = true;
+			logfmt['='] = true;
+			logfmt['"'] = true;
+			logfmt[0x7f] = true;
+		}
+
+		char json[256];
+		bool logfmt[256];
+	};
+
+	static constexpr LogEscapeTable s_escape;
+
+	//8个字节中没有控制字符、引号与反斜杠
+	static inline bool JsonSafeWord(uint64_t w)
+	{
+		constexpr uint64_t kOnes = 0x0101010101010101ULL;
+		constexpr uint64_t kHigh = 0x8080808080808080ULL;
+		uint64_t quote = w ^ (kOnes * '"');
+		uint64_t slash = w ^ (kOnes * '\\');
+		uint64_t hit = ((w - kOnes * 0x20) & ~w)
+			| ((quote - kOnes) & ~quote)
+			| ((slash - kOnes) & ~slash);
+		return !(hit & kHigh);
+	}
+
+	void LogEscapeJson(LogBuffer& buf, const char* str, size_t len)
+	{
+		static const char s_hex[] = "0123456789abcdef";
+		const char* end = str + len;
+		const char* run = str;      //尚未拷贝的无需转义的字节
+		const char* p = str;
+		while (p < end)
+		{
+			uint64_t w;
+			while (end - p >= 8 && (memcpy(&w, p, 8), JsonSafeWord(w)))
+			{
+				p += 8;
+			}
+			while (p < end && !s_escape.json[static_cast<uint8_t>(*p)])
+			{
+				++p;
+			}
+			if (p == end)
+			{
+				break;
+			}
+			buf.append(run, p - run);
+			uint8_t c = static_cast<uint8_t>(*p);
+			if (s_escape.json[c] == 'u')
+			{
+				char esc[6] = { '\\', 'u', '0', '0', s_hex[c >> 4], s_hex[c & 0xf] };
+				buf.append(esc, sizeof(esc));
+			}
+			else
+			{
+				char esc[2] = { '\\', s_escape.json[c] };
+				buf.append(esc, sizeof(esc));
+			}
+			run = ++p;
+		}
+		buf.append(run, end - run);
+	}
+
+	void LogAppendLogfmtValue(LogBuffer& buf, std::string_view str)
+	{
+		bool quote = str.empty();
+		for (char c : str)
+		{
+			if (s_escape.logfmt[static_cast<uint8_t>(c)])
+			{
+				quote = true;
+				break;
+			}
+		}
+		if (!quote)
+		{
+			buf.append(str.data(), str.size());
+			return;
+		}
+		buf.append('"');
+		LogEscapeJson(buf, str.data(), str.size());
+		buf.append('"');
+	}
+
+	void LogAppendLogfmtKey(LogBuffer& buf, std::string_view key)
+	{
+		if (key.empty())
+		{
+			buf.append('_');
+			return;
+		}
+		char* p = buf.prepare(key.size());
+		for (size_t i = 0; i < key.size(); ++i)
+		{
+			p[i] = s_escape.logfmt[static_cast<uint8_t>(key[i])] ? '_' : key[i];
+		}
+		buf.commit(key.size());
+	}
+
+	void LogFieldsToJson(LogBuffer& out, const LogBuffer& fields)
+	{
+		LogFieldsForEach(fields, [&out](LogFieldType type, std::string_view key, std::string_view value) {
+			out.append(',');
+			LogAppendJsonString(out, key);
+			out.append(':');
+			if (type == kLogFieldString)
+			{
+				LogAppendJsonString(out, value);
+			}
+			else
+			{
+				out.append(value.data(), value.size());
+			}
+		});
+	}
+
+	void LogFieldsToLogfmt(LogBuffer& out, const LogBuffer& fields)
+	{
+		LogFieldsForEach(fields, [&out](LogFieldType type, std::string_view key, std::string_view value) {
+			out.append(' ');
+			LogAppendLogfmtKey(out, key);
+			out.append('=');
+			if (type == kLogFieldString)
+			{
+				LogAppendLogfmtValue(out, value);
+			}
+			else
+			{
+				out.append(value.data(), value.size());
+			}
+		});
+	}
+}
\ No newline at end of file
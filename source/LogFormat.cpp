@@ -0,0 +1,26 @@
+#include "LogFormat.h"
+
+namespace GameProjectServer
+{
+	const char* LogFormatLiteral(LogBuffer& buf, const char* fmt)
+	{
+		const char* begin = fmt;
+		for (; *fmt; ++fmt)
+		{
+			if (*fmt == '{' && fmt[1] == '}')
+			{
+				buf.append(begin, fmt - begin);
+				return fmt + 2;
+			}
+			if ((*fmt == '{' && fmt[1] == '{') || (*fmt == '}' && fmt[1] == '}'))
+			{
+				//转义的花括号只输出一个
+				buf.append(begin, fmt - begin + 1);
+				++fmt;
+				begin = fmt + 1;
+			}
+		}
+		buf.append(begin, fmt - begin);
+		return nullptr;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "LogIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace GameProjectServer
+{
+	//已有的索引文件是否可以继续追加
+	static bool CheckIndexFile(const std::string& index_file)
+	{
+		std::ifstream in(index_file, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+		if (!in)
+		{
+			return false;
+		}
+		uint64_t size = static_cast<uint64_t>(in.tellg());
+		LogIndexHeader header;
+		if (size < sizeof(header) || (size - sizeof(header)) % sizeof(LogIndexEntry))
+		{
+			return false;
+		}
+		in.seekg(0);
+		in.read(reinterpret_cast<char*>(&header), sizeof(header));
+		return in && !memcmp(header.magic, kLogIndexMagic, sizeof(header.magic))
+			&& header.entrySize == sizeof(LogIndexEntry);
+	}
+
+	LogFileIndex::ptr LogFileIndex::Open(const std::string& filename, LogFileWriter::ptr target, uint32_t interval)
+	{
+		if (!interval)
+		{
+			interval = kDefaultInterval;
+		}
+		std::string index_file = GetIndexName(filename);
+		//日志文件是新建的时，旧索引中的偏移已经无效
+		bool append = target->getFileSize() && CheckIndexFile(index_file);
+		//记录很少，不需要大的缓冲区
+		LogFileWriter::ptr index = std::make_shared<LogFileWriter>(sizeof(LogIndexEntry) * 16);
+		if (!index->open(index_file, append))
+		{
+			return nullptr;
+		}
+		if (!append)
+		{
+			LogIndexHeader header = {};
+			memcpy(header.magic, kLogIndexMagic, sizeof(header.magic));
+			header.interval = interval;
+			header.entrySize = sizeof(LogIndexEntry);
+			index->write(reinterpret_cast<const char*>(&header), sizeof(header), true);
+		}
+		return ptr(new LogFileIndex(std::move(target), std::move(index), interval));
+	}
+
+	LogFileIndex::LogFileIndex(LogFileWriter::ptr target, LogFileWriter::ptr index, uint32_t interval)
+		: m_target(std::move(target))
+		, m_index(std::move(index))
+		, m_interval(interval)
+		, m_entry()
+	{
+	}
+
+	LogFileIndex::~LogFileIndex()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		closeEntry(m_target->getFileSize(), true);
+	}
+
+	void LogFileIndex::write(const char* data, size_t len, bool flush, uint64_t time, uint8_t level)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		uint64_t offset = m_target->getFileSize();
+		//块达到分块字节数后，下一行开始新的块
+		if (m_entry.count && offset - m_entry.offset >= m_interval)
+		{
+			closeEntry(offset, false);
+		}
+		if (!m_entry.count)
+		{
+			m_entry.offset = offset;
+			m_entry.minTime = UINT64_MAX;
+			m_entry.maxTime = 0;
+			m_entry.maxLevel = 0;
+		}
+		m_target->write(data, len, flush);
+		++m_entry.count;
+		if (time)
+		{
+			m_entry.minTime = std::min(m_entry.minTime, time);
+			m_entry.maxTime = std::max(m_entry.maxTime, time);
+		}
+		m_entry.maxLevel = std::max(m_entry.maxLevel, level);
+	}
+
+	void LogFileIndex::flush()
+	{
+		m_target->flush();
+		m_index->flush();
+	}
+
+	uint64_t LogFileIndex::getEntryCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_entries;
+	}
+
+	void LogFileIndex::closeEntry(uint64_t end, bool flush)
+	{
+		if (!m_entry.count)
+		{
+			return;
+		}
+		m_entry.length = static_cast<uint32_t>(end - m_entry.offset);
+		//只有重复计数行的块没有时间，不会被按时间选中
+		if (m_entry.minTime > m_entry.maxTime)
+		{
+			m_entry.minTime = m_entry.maxTime = 0;
+		}
+		//记录在数据之后才有意义，日志文件中缓冲的数据先写出
+		m_target->flush();
+		m_index->write(reinterpret_cast<const char*>(&m_entry), sizeof(m_entry), flush);
+		++m_entries;
+		m_entry.count = 0;
+	}
+
+	bool LogFileIndex::Load(const std::string& index_file, std::vector<LogIndexEntry>& entries)
+	{
+		std::ifstream in(index_file, std::ios_base::in | std::ios_base::binary);
+		LogIndexHeader header;
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+			|| memcmp(header.magic, kLogIndexMagic, sizeof(header.magic))
+			|| header.entrySize != sizeof(LogIndexEntry))
+		{
+			return false;
+		}
+		entries.clear();
+		LogIndexEntry entry;
+		while (in.read(reinterpret_cast<char*>(&entry), sizeof(entry)))
+		{
+			entries.push_back(entry);
+		}
+		//按偏移排序，查找时据此找出没有索引的空隙
+		std::stable_sort(entries.begin(), entries.end(), [](const LogIndexEntry& a, const LogIndexEntry& b) {
+			return a.offset < b.offset;
+		});
+		return true;
+	}
+
+	std::vector<LogIndexRange> LogFileIndex::Select(const std::vector<LogIndexEntry>& entries, uint64_t file_size,
+		uint64_t from, uint64_t to, uint8_t min_level)
+	{
+		std::vector<LogIndexRange> ranges;
+		auto add = [&ranges, file_size](uint64_t begin, uint64_t end) {
+			end = std::min(end, file_size);
+			if (begin >= end)
+			{
+				return;
+			}
+			if (!ranges.empty() && ranges.back().end >= begin)
+			{
+				ranges.back().end = std::max(ranges.back().end, end);
+			}
+			else
+			{
+				ranges.push_back({ begin, end });
+			}
+		};
+		uint64_t covered = 0;   //已处理到的位置
+		for (auto& i : entries)
+		{
+			//记录之间的空隙没有索引
+			if (i.offset > covered)
+			{
+				add(covered, i.offset);
+			}
+			uint64_t end = i.offset + i.length;
+			if (i.maxTime >= from && i.minTime <= to && i.maxLevel >= min_level)
+			{
+				add(i.offset, end);
+			}
+			covered = std::max(covered, end);
+		}
+		add(covered, file_size);
+		return ranges;
+	}
+}
\ No newline at end of file
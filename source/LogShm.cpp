@@ -0,0 +1,459 @@
+#include "LogShm.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+#include "Util.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace GameProjectServer
+{
+	//共享内存段头，之后是各槽的位置信息，再之后是各槽的环形缓冲区
+	struct LogShmHeader
+	{
+		char magic[8];                      //LogShmChannel::kMagic，初始化完成后写入
+		uint32_t slotCount;                 //槽数
+		uint32_t reserved;
+		uint64_t ringSize;                  //每个槽的环形缓冲区字节数
+		std::atomic<uint64_t> collector;    //收集进程id，0为没有
+	};
+
+	//写入进程与收集进程各自修改的位置放在不同的缓存行
+	struct LogShmSlot
+	{
+		alignas(64) std::atomic<uint64_t> owner;    //占用槽的进程id，0为空闲
+		std::atomic<uint64_t> dropped;              //空间不足丢弃的日志数
+		alignas(64) std::atomic<uint64_t> head;     //已预留到的位置
+		alignas(64) std::atomic<uint64_t> tail;     //收集进程已取出到的位置
+	};
+
+	/***************************************************
+		环形缓冲区中的一条记录，按记录头大小对齐；
+		位置只增不减，取模得到下标，末尾放不下时
+		先写入回绕标记，从头开始写
+	***************************************************/
+	struct LogShmRecord
+	{
+		std::atomic<uint32_t> state;        //0为未提交，kRecord为日志，kWrap为回绕标记
+		uint32_t length;                    //日志长度
+		uint64_t time;                      //日志时间戳(纳秒)
+	};
+
+	static constexpr uint32_t kRecord = 1;
+	static constexpr uint32_t kWrap = 2;
+	static constexpr size_t kHeaderSize = 64;
+	static_assert(sizeof(LogShmHeader) <= kHeaderSize, "shm log header too large");
+	static_assert(sizeof(LogShmSlot) == 192, "shm log slot layout changed");
+	static_assert(sizeof(LogShmRecord) == 16, "shm log record layout changed");
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "shm log needs a lock-free 64-bit atomic");
+	static_assert(std::atomic<uint32_t>::is_always_lock_free, "shm log needs a lock-free 32-bit atomic");
+
+	static uint64_t GetProcessID()
+	{
+#ifdef _WIN32
+		return GetCurrentProcessId();
+#else
+		return static_cast<uint64_t>(getpid());
+#endif
+	}
+
+	//进程是否仍在运行
+	static bool IsProcessAlive(uint64_t pid)
+	{
+#ifdef _WIN32
+		HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+		if (!process)
+		{
+			return GetLastError() == ERROR_ACCESS_DENIED;
+		}
+		bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+		CloseHandle(process);
+		return alive;
+#else
+		return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+	}
+
+	static size_t RecordSize(size_t len)
+	{
+		return sizeof(LogShmRecord) + (len + sizeof(LogShmRecord) - 1) / sizeof(LogShmRecord) * sizeof(LogShmRecord);
+	}
+
+	static uint64_t SegmentSize(uint32_t slot_count, uint64_t ring_size)
+	{
+		return kHeaderSize + slot_count * (sizeof(LogShmSlot) + ring_size);
+	}
+
+	LogShmChannel::ptr LogShmChannel::Open(const std::string& name, uint32_t slot_count, uint64_t ring_size)
+	{
+		slot_count = std::min<uint32_t>(std::max<uint32_t>(slot_count, 1), 1024);
+		//按页对齐，每个环形缓冲区都从缓存行开始
+		ring_size = std::max<uint64_t>((ring_size + 4095) / 4096 * 4096, 4096);
+		uint64_t size = SegmentSize(slot_count, ring_size);
+		ptr channel(new LogShmChannel);
+		channel->m_name = name;
+#ifdef _WIN32
+		std::string path = "Local\\" + name;
+		HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+			static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), path.c_str());
+		if (!mapping)
+		{
+			return nullptr;
+		}
+		bool created = GetLastError() != ERROR_ALREADY_EXISTS;
+		channel->m_mapping = mapping;
+		//映射整个已有的段，大小由创建者决定
+		void* base = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+		if (!base)
+		{
+			return nullptr;
+		}
+		channel->m_base = static_cast<char*>(base);
+		if (!created)
+		{
+			MEMORY_BASIC_INFORMATION info;
+			size = VirtualQuery(base, &info, sizeof(info)) ? info.RegionSize : 0;
+		}
+		channel->m_size = size;
+#else
+		std::string path = "/" + name;
+		int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+		bool created = fd >= 0;
+		if (!created)
+		{
+			fd = errno == EEXIST ? shm_open(path.c_str(), O_RDWR, 0) : -1;
+			if (fd < 0)
+			{
+				return nullptr;
+			}
+			//创建者设置长度后才能映射
+			struct stat st = {};
+			for (int i = 0; i < 100 && fstat(fd, &st) == 0 && st.st_size < static_cast<off_t>(kHeaderSize); ++i)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+			size = static_cast<uint64_t>(st.st_size);
+		}
+		channel->m_fd = fd;
+#ifdef __linux__
+		//实际分配内存，避免写入映射时因/dev/shm空间不足收到SIGBUS
+		if (created && posix_fallocate(fd, 0, static_cast<off_t>(size)) != 0)
+#else
+		if (created && ftruncate(fd, static_cast<off_t>(size)) != 0)
+#endif
+		{
+			shm_unlink(path.c_str());
+			return nullptr;
+		}
+		if (size < kHeaderSize)
+		{
+			std::cout << "LogShmChannel open name=" << name << " failed: segment is not initialized" << std::endl;
+			return nullptr;
+		}
+		void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (base == MAP_FAILED)
+		{
+			return nullptr;
+		}
+		channel->m_base = static_cast<char*>(base);
+		channel->m_size = size;
+#endif
+		LogShmHeader* header = reinterpret_cast<LogShmHeader*>(channel->m_base);
+		channel->m_header = header;
+		if (created)
+		{
+			//新建的段内容全为0，位置与提交标记都不需要再初始化
+			new (header) LogShmHeader;
+			header->slotCount = slot_count;
+			header->ringSize = ring_size;
+			header->collector.store(0, std::memory_order_relaxed);
+			for (uint32_t i = 0; i < slot_count; ++i)
+			{
+				new (channel->getSlot(i)) LogShmSlot();
+			}
+			//最后写入魔数，其他进程据此判断初始化已完成
+			std::atomic_thread_fence(std::memory_order_release);
+			memcpy(header->magic, kMagic, sizeof(kMagic));
+		}
+		else
+		{
+			for (int i = 0; i < 100 && memcmp(header->magic, kMagic, sizeof(kMagic)) != 0; ++i)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0
+				|| header->slotCount == 0 || SegmentSize(header->slotCount, header->ringSize) > channel->m_size)
+			{
+				std::cout << "LogShmChannel open name=" << name << " failed: invalid segment" << std::endl;
+				return nullptr;
+			}
+		}
+		channel->m_slotCount = header->slotCount;
+		channel->m_ringSize = header->ringSize;
+		return channel;
+	}
+
+	bool LogShmChannel::Remove(const std::string& name)
+	{
+#ifdef _WIN32
+		return true;
+#else
+		return shm_unlink(("/" + name).c_str()) == 0;
+#endif
+	}
+
+	LogShmChannel::~LogShmChannel()
+	{
+#ifdef _WIN32
+		if (m_base)
+		{
+			UnmapViewOfFile(m_base);
+		}
+		if (m_mapping)
+		{
+			CloseHandle(static_cast<HANDLE>(m_mapping));
+		}
+#else
+		if (m_base)
+		{
+			munmap(m_base, m_size);
+		}
+		if (m_fd >= 0)
+		{
+			::close(m_fd);
+		}
+#endif
+	}
+
+	LogShmSlot* LogShmChannel::getSlot(uint32_t slot) const
+	{
+		return reinterpret_cast<LogShmSlot*>(m_base + kHeaderSize) + slot;
+	}
+
+	char* LogShmChannel::getRing(uint32_t slot) const
+	{
+		return m_base + kHeaderSize + m_slotCount * sizeof(LogShmSlot) + slot * m_ringSize;
+	}
+
+	int32_t LogShmChannel::acquireSlot()
+	{
+		uint64_t pid = GetProcessID();
+		for (uint32_t i = 0; i < m_slotCount; ++i)
+		{
+			uint64_t expected = 0;
+			if (getSlot(i)->owner.compare_exchange_strong(expected, pid, std::memory_order_acquire))
+			{
+				return static_cast<int32_t>(i);
+			}
+		}
+		return -1;
+	}
+
+	void LogShmChannel::releaseSlot(uint32_t slot)
+	{
+		uint64_t pid = GetProcessID();
+		getSlot(slot)->owner.compare_exchange_strong(pid, 0, std::memory_order_release);
+	}
+
+	bool LogShmChannel::append(uint32_t slot, uint64_t time, const char* data, size_t len)
+	{
+		LogShmSlot* s = getSlot(slot);
+		size_t need = RecordSize(len);
+		uint64_t pos = s->head.load(std::memory_order_relaxed);
+		size_t index;
+		uint64_t total;
+		do
+		{
+			index = static_cast<size_t>(pos % m_ringSize);
+			size_t tail_room = static_cast<size_t>(m_ringSize - index);
+			total = tail_room < need ? tail_room + need : need;
+			if (need > m_ringSize || pos + total - s->tail.load(std::memory_order_acquire) > m_ringSize)
+			{
+				s->dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+		} while (!s->head.compare_exchange_weak(pos, pos + total, std::memory_order_relaxed));
+
+		char* ring = getRing(slot);
+		if (total != need)
+		{
+			reinterpret_cast<LogShmRecord*>(ring + index)->state.store(kWrap, std::memory_order_release);
+			index = 0;
+		}
+		LogShmRecord* record = reinterpret_cast<LogShmRecord*>(ring + index);
+		record->length = static_cast<uint32_t>(len);
+		record->time = time;
+		memcpy(ring + index + sizeof(LogShmRecord), data, len);
+		//数据复制完成后再提交
+		record->state.store(kRecord, std::memory_order_release);
+		return true;
+	}
+
+	uint64_t LogShmChannel::getOwner(uint32_t slot) const
+	{
+		return getSlot(slot)->owner.load(std::memory_order_relaxed);
+	}
+
+	uint64_t LogShmChannel::getDroppedCount(uint32_t slot) const
+	{
+		return getSlot(slot)->dropped.load(std::memory_order_relaxed);
+	}
+
+	uint64_t LogShmChannel::getPendingBytes(uint32_t slot) const
+	{
+		LogShmSlot* s = getSlot(slot);
+		uint64_t tail = s->tail.load(std::memory_order_acquire);
+		return s->head.load(std::memory_order_relaxed) - tail;
+	}
+
+	LogShmCollector::ptr LogShmCollector::Open(const std::string& name, LogFileWriter::ptr writer, uint32_t delay,
+		uint32_t slot_count, uint64_t ring_size)
+	{
+		LogShmChannel::ptr channel = LogShmChannel::Open(name, slot_count, ring_size);
+		if (!channel)
+		{
+			return nullptr;
+		}
+		//接替已退出的收集进程
+		uint64_t pid = GetProcessID();
+		uint64_t current = channel->m_header->collector.load(std::memory_order_acquire);
+		if (current && IsProcessAlive(current))
+		{
+			std::cout << "LogShmCollector open name=" << name << " failed: collected by process " << current << std::endl;
+			return nullptr;
+		}
+		if (!channel->m_header->collector.compare_exchange_strong(current, pid, std::memory_order_acq_rel))
+		{
+			return nullptr;
+		}
+		return ptr(new LogShmCollector(std::move(channel), std::move(writer), delay));
+	}
+
+	LogShmCollector::LogShmCollector(LogShmChannel::ptr channel, LogFileWriter::ptr writer, uint32_t delay)
+		: m_channel(std::move(channel))
+		, m_writer(std::move(writer))
+		, m_delay(delay)
+		, m_lastTime(m_channel->getSlotCount(), 0)
+	{
+	}
+
+	LogShmCollector::~LogShmCollector()
+	{
+		poll(true);
+		uint64_t pid = GetProcessID();
+		m_channel->m_header->collector.compare_exchange_strong(pid, 0, std::memory_order_release);
+	}
+
+	bool LogShmCollector::drain(uint32_t slot)
+	{
+		LogShmSlot* s = m_channel->getSlot(slot);
+		char* ring = m_channel->getRing(slot);
+		uint64_t ring_size = m_channel->getRingSize();
+		uint64_t end = s->head.load(std::memory_order_acquire);
+		uint64_t pos = s->tail.load(std::memory_order_relaxed);
+		uint64_t& last_time = m_lastTime[slot];
+		while (pos < end)
+		{
+			size_t index = static_cast<size_t>(pos % ring_size);
+			LogShmRecord* record = reinterpret_cast<LogShmRecord*>(ring + index);
+			uint32_t state = record->state.load(std::memory_order_acquire);
+			if (state == 0)
+			{
+				break;
+			}
+			//清零已取出的空间，之后的记录头落在这里时为未提交
+			size_t size;
+			if (state == kWrap)
+			{
+				size = static_cast<size_t>(ring_size - index);
+			}
+			else
+			{
+				//时钟重新校准时时间戳可能略微回退，排序时间不小于同一槽的上一条，保持进程内的先后
+				last_time = std::max(last_time, record->time);
+				m_pending.push_back({ last_time, m_data.size(), record->length });
+				m_data.append(reinterpret_cast<const char*>(record + 1), record->length);
+				size = RecordSize(record->length);
+			}
+			memset(ring + index, 0, size);
+			pos += size;
+		}
+		s->tail.store(pos, std::memory_order_release);
+		return pos == end;
+	}
+
+	size_t LogShmCollector::poll(bool all)
+	{
+		//在取出之前确定写出的截止时间，取出过程中新写入的日志都晚于它
+		uint64_t watermark = all ? UINT64_MAX : GetCurrentTimeNS() - m_delay * 1000000ULL;
+		for (uint32_t i = 0; i < m_channel->getSlotCount(); ++i)
+		{
+			LogShmSlot* s = m_channel->getSlot(i);
+			//先确认进程已退出再取出，取出时它提交的日志都已可见
+			uint64_t owner = s->owner.load(std::memory_order_acquire);
+			bool dead = owner && !IsProcessAlive(owner);
+			if (!drain(i) && dead)
+			{
+				//崩溃时写到一半的记录永远不会提交，丢弃之后的全部数据
+				uint64_t head = s->head.load(std::memory_order_acquire);
+				m_lostBytes += head - s->tail.load(std::memory_order_relaxed);
+				memset(m_channel->getRing(i), 0, static_cast<size_t>(m_channel->getRingSize()));
+				s->tail.store(head, std::memory_order_release);
+			}
+			if (dead)
+			{
+				s->owner.compare_exchange_strong(owner, 0, std::memory_order_release);
+			}
+		}
+
+		//稳定排序保持同一时间的先后
+		std::stable_sort(m_pending.begin(), m_pending.end(), [](const Pending& a, const Pending& b) {
+			return a.time < b.time;
+		});
+		size_t n = 0;
+		for (; n < m_pending.size() && m_pending[n].time <= watermark; ++n)
+		{
+			m_writer->write(m_data.data() + m_pending[n].offset, m_pending[n].length, false);
+		}
+		if (n)
+		{
+			//每次只调用一次系统写入
+			m_writer->flush();
+			m_written += n;
+		}
+
+		//保留未写出的日志
+		m_retained.clear();
+		for (size_t i = n; i < m_pending.size(); ++i)
+		{
+			size_t offset = m_retained.size();
+			m_retained.append(m_data, m_pending[i].offset, m_pending[i].length);
+			m_pending[i].offset = offset;
+		}
+		m_pending.erase(m_pending.begin(), m_pending.begin() + n);
+		m_data.swap(m_retained);
+		return n;
+	}
+
+	uint64_t LogShmCollector::getDroppedCount() const
+	{
+		uint64_t dropped = 0;
+		for (uint32_t i = 0; i < m_channel->getSlotCount(); ++i)
+		{
+			dropped += m_channel->getDroppedCount(i);
+		}
+		return dropped;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "LogSite.h"
+#include <mutex>
+
+namespace GameProjectServer
+{
+	//超出容量的调用点使用的id，落在计数块的最后一块
+	static constexpr uint32_t kLogSiteOverflowId = kLogSiteChunkSize * kLogSiteMaxChunks;
+
+	//注册表预留的调用点数
+	static constexpr uint32_t kLogSiteReserve = kLogSiteChunkSize * 16;
+
+	//注册表中保存的调用点，file为字符串字面量
+	struct LogSiteInfo
+	{
+		const char* file;
+		int line;
+		int level;
+	};
+
+	//已退出线程留下的计数
+	struct LogSiteTotals
+	{
+		uint64_t emitted = 0;
+		uint64_t suppressed = 0;
+		uint64_t bytes = 0;
+	};
+
+	//故意不释放，进程退出时线程局部对象仍可能访问
+	struct LogSiteRegistry
+	{
+		LogSiteRegistry()
+		{
+			//所有分块都指向同一块丢弃的计数
+			static LogSiteCounters s_discard_chunk[kLogSiteChunkSize];
+			for (auto& i : discard.chunks)
+			{
+				i.store(s_discard_chunk, std::memory_order_relaxed);
+			}
+			//预留常见数量的调用点，注册时一般不再分配
+			sites.reserve(kLogSiteReserve);
+			totals.reserve(kLogSiteReserve);
+		}
+
+		std::mutex mutex;
+		std::vector<LogSiteInfo> sites;
+		std::vector<LogSiteTotals> totals;              //与sites一一对应
+		std::vector<LogSiteThreadCounters*> threads;    //存活线程的计数块
+		LogSiteThreadCounters discard;                  //已退出线程使用的计数块
+	};
+
+	static LogSiteRegistry& GetLogSiteRegistry()
+	{
+		static LogSiteRegistry* s_registry = new LogSiteRegistry;
+		return *s_registry;
+	}
+
+	/***************************************************
+		线程退出时把计数并入汇总后释放计数块，
+		并把引用它的线程局部指针改为指向丢弃的计数块，
+		各模块有自己的线程局部指针时都会被记录
+	***************************************************/
+	struct LogSiteThreadHolder
+	{
+		LogSiteThreadCounters* counters = nullptr;
+		std::vector<LogSiteThreadCounters**> slots;
+		bool alive = true;
+
+		~LogSiteThreadHolder()
+		{
+			alive = false;
+			LogSiteRegistry& registry = GetLogSiteRegistry();
+			for (auto* slot : slots)
+			{
+				*slot = &registry.discard;
+			}
+			if (!counters)
+			{
+				return;
+			}
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			for (size_t i = 0; i < registry.threads.size(); ++i)
+			{
+				if (registry.threads[i] == counters)
+				{
+					registry.threads[i] = registry.threads.back();
+					registry.threads.pop_back();
+					break;
+				}
+			}
+			for (uint32_t c = 0; c <= kLogSiteMaxChunks; ++c)
+			{
+				LogSiteCounters* chunk = counters->chunks[c].load(std::memory_order_relaxed);
+				if (!chunk)
+				{
+					continue;
+				}
+				for (uint32_t i = 0; i < kLogSiteChunkSize && c * kLogSiteChunkSize + i < registry.totals.size(); ++i)
+				{
+					LogSiteTotals& t = registry.totals[c * kLogSiteChunkSize + i];
+					t.emitted += chunk[i].emitted.load(std::memory_order_relaxed);
+					t.suppressed += chunk[i].suppressed.load(std::memory_order_relaxed);
+					t.bytes += chunk[i].bytes.load(std::memory_order_relaxed);
+				}
+				delete[] chunk;
+			}
+			delete counters;
+			counters = nullptr;
+		}
+	};
+
+	static thread_local LogSiteThreadHolder t_log_site_holder;
+
+	LogSite::LogSite(const char* file, int line, int level)
+		: m_file(file)
+		, m_line(line)
+		, m_level(level)
+	{
+		LogSiteRegistry& registry = GetLogSiteRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		if (registry.sites.size() >= kLogSiteOverflowId)
+		{
+			m_id = kLogSiteOverflowId;
+			return;
+		}
+		m_id = static_cast<uint32_t>(registry.sites.size());
+		registry.sites.push_back({ file, line, level });
+		registry.totals.emplace_back();
+	}
+
+	LogSiteCounters& LogSiteAttach(uint32_t id, LogSiteThreadCounters*& counters)
+	{
+		LogSiteRegistry& registry = GetLogSiteRegistry();
+		if (!counters)
+		{
+			if (!t_log_site_holder.alive)
+			{
+				counters = &registry.discard;
+			}
+			else
+			{
+				if (!t_log_site_holder.counters)
+				{
+					t_log_site_holder.counters = new LogSiteThreadCounters;
+					std::lock_guard<std::mutex> lock(registry.mutex);
+					registry.threads.push_back(t_log_site_holder.counters);
+				}
+				counters = t_log_site_holder.counters;
+				t_log_site_holder.slots.push_back(&counters);
+			}
+		}
+		uint32_t c = id / kLogSiteChunkSize;
+		LogSiteCounters* chunk = counters->chunks[c].load(std::memory_order_relaxed);
+		if (!chunk)
+		{
+			chunk = new LogSiteCounters[kLogSiteChunkSize];
+			counters->chunks[c].store(chunk, std::memory_order_release);
+		}
+		return chunk[id % kLogSiteChunkSize];
+	}
+
+	std::vector<LogSiteStats> LogSiteCollect()
+	{
+		LogSiteRegistry& registry = GetLogSiteRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		std::vector<LogSiteStats> stats(registry.sites.size());
+		for (size_t i = 0; i < stats.size(); ++i)
+		{
+			stats[i].file = registry.sites[i].file;
+			stats[i].line = registry.sites[i].line;
+			stats[i].level = registry.sites[i].level;
+			stats[i].emitted = registry.totals[i].emitted;
+			stats[i].suppressed = registry.totals[i].suppressed;
+			stats[i].bytes = registry.totals[i].bytes;
+		}
+		for (auto* counters : registry.threads)
+		{
+			for (uint32_t c = 0; c < kLogSiteMaxChunks && c * kLogSiteChunkSize < stats.size(); ++c)
+			{
+				LogSiteCounters* chunk = counters->chunks[c].load(std::memory_order_acquire);
+				if (!chunk)
+				{
+					continue;
+				}
+				for (uint32_t i = 0; i < kLogSiteChunkSize && c * kLogSiteChunkSize + i < stats.size(); ++i)
+				{
+					LogSiteStats& s = stats[c * kLogSiteChunkSize + i];
+					s.emitted += chunk[i].emitted.load(std::memory_order_relaxed);
+					s.suppressed += chunk[i].suppressed.load(std::memory_order_relaxed);
+					s.bytes += chunk[i].bytes.load(std::memory_order_relaxed);
+				}
+			}
+		}
+		return stats;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,883 @@
+#include "LogWriter.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <new>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <zlib.h>
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+
+namespace GameProjectServer
+{
+	static uint64_t GetSteadyMS()
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/***************************************************
+		按刷新间隔检查各写入器的后台线程，所有写入器共用一个
+		对象故意不释放，线程分离运行，
+		避免进程退出时在静态析构中等待线程
+	***************************************************/
+	class LogFlushTimer
+	{
+	public:
+		static LogFlushTimer& GetInstance()
+		{
+			static LogFlushTimer* s_timer = new LogFlushTimer;
+			return *s_timer;
+		}
+
+		void add(const std::weak_ptr<LogFileWriter>& writer, uint32_t interval)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_writers.push_back(writer);
+			//检查周期取最小刷新间隔的1/4，数据最多停留约1.25倍间隔
+			uint32_t tick = interval / 4 < 10 ? 10 : interval / 4;
+			if (tick < m_tick)
+			{
+				m_tick = tick;
+			}
+			if (!m_started)
+			{
+				m_started = true;
+				std::thread(&LogFlushTimer::run, this).detach();
+			}
+			m_cond.notify_one();
+		}
+	private:
+		void run()
+		{
+			//持有锁检查，写入器的锁在其内部获取，不会反向等待本锁
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (true)
+			{
+				m_cond.wait_for(lock, std::chrono::milliseconds(m_tick));
+				uint64_t now = GetSteadyMS();
+				//顺带移除已销毁的写入器
+				size_t n = 0;
+				for (size_t i = 0; i < m_writers.size(); ++i)
+				{
+					if (auto writer = m_writers[i].lock())
+					{
+						writer->flushIfExpired(now);
+						m_writers[n++] = m_writers[i];
+					}
+				}
+				m_writers.resize(n);
+			}
+		}
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_cond;
+		std::vector<std::weak_ptr<LogFileWriter>> m_writers;
+		uint32_t m_tick = 1000;         //检查周期(毫秒)
+		bool m_started = false;
+	};
+
+	/***************************************************
+		按文件长度与时间点轮转写入器的后台线程，所有写入器共用一个
+		写入线程发现文件超长时只唤醒本线程，改名、新建文件与
+		预分配都在本线程中完成；与LogFlushTimer一样不释放
+	***************************************************/
+	class LogRotateThread
+	{
+	public:
+		static LogRotateThread& GetInstance()
+		{
+			static LogRotateThread* s_thread = new LogRotateThread;
+			return *s_thread;
+		}
+
+		void add(const std::weak_ptr<LogFileWriter>& writer)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_writers.push_back(writer);
+			if (!m_started)
+			{
+				m_started = true;
+				std::thread(&LogRotateThread::run, this).detach();
+			}
+			m_cond.notify_one();
+		}
+
+		//写入线程调用，不加锁；错过的唤醒由定时检查兜底
+		void wakeup()
+		{
+			m_cond.notify_one();
+		}
+	private:
+		void run()
+		{
+			std::vector<LogFileWriter::ptr> writers;
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (true)
+			{
+				m_cond.wait_for(lock, std::chrono::milliseconds(kTick));
+				size_t n = 0;
+				for (size_t i = 0; i < m_writers.size(); ++i)
+				{
+					if (auto writer = m_writers[i].lock())
+					{
+						writers.push_back(std::move(writer));
+						m_writers[n++] = m_writers[i];
+					}
+				}
+				m_writers.resize(n);
+				//轮转涉及文件操作，不持有锁，注册新写入器不必等待
+				lock.unlock();
+				uint64_t now = static_cast<uint64_t>(time(nullptr));
+				for (auto& i : writers)
+				{
+					i->rotateIfNeeded(now);
+				}
+				writers.clear();
+				lock.lock();
+			}
+		}
+	private:
+		static constexpr uint32_t kTick = 100;  //检查周期(毫秒)
+
+		std::mutex m_mutex;
+		std::condition_variable m_cond;
+		std::vector<std::weak_ptr<LogFileWriter>> m_writers;
+		bool m_started = false;
+	};
+
+	static int OpenLogFile(const std::string& filename, bool append)
+	{
+#ifdef _WIN32
+		//允许在文件打开期间改名，轮转时不必先关闭
+		HANDLE handle = CreateFileA(filename.c_str(), GENERIC_WRITE,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+			append ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle == INVALID_HANDLE_VALUE)
+		{
+			return -1;
+		}
+		int fd = _open_osfhandle(reinterpret_cast<intptr_t>(handle), append ? _O_APPEND : 0);
+		if (fd < 0)
+		{
+			CloseHandle(handle);
+		}
+		return fd;
+#else
+		return ::open(filename.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+#endif
+	}
+
+	static void CloseLogFile(int fd)
+	{
+#ifdef _WIN32
+		_close(fd);
+#else
+		::close(fd);
+#endif
+	}
+
+	static uint64_t GetLogFileLength(int fd)
+	{
+#ifdef _WIN32
+		__int64 len = _filelengthi64(fd);
+		return len > 0 ? static_cast<uint64_t>(len) : 0;
+#else
+		struct stat st;
+		return fstat(fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+#endif
+	}
+
+	static bool LogFileExists(const std::string& filename)
+	{
+#ifdef _WIN32
+		return _access(filename.c_str(), 0) == 0;
+#else
+		return access(filename.c_str(), F_OK) == 0;
+#endif
+	}
+
+	//预先分配磁盘空间，不改变文件长度，追加写入仍从文件末尾开始
+	static void PreallocateLogFile(int fd, uint64_t bytes)
+	{
+#ifdef _WIN32
+		FILE_ALLOCATION_INFO info;
+		info.AllocationSize.QuadPart = static_cast<LONGLONG>(bytes);
+		SetFileInformationByHandle(reinterpret_cast<HANDLE>(_get_osfhandle(fd)),
+			FileAllocationInfo, &info, sizeof(info));
+#elif defined(__linux__)
+		fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes));
+#else
+		(void)fd;
+		(void)bytes;
+#endif
+	}
+
+	/***************************************************
+		file.N-1改名为file.N，...，file改名为file.1，
+		max_files为0时顺延到第一个不存在的编号，
+		否则先删除超出保留数的file.max_files
+	***************************************************/
+	static void ShiftLogFiles(const std::string& filename, uint32_t max_files)
+	{
+		auto name = [&filename](uint32_t index) {
+			return filename + "." + std::to_string(index);
+		};
+		uint32_t last = max_files;
+		if (last == 0)
+		{
+			last = 1;
+			while (LogFileExists(name(last)))
+			{
+				++last;
+			}
+		}
+		else
+		{
+			std::remove(name(last).c_str());
+		}
+		for (uint32_t i = last; i > 1; --i)
+		{
+			std::rename(name(i - 1).c_str(), name(i).c_str());
+		}
+		std::rename(filename.c_str(), name(1).c_str());
+	}
+
+	//本地时间当天零点起interval秒整数倍的下一个时间点
+	static uint64_t NextRotateTime(uint64_t now, uint32_t interval)
+	{
+		time_t t = static_cast<time_t>(now);
+		tm local;
+		localtime_s(&local, &t);
+		uint64_t seconds = local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+		return now - seconds % interval + interval;
+	}
+
+	LogFileWriter::LogFileWriter(size_t buffer_size)
+		: m_buffer(new char[buffer_size ? buffer_size : kDefaultBufferSize])
+		, m_capacity(buffer_size ? buffer_size : kDefaultBufferSize)
+		, m_flushBytes(m_capacity)
+	{
+	}
+
+	LogFileWriter::~LogFileWriter()
+	{
+		close();
+	}
+
+	bool LogFileWriter::open(const std::string& filename, bool append)
+	{
+		close();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		int fd = OpenLogFile(filename, append);
+		if (fd < 0)
+		{
+			return false;
+		}
+		m_filename = filename;
+		m_fd = fd;
+		m_owned = true;
+		m_fileSize.store(append ? GetLogFileLength(fd) : 0, std::memory_order_relaxed);
+		m_rotatePending = false;
+		return true;
+	}
+
+	void LogFileWriter::attach(int fd)
+	{
+		close();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_fd = fd;
+		m_owned = false;
+	}
+
+	void LogFileWriter::close()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_fd < 0)
+		{
+			return;
+		}
+		writeLocked(nullptr, 0);
+		if (m_owned)
+		{
+			CloseLogFile(m_fd);
+		}
+		m_fd = -1;
+		m_owned = false;
+	}
+
+	void LogFileWriter::write(const char* data, size_t len, bool flush)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_fd < 0)
+		{
+			return;
+		}
+		uint64_t file_size = m_fileSize.load(std::memory_order_relaxed) + len;
+		m_fileSize.store(file_size, std::memory_order_relaxed);
+		if (m_rotate.size && file_size >= m_rotate.size && !m_rotatePending && m_owned)
+		{
+			//只请求，改名与新建文件由轮转线程完成
+			m_rotatePending = true;
+			LogRotateThread::GetInstance().wakeup();
+		}
+		if (m_size + len > m_capacity)
+		{
+			//放不下时与缓冲区内容一起写出
+			writeLocked(data, len);
+			return;
+		}
+		if (m_size == 0 && m_flushInterval)
+		{
+			m_pendingSince = GetSteadyMS();
+		}
+		memcpy(m_buffer.get() + m_size, data, len);
+		m_size += len;
+		if (flush || m_size >= m_flushBytes)
+		{
+			writeLocked(nullptr, 0);
+		}
+	}
+
+	void LogFileWriter::flush()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_fd >= 0)
+		{
+			writeLocked(nullptr, 0);
+		}
+	}
+
+	bool LogFileWriter::tryWrite(const char* data, size_t len)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+		if (!lock.owns_lock() || m_fd < 0)
+		{
+			return false;
+		}
+		m_fileSize.store(m_fileSize.load(std::memory_order_relaxed) + len, std::memory_order_relaxed);
+		writeLocked(data, len);
+		return true;
+	}
+
+	void LogFileWriter::setFlushBytes(size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_flushBytes = bytes && bytes < m_capacity ? bytes : m_capacity;
+	}
+
+	void LogFileWriter::setFlushInterval(uint32_t interval)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_flushInterval = interval;
+			if (!interval || m_registered)
+			{
+				return;
+			}
+			m_registered = true;
+		}
+		LogFlushTimer::GetInstance().add(weak_from_this(), interval);
+	}
+
+	void LogFileWriter::setRotatePolicy(const LogRotatePolicy& policy)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_rotate = policy;
+			m_nextRotate = policy.interval ? NextRotateTime(static_cast<uint64_t>(time(nullptr)), policy.interval) : 0;
+			if (!policy.enabled() || m_rotateRegistered)
+			{
+				return;
+			}
+			m_rotateRegistered = true;
+		}
+		LogRotateThread::GetInstance().add(weak_from_this());
+	}
+
+	LogRotatePolicy LogFileWriter::getRotatePolicy() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_rotate;
+	}
+
+	uint64_t LogFileWriter::rotateIfNeeded(uint64_t now)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_fd < 0 || !m_owned || !m_rotate.enabled())
+			{
+				return 0;
+			}
+			if (!m_rotatePending && !(m_nextRotate && now >= m_nextRotate))
+			{
+				return m_nextRotate;
+			}
+		}
+		rotate();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_nextRotate;
+	}
+
+	void LogFileWriter::rotate()
+	{
+		std::string filename;
+		LogRotatePolicy policy;
+		int old_fd;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			filename = m_filename;
+			policy = m_rotate;
+			old_fd = m_fd;
+		}
+		//改名期间写入线程继续写原文件，数据落在改名后的file.1中
+		ShiftLogFiles(filename, policy.max_files);
+		int fd = OpenLogFile(filename, true);
+		if (fd >= 0 && policy.preallocate)
+		{
+			PreallocateLogFile(fd, policy.preallocate);
+		}
+		int close_fd = fd;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_rotatePending = false;
+			m_nextRotate = policy.interval ? NextRotateTime(static_cast<uint64_t>(time(nullptr)), policy.interval) : 0;
+			m_fileSize.store(0, std::memory_order_relaxed);
+			//新建失败时继续写原文件，再写满一个size后重试；期间被重新open则放弃
+			if (fd >= 0 && m_fd == old_fd)
+			{
+				//缓冲的数据属于原文件，先写出再切换
+				writeLocked(nullptr, 0);
+				m_fd = fd;
+				close_fd = old_fd;
+				m_rotateCount.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		if (close_fd >= 0)
+		{
+			CloseLogFile(close_fd);
+		}
+	}
+
+	void LogFileWriter::flushIfExpired(uint64_t now_ms)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_fd >= 0 && m_size && m_flushInterval && now_ms - m_pendingSince >= m_flushInterval)
+		{
+			writeLocked(nullptr, 0);
+		}
+	}
+
+	void LogFileWriter::writeLocked(const char* data, size_t len)
+	{
+		const char* parts[2] = { m_buffer.get(), data };
+		size_t sizes[2] = { m_size, len };
+		m_size = 0;
+		if (sizes[0] + sizes[1] == 0)
+		{
+			return;
+		}
+#ifdef _WIN32
+		//Windows没有writev，逐段写出
+		for (int i = 0; i < 2; ++i)
+		{
+			const char* p = parts[i];
+			size_t left = sizes[i];
+			while (left)
+			{
+				unsigned int n = left > 0x40000000 ? 0x40000000 : static_cast<unsigned int>(left);
+				int ret = _write(m_fd, p, n);
+				m_writeCalls.fetch_add(1, std::memory_order_relaxed);
+				if (ret <= 0)
+				{
+					return;
+				}
+				p += ret;
+				left -= ret;
+				m_writtenBytes.fetch_add(ret, std::memory_order_relaxed);
+			}
+		}
+#else
+		iovec iov[2];
+		int count = 0;
+		for (int i = 0; i < 2; ++i)
+		{
+			if (sizes[i])
+			{
+				iov[count].iov_base = const_cast<char*>(parts[i]);
+				iov[count].iov_len = sizes[i];
+				++count;
+			}
+		}
+		iovec* cur = iov;
+		while (count)
+		{
+			ssize_t ret = ::writev(m_fd, cur, count);
+			m_writeCalls.fetch_add(1, std::memory_order_relaxed);
+			if (ret < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return;
+			}
+			m_writtenBytes.fetch_add(ret, std::memory_order_relaxed);
+			//部分写入时跳过已写出的部分继续
+			size_t done = static_cast<size_t>(ret);
+			while (count && done >= cur->iov_len)
+			{
+				done -= cur->iov_len;
+				++cur;
+				--count;
+			}
+			if (count)
+			{
+				cur->iov_base = static_cast<char*>(cur->iov_base) + done;
+				cur->iov_len -= done;
+			}
+		}
+#endif
+	}
+
+	LogGzipWriter::ptr LogGzipWriter::Create(LogFileWriter::ptr target, const LogCompressPolicy& policy)
+	{
+		LogCompressPolicy p = policy;
+		p.enabled = true;
+		p.level = p.level < 0 ? 0 : p.level > 9 ? 9 : p.level;
+		if (!p.block_size)
+		{
+			p.block_size = LogCompressPolicy::kDefaultBlockSize;
+		}
+		//压缩结果的长度用32位表示
+		if (p.block_size > (1u << 30))
+		{
+			p.block_size = 1u << 30;
+		}
+		z_stream* stream = new z_stream();
+		//窗口位数加16输出gzip格式的头与尾
+		if (deflateInit2(stream, p.level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		{
+			delete stream;
+			return nullptr;
+		}
+		return ptr(new LogGzipWriter(std::move(target), p, stream));
+	}
+
+	LogGzipWriter::LogGzipWriter(LogFileWriter::ptr target, const LogCompressPolicy& policy, z_stream_s* stream)
+		: m_target(std::move(target))
+		, m_policy(policy)
+		, m_stream(stream)
+		, m_current(new Block)
+	{
+		m_current->reserve(m_policy.block_size);
+		m_thread = std::thread(&LogGzipWriter::run, this);
+	}
+
+	LogGzipWriter::~LogGzipWriter()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (!m_current->empty())
+			{
+				seal(lock);
+			}
+			m_running = false;
+			m_cond.notify_one();
+		}
+		m_thread.join();
+		deflateEnd(m_stream);
+		delete m_stream;
+		m_target->flush();
+	}
+
+	void LogGzipWriter::write(const char* data, size_t len, bool flush)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_current->empty())
+		{
+			m_currentSince = GetSteadyMS();
+		}
+		m_current->append(data, len);
+		if (flush || m_current->size() >= m_policy.block_size)
+		{
+			seal(lock);
+		}
+	}
+
+	void LogGzipWriter::flush()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (!m_current->empty())
+			{
+				seal(lock);
+			}
+			uint64_t sealed = m_sealed;
+			m_doneCond.wait(lock, [this, sealed]() { return m_written >= sealed; });
+		}
+		m_target->flush();
+	}
+
+	void LogGzipWriter::setFlushInterval(uint32_t interval)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_flushInterval = interval;
+		m_cond.notify_one();
+	}
+
+	void LogGzipWriter::seal(std::unique_lock<std::mutex>& lock)
+	{
+		//压缩跟不上时等待，不丢弃日志
+		m_doneCond.wait(lock, [this]() { return m_blocks.size() < kMaxPendingBlocks; });
+		//等待期间可能已被其他线程封块
+		if (m_current->empty())
+		{
+			return;
+		}
+		m_blocks.push_back(std::move(m_current));
+		if (m_free.empty())
+		{
+			m_current.reset(new Block);
+			m_current->reserve(m_policy.block_size);
+		}
+		else
+		{
+			m_current = std::move(m_free.back());
+			m_free.pop_back();
+		}
+		++m_sealed;
+		m_cond.notify_one();
+	}
+
+	void LogGzipWriter::run()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true)
+		{
+			if (m_blocks.empty())
+			{
+				if (!m_running)
+				{
+					break;
+				}
+				if (!m_flushInterval)
+				{
+					m_cond.wait(lock);
+					continue;
+				}
+				//写入线程不通知本线程，按刷新间隔检查当前块
+				uint64_t now = GetSteadyMS();
+				if (!m_current->empty() && now - m_currentSince >= m_flushInterval)
+				{
+					seal(lock);
+					continue;
+				}
+				uint64_t wait = m_current->empty() ? m_flushInterval : m_currentSince + m_flushInterval - now;
+				m_cond.wait_for(lock, std::chrono::milliseconds(wait));
+				continue;
+			}
+			BlockPtr block = std::move(m_blocks.front());
+			m_blocks.erase(m_blocks.begin());
+			lock.unlock();
+			compress(*block);
+			lock.lock();
+			block->clear();
+			m_free.push_back(std::move(block));
+			++m_written;
+			m_doneCond.notify_all();
+		}
+	}
+
+	void LogGzipWriter::compress(const Block& block)
+	{
+		//每块重新开始一个gzip成员，块之间不共享字典，可以单独解压
+		deflateReset(m_stream);
+		size_t bound = deflateBound(m_stream, static_cast<uLong>(block.size())) + 64;
+		if (m_out.size() < bound)
+		{
+			m_out.resize(bound);
+		}
+		m_stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(block.data()));
+		m_stream->avail_in = static_cast<uInt>(block.size());
+		m_stream->next_out = reinterpret_cast<Bytef*>(&m_out[0]);
+		m_stream->avail_out = static_cast<uInt>(m_out.size());
+		if (deflate(m_stream, Z_FINISH) != Z_STREAM_END)
+		{
+			//输出空间按deflateBound分配，不会发生
+			return;
+		}
+		size_t len = m_out.size() - m_stream->avail_out;
+		//整个成员一次写出，轮转不会把一个成员拆到两个文件中
+		m_target->write(m_out.data(), len, true);
+		m_blockCount.fetch_add(1, std::memory_order_relaxed);
+		m_rawBytes.fetch_add(block.size(), std::memory_order_relaxed);
+		m_compressedBytes.fetch_add(len, std::memory_order_relaxed);
+	}
+
+	//段文件头，位于文件开头，之后是日志数据
+	struct LogMmapHeader
+	{
+		char magic[8];                      //LogMmapSegment::kMagic
+		uint64_t size;                      //文件大小(含文件头)
+		uint64_t index;                     //段序号
+		std::atomic<uint64_t> committed;    //已提交的数据字节数
+	};
+	static_assert(sizeof(LogMmapHeader) <= LogMmapSegment::kHeaderSize, "mmap log header too large");
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "mmap log header needs a lock-free 64-bit atomic");
+
+	LogMmapSegment::ptr LogMmapSegment::Create(const std::string& filename, uint64_t size, uint64_t index)
+	{
+		if (size < kHeaderSize + 4096)
+		{
+			size = kHeaderSize + 4096;
+		}
+		ptr segment(new LogMmapSegment);
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE,
+			FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return nullptr;
+		}
+		//创建映射时文件被扩展到size
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+			static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+		void* base = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(size)) : nullptr;
+		int fd = base ? _open_osfhandle(reinterpret_cast<intptr_t>(file), 0) : -1;
+		if (fd < 0)
+		{
+			if (base)
+			{
+				UnmapViewOfFile(base);
+			}
+			if (mapping)
+			{
+				CloseHandle(mapping);
+			}
+			CloseHandle(file);
+			return nullptr;
+		}
+		segment->m_mapping = mapping;
+#else
+		int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0)
+		{
+			return nullptr;
+		}
+#ifdef __linux__
+		//实际分配磁盘空间，避免写入映射时因磁盘满收到SIGBUS
+		bool sized = posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0;
+#else
+		bool sized = ftruncate(fd, static_cast<off_t>(size)) == 0;
+#endif
+		void* base = sized ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+		if (base == MAP_FAILED)
+		{
+			::close(fd);
+			return nullptr;
+		}
+#endif
+		segment->m_fd = fd;
+		segment->m_base = static_cast<char*>(base);
+		segment->m_size = size;
+		segment->m_index = index;
+		LogMmapHeader* header = new (base) LogMmapHeader;
+		header->size = size;
+		header->index = index;
+		header->committed.store(0, std::memory_order_relaxed);
+		//最后写入魔数，创建到一半崩溃的文件不会被当作合法的段
+		memcpy(header->magic, kMagic, sizeof(kMagic));
+		segment->m_header = header;
+		return segment;
+	}
+
+	bool LogMmapSegment::Read(const std::string& filename, std::string& data)
+	{
+		std::ifstream in(filename, std::ios_base::in | std::ios_base::binary);
+		char buf[kHeaderSize];
+		if (!in.read(buf, kHeaderSize) || memcmp(buf, kMagic, sizeof(kMagic)) != 0)
+		{
+			return false;
+		}
+		uint64_t size = 0;
+		uint64_t committed = 0;
+		memcpy(&size, buf + offsetof(LogMmapHeader, size), sizeof(size));
+		memcpy(&committed, buf + offsetof(LogMmapHeader, committed), sizeof(committed));
+		if (size < kHeaderSize || committed > size - kHeaderSize)
+		{
+			return false;
+		}
+		data.resize(committed);
+		return committed == 0 || (in.read(&data[0], committed) && static_cast<uint64_t>(in.gcount()) == committed);
+	}
+
+	LogMmapSegment::~LogMmapSegment()
+	{
+		if (!m_base)
+		{
+			return;
+		}
+		uint64_t length = kHeaderSize + getCommitted();
+#ifdef _WIN32
+		UnmapViewOfFile(m_base);
+		CloseHandle(static_cast<HANDLE>(m_mapping));
+		HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(m_fd));
+		LARGE_INTEGER pos;
+		pos.QuadPart = static_cast<LONGLONG>(length);
+		if (SetFilePointerEx(file, pos, nullptr, FILE_BEGIN))
+		{
+			SetEndOfFile(file);
+		}
+		_close(m_fd);
+#else
+		munmap(m_base, m_size);
+		//正常关闭时去掉未使用的预分配空间
+		int ret = ftruncate(m_fd, static_cast<off_t>(length));
+		(void)ret;
+		::close(m_fd);
+#endif
+	}
+
+	bool LogMmapSegment::append(const char* data, size_t len)
+	{
+		uint64_t committed = m_header->committed.load(std::memory_order_relaxed);
+		if (len > getCapacity() - committed)
+		{
+			return false;
+		}
+		memcpy(m_base + kHeaderSize + committed, data, len);
+		//数据复制完成后再推进提交偏移
+		m_header->committed.store(committed + len, std::memory_order_release);
+		return true;
+	}
+
+	void LogMmapSegment::sync()
+	{
+#ifdef _WIN32
+		FlushViewOfFile(m_base, 0);
+#else
+		msync(m_base, m_size, MS_ASYNC);
+#endif
+	}
+
+	uint64_t LogMmapSegment::getCommitted() const
+	{
+		return m_header->committed.load(std::memory_order_acquire);
+	}
+}
\ No newline at end of file
@@ -1,5 +1,18 @@
 #include "Util.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <windows.h>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define NST_HAVE_RDTSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+#endif
+
 namespace GameProjectServer
 {
 	uint32_t GetThreadId()
@@ -15,4 +28,196 @@ namespace GameProjectServer
 		return 0;
 #endif
 	}
+
+	/***************************************************
+		基于TSC的日志时钟
+		首次使用时记录(TSC, 单调时间)基线，基线满1ms之前
+		直接读取std::chrono，之后以基线估计频率并锚定
+		(TSC, 系统时间, 单调时间)，读时钟只需一次rdtsc加一次乘法；
+		定期以系统时钟重新锚定并修正频率，新锚点不早于
+		按旧锚点推算的运行时间，进程运行时间不回退；
+		系统时间每次锚定都对齐系统时钟，可能有微秒级的回退；
+		锚点用序号锁保护，读者不加锁
+		不支持恒定频率TSC的平台退回std::chrono
+	***************************************************/
+	class TscClock
+	{
+	public:
+		static TscClock& GetInstance()
+		{
+			static TscClock s_clock;
+			return s_clock;
+		}
+
+		void now(uint64_t& time_ns, uint64_t& elapse_ns)
+		{
+			if (!m_calibrated.load(std::memory_order_acquire))
+			{
+				uint64_t steady = SteadyNS();
+				time_ns = SystemNS();
+				elapse_ns = steady - m_baseSteady;
+				//基线满1ms后由首个读者完成校准，不在启动时等待
+				if (m_useTsc && elapse_ns >= kCalibrateNS)
+				{
+					recalibrate();
+				}
+				return;
+			}
+			uint64_t tsc = ReadTsc();
+			uint32_t seq;
+			uint64_t anchor_tsc, anchor_wall, anchor_mono;
+			double ns_per_tick;
+			do
+			{
+				seq = m_seq.load(std::memory_order_acquire);
+				anchor_tsc = m_anchorTsc.load(std::memory_order_relaxed);
+				anchor_wall = m_anchorWall.load(std::memory_order_relaxed);
+				anchor_mono = m_anchorMono.load(std::memory_order_relaxed);
+				ns_per_tick = m_nsPerTick.load(std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_acquire);
+			} while ((seq & 1) || seq != m_seq.load(std::memory_order_relaxed));
+
+			uint64_t ticks = tsc > anchor_tsc ? tsc - anchor_tsc : 0;
+			if (ticks > m_recalibrateTicks.load(std::memory_order_relaxed) && recalibrate())
+			{
+				now(time_ns, elapse_ns);
+				return;
+			}
+			uint64_t delta = static_cast<uint64_t>(ticks * ns_per_tick);
+			time_ns = anchor_wall + delta;
+			elapse_ns = anchor_mono + delta;
+		}
+	private:
+		TscClock()
+		{
+			m_baseSteady = SteadyNS();
+#ifdef NST_HAVE_RDTSC
+			m_useTsc = HasInvariantTsc();
+#endif
+			m_baseTsc = ReadTsc();
+			//锚定间隔从10ms开始倍增到1s，基线越来越长，频率误差很快收敛
+			m_recalibrateNS = 10000000;
+		}
+
+		//返回false表示其他线程正在重新锚定
+		bool recalibrate()
+		{
+			if (m_updating.exchange(true, std::memory_order_acquire))
+			{
+				return false;
+			}
+			uint64_t steady = SteadyNS();
+			uint64_t tsc = ReadTsc();
+			uint64_t wall = SystemNS();
+			double ns_per_tick = static_cast<double>(steady - m_baseSteady) / (tsc - m_baseTsc);
+			uint64_t mono = steady - m_baseSteady;
+			bool calibrated = m_calibrated.load(std::memory_order_relaxed);
+			if (calibrated)
+			{
+				//按旧锚点推算到本次锚定时刻，读者此前拿到的运行时间都不超过它
+				uint64_t old_tsc = m_anchorTsc.load(std::memory_order_relaxed);
+				uint64_t delta = static_cast<uint64_t>((tsc > old_tsc ? tsc - old_tsc : 0)
+					* m_nsPerTick.load(std::memory_order_relaxed));
+				mono = std::max(mono, m_anchorMono.load(std::memory_order_relaxed) + delta);
+			}
+
+			uint32_t seq = m_seq.load(std::memory_order_relaxed);
+			m_seq.store(seq + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			m_nsPerTick.store(ns_per_tick, std::memory_order_relaxed);
+			m_anchorTsc.store(tsc, std::memory_order_relaxed);
+			m_anchorWall.store(wall, std::memory_order_relaxed);
+			m_anchorMono.store(mono, std::memory_order_relaxed);
+			m_seq.store(seq + 2, std::memory_order_release);
+
+			if (calibrated && m_recalibrateNS < kMaxRecalibrateNS)
+			{
+				m_recalibrateNS *= 2;
+			}
+			m_recalibrateTicks.store(static_cast<uint64_t>(m_recalibrateNS / ns_per_tick), std::memory_order_relaxed);
+			m_calibrated.store(true, std::memory_order_release);
+			m_updating.store(false, std::memory_order_release);
+			return true;
+		}
+
+		static uint64_t SystemNS()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count();
+		}
+
+		static uint64_t SteadyNS()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		static uint64_t ReadTsc()
+		{
+#ifdef NST_HAVE_RDTSC
+			return __rdtsc();
+#else
+			return 0;
+#endif
+		}
+
+#ifdef NST_HAVE_RDTSC
+		//CPUID.80000007H:EDX[8] 恒定频率TSC
+		static bool HasInvariantTsc()
+		{
+			unsigned int regs[4] = { 0 };
+#ifdef _MSC_VER
+			__cpuid(reinterpret_cast<int*>(regs), 0x80000000);
+			if (regs[0] < 0x80000007)
+			{
+				return false;
+			}
+			__cpuid(reinterpret_cast<int*>(regs), 0x80000007);
+#else
+			if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+			{
+				return false;
+			}
+			__get_cpuid(0x80000007, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+			return (regs[3] & (1u << 8)) != 0;
+		}
+#endif
+	private:
+		static constexpr uint64_t kCalibrateNS = 1000000;           //首次估计频率的基线长度
+		static constexpr uint64_t kMaxRecalibrateNS = 1000000000;
+
+		bool m_useTsc = false;
+		uint64_t m_baseSteady = 0;                  //进程启动时的单调时间
+		uint64_t m_baseTsc = 0;                     //进程启动时的TSC
+		uint64_t m_recalibrateNS = 0;               //重新锚定的间隔，仅由锚定线程修改
+		std::atomic<uint64_t> m_recalibrateTicks{ UINT64_MAX };
+
+		std::atomic<uint32_t> m_seq{ 0 };           //锚点序号，奇数表示正在更新
+		std::atomic<uint64_t> m_anchorTsc{ 0 };
+		std::atomic<uint64_t> m_anchorWall{ 0 };    //锚点对应的系统时间
+		std::atomic<uint64_t> m_anchorMono{ 0 };    //锚点对应的进程运行时间
+		std::atomic<double> m_nsPerTick{ 0 };
+		std::atomic<bool> m_updating{ false };
+		std::atomic<bool> m_calibrated{ false };    //是否已锚定，之前直接读取std::chrono
+	};
+
+	uint64_t GetCurrentTimeNS()
+	{
+		uint64_t time_ns, elapse_ns;
+		TscClock::GetInstance().now(time_ns, elapse_ns);
+		return time_ns;
+	}
+
+	uint64_t GetElapseNS()
+	{
+		uint64_t time_ns, elapse_ns;
+		TscClock::GetInstance().now(time_ns, elapse_ns);
+		return elapse_ns;
+	}
+
+	void GetClockNS(uint64_t& time_ns, uint64_t& elapse_ns)
+	{
+		TscClock::GetInstance().now(time_ns, elapse_ns);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,124 @@
+// LogTestUtil.h: 日志测试共用的检查函数与appender
+#pragma once
+
+#include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+#include "Log.h"
+
+/***************************************************
+	每个测试都是独立的可执行文件，
+	Check记录失败项，main结束时s_failed不为0则返回1
+***************************************************/
+inline int s_failed = 0;
+
+inline void Check(bool ok, const std::string& what)
+{
+	if (!ok)
+	{
+		std::cout << "FAILED: " << what << std::endl;
+		++s_failed;
+	}
+}
+
+//只计数的appender，低于自身级别的日志不计数
+class CountLogAppender : public GameProjectServer::LogAppender
+{
+public:
+	using ptr = std::shared_ptr<CountLogAppender>;
+
+	void log(std::shared_ptr<GameProjectServer::Logger> logger, GameProjectServer::LogLevel::Level level,
+		GameProjectServer::LogEvent::ptr event) override
+	{
+		if (level >= m_level)
+		{
+			m_count.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	std::string toYamlString() override { return ""; }
+
+	uint64_t getCount() const { return m_count.load(std::memory_order_relaxed); }
+private:
+	std::atomic<uint64_t> m_count{ 0 };
+};
+
+//收集日志消息的appender，可由多个线程同时写入
+class CollectLogAppender : public GameProjectServer::LogAppender
+{
+public:
+	using ptr = std::shared_ptr<CollectLogAppender>;
+
+	void log(std::shared_ptr<GameProjectServer::Logger> logger, GameProjectServer::LogLevel::Level level,
+		GameProjectServer::LogEvent::ptr event) override
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_lines.push_back(event->getMessage());
+	}
+	std::string toYamlString() override { return ""; }
+
+	//取出已收集的消息
+	std::vector<std::string> take()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return std::move(m_lines);
+	}
+private:
+	std::mutex m_mutex;
+	std::vector<std::string> m_lines;
+};
+
+//什么都不输出的appender
+class NullLogAppender : public GameProjectServer::LogAppender
+{
+public:
+	void log(std::shared_ptr<GameProjectServer::Logger> logger, GameProjectServer::LogLevel::Level level,
+		GameProjectServer::LogEvent::ptr event) override {}
+	std::string toYamlString() override { return ""; }
+};
+
+/***************************************************
+	统计内存分配次数：包含本文件前定义
+	NILESTHUMP_TEST_COUNT_ALLOC时替换全局operator new，
+	s_counting为true期间的每次分配计入s_alloc_count；
+	替换只能出现一次，每个可执行文件只在一个源文件中定义
+***************************************************/
+#ifdef NILESTHUMP_TEST_COUNT_ALLOC
+static std::atomic<uint64_t> s_alloc_count{ 0 };
+static bool s_counting = false;
+
+void* operator new(size_t size)
+{
+	if (s_counting)
+	{
+		s_alloc_count.fetch_add(1, std::memory_order_relaxed);
+	}
+	if (void* p = std::malloc(size ? size : 1))
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+//内存由上面的operator new经malloc分配，GCC看不出配对，按new/free误报
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+#endif
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include "Util.h"
+#include "Log.h"
+
+/***************************************************
+	日志时钟读取开销与精度
+	GetClockNS应在20ns以内，且与系统时钟的偏差
+	应保持在微秒级，重新锚定时进程运行时间不回退
+***************************************************/
+int main(int argc, char** argv)
+{
+	using namespace GameProjectServer;
+	const int count = argc > 1 ? atoi(argv[1]) : 10000000;
+
+	uint64_t time_ns = 0, elapse_ns = 0, total = 0;
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		GetClockNS(time_ns, elapse_ns);
+		total += time_ns;
+	}
+	auto end = std::chrono::steady_clock::now();
+	std::cout << "GetClockNS:                " <<
+		std::chrono::duration<double, std::nano>(end - begin).count() / count << " ns/read" << std::endl;
+
+	begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		total += std::chrono::system_clock::now().time_since_epoch().count();
+	}
+	end = std::chrono::steady_clock::now();
+	std::cout << "std::chrono::system_clock: " <<
+		std::chrono::duration<double, std::nano>(end - begin).count() / count << " ns/read" << std::endl;
+
+	//跨越多次重新锚定，进程运行时间不回退
+	uint64_t last_elapse = 0;
+	uint64_t step_backs = 0;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+	while (std::chrono::steady_clock::now() < deadline)
+	{
+		GetClockNS(time_ns, elapse_ns);
+		step_backs += elapse_ns < last_elapse;
+		last_elapse = elapse_ns;
+	}
+	std::cout << "elapse step backs:         " << step_backs << std::endl;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+		GetClockNS(time_ns, elapse_ns);
+		int64_t sys = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+		std::cout << "uptime=" << elapse_ns / 1000000 << "ms drift=" << (sys - (int64_t)time_ns) << "ns" << std::endl;
+	}
+
+	Logger::ptr logger = std::make_shared<Logger>("bench_clock");
+	logger->addAppender(std::make_shared<StdoutLogAppender>());
+	logger->setFormatter("%d{%H:%M:%S.%6N}%T%N%T%R%T%r%T%m%n");
+	NILESTHUMP_LOG_INFO(logger) << "checksum " << total;
+	return step_backs ? 1 : 0;
+}
\ No newline at end of file
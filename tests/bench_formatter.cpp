@@ -0,0 +1,134 @@
+#include <iostream>
+#include <chrono>
+#include <ctime>
+#include <sstream>
+#include <vector>
+#include "Util.h"
+#include "Log.h"
+
+/***************************************************
+	对比LogFormatter编译指令+LogBuffer的格式化路径
+	与原先stringstream+虚函数FormatItem的格式化路径，
+	旧路径在此处按原实现还原，仅用于基准对比
+***************************************************/
+namespace legacy
+{
+	using namespace GameProjectServer;
+
+	class FormatItem {
+	public:
+		using ptr = std::shared_ptr<FormatItem>;
+		virtual ~FormatItem() {}
+		virtual void format(std::ostream& os, std::shared_ptr<Logger> logger,
+			LogLevel::Level level, LogEvent::ptr event) = 0;
+	};
+
+#define XX(Name, expr) \
+	class Name : public FormatItem { \
+	public: \
+		void format(std::ostream& os, std::shared_ptr<Logger> logger, \
+			LogLevel::Level level, LogEvent::ptr event) override { os << expr; } \
+	};
+	XX(MessageItem, event->getMessage())
+	XX(LevelItem, LogLevel::ToString(level))
+	XX(NameItem, event->getLogger()->getName())
+	XX(ThreadIdItem, event->getThreadId())
+	XX(FiberIdItem, event->getFiberId())
+	XX(FilenameItem, event->getFile())
+	XX(LineItem, event->getLine())
+	XX(TabItem, "\t")
+	XX(NewLineItem, std::endl)
+#undef XX
+
+	class StringItem : public FormatItem {
+	public:
+		StringItem(const std::string& str) : m_string(str) {}
+		void format(std::ostream& os, std::shared_ptr<Logger> logger,
+			LogLevel::Level level, LogEvent::ptr event) override { os << m_string; }
+	private:
+		std::string m_string;
+	};
+
+	class DateTimeItem : public FormatItem {
+	public:
+		DateTimeItem(const std::string& format) : m_format(format) {}
+		void format(std::ostream& os, std::shared_ptr<Logger> logger,
+			LogLevel::Level level, LogEvent::ptr event) override {
+			tm tm_time;
+			time_t t = event->getTime() / 1000000000;
+			localtime_s(&tm_time, &t);
+			char buf[64];
+			strftime(buf, sizeof(buf), m_format.c_str(), &tm_time);
+			os << buf;
+		}
+	private:
+		std::string m_format;
+	};
+
+	//%d{%H:%M:%S %Y-%m-%d}%T%t%T%F%T[%p]%T[%c]%T<%f:%l>%T%m%n
+	static std::vector<FormatItem::ptr> DefaultItems()
+	{
+		return {
+			std::make_shared<DateTimeItem>("%H:%M:%S %Y-%m-%d"), std::make_shared<TabItem>(),
+			std::make_shared<ThreadIdItem>(), std::make_shared<TabItem>(),
+			std::make_shared<FiberIdItem>(), std::make_shared<TabItem>(),
+			std::make_shared<StringItem>("["), std::make_shared<LevelItem>(), std::make_shared<StringItem>("]"),
+			std::make_shared<TabItem>(),
+			std::make_shared<StringItem>("["), std::make_shared<NameItem>(), std::make_shared<StringItem>("]"),
+			std::make_shared<TabItem>(),
+			std::make_shared<StringItem>("<"), std::make_shared<FilenameItem>(), std::make_shared<StringItem>(":"),
+			std::make_shared<LineItem>(), std::make_shared<StringItem>(">"),
+			std::make_shared<TabItem>(), std::make_shared<MessageItem>(), std::make_shared<NewLineItem>()
+		};
+	}
+
+	static std::string Format(std::vector<FormatItem::ptr>& items, std::shared_ptr<Logger> logger,
+		LogLevel::Level level, LogEvent::ptr event)
+	{
+		std::stringstream ss;
+		for (auto& item : items)
+		{
+			item->format(ss, logger, level, event);
+		}
+		return ss.str();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	using namespace GameProjectServer;
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+
+	Logger::ptr logger = std::make_shared<Logger>("bench_logger");
+	LogEvent::ptr event(new LogEvent(logger, LogLevel::INFO, __FILE__, __LINE__, 0,
+		GetThreadId(), GetFiberId(), GetCurrentTimeNS()));
+	event->getSS() << "player 10086 entered scene 42";
+
+	size_t total = 0;
+	std::vector<legacy::FormatItem::ptr> items = legacy::DefaultItems();
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		total += legacy::Format(items, logger, LogLevel::INFO, event).size();
+	}
+	auto end = std::chrono::steady_clock::now();
+	double legacy_ns = std::chrono::duration<double, std::nano>(end - begin).count() / count;
+
+	LogFormatter::ptr formatter = logger->getFormatter();
+	LogBuffer buf;
+	begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		buf.clear();
+		formatter->format(buf, LogLevel::INFO, *event);
+		total += buf.size();
+	}
+	end = std::chrono::steady_clock::now();
+	double compiled_ns = std::chrono::duration<double, std::nano>(end - begin).count() / count;
+
+	std::cout << "pattern: " << formatter->getPattern() << std::endl;
+	std::cout << "stringstream + FormatItem: " << legacy_ns << " ns/event" << std::endl;
+	std::cout << "compiled + LogBuffer:      " << compiled_ns << " ns/event" << std::endl;
+	std::cout << "checksum: " << total << std::endl;
+	return 0;
+}
@@ -0,0 +1,48 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include "Util.h"
+#include "Log.h"
+
+/***************************************************
+	一个日志器挂1/3/5个FileLogAppender时每条日志的耗时：
+	共用日志器格式器时每个事件只格式化一次，
+	各appender使用各自的格式器(格式相同)时每个appender各格式化一次
+***************************************************/
+using namespace GameProjectServer;
+
+static double Run(int appenders, bool shared, int count)
+{
+	Logger::ptr logger = std::make_shared<Logger>("fanout_logger");
+	for (int i = 0; i < appenders; ++i)
+	{
+		FileLogAppender::ptr appender = std::make_shared<FileLogAppender>(
+			"bench_log_fanout_" + std::to_string(i) + ".txt");
+		if (!shared)
+		{
+			appender->setFormatter(std::make_shared<LogFormatter>(LogFormatter::kDefaultPattern));
+		}
+		logger->addAppender(appender);
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		NILESTHUMP_LOG_PRINT_INFO(logger, "player {} entered scene {}", 10086, i);
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - begin).count() / count;
+}
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 500000;
+	for (int n : { 1, 3, 5 })
+	{
+		double separate = Run(n, false, count);
+		double shared = Run(n, true, count);
+		std::cout << n << " appenders: separate formatters " << separate
+			<< " ns/event, shared formatter " << shared << " ns/event" << std::endl;
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include "Util.h"
+#include "Log.h"
+
+/***************************************************
+	对比消息格式化的三种方式：
+	原先LogEvent::format的两次vsnprintf + new[] + 复制，
+	现在的NILESTHUMP_LOG_FMT_ERROR单次vsnprintf，
+	以及NILESTHUMP_LOG_PRINT_ERROR的{}风格格式化
+	日志器没有appender，只统计事件与消息格式化的开销
+***************************************************/
+static void LegacyFormat(GameProjectServer::LogEvent& event, const char* fmt, ...)
+{
+	va_list al;
+	va_start(al, fmt);
+	va_list args;
+	va_copy(args, al);
+	int len = vsnprintf(nullptr, 0, fmt, args);
+	va_end(args);
+	if (len >= 0)
+	{
+		char* buf = new char[len + 1];
+		len = vsnprintf(buf, len + 1, fmt, al);
+		event.getSS() << std::string(buf, len);
+		delete[] buf;
+	}
+	va_end(al);
+}
+
+int main(int argc, char** argv)
+{
+	using namespace GameProjectServer;
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	Logger::ptr logger = std::make_shared<Logger>("bench_logger");
+
+	int player = 10086;
+	double hp = 97.5;
+	const char* scene = "dungeon";
+
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		if (logger->getLevel() <= LogLevel::ERROR)
+		{
+			LogEventWrap wrap(LogEvent::Acquire(logger, LogLevel::ERROR, __FILE__, __LINE__,
+				GetThreadId(), GetFiberId()));
+			LegacyFormat(*wrap.getEvent(), "player %d hp %f scene %s frame %d", player, hp, scene, i);
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	std::cout << "double vsnprintf (old FMT):  " <<
+		std::chrono::duration<double, std::nano>(end - begin).count() / count << " ns/event" << std::endl;
+
+	begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		NILESTHUMP_LOG_FMT_ERROR(logger, "player %d hp %f scene %s frame %d", player, hp, scene, i);
+	}
+	end = std::chrono::steady_clock::now();
+	std::cout << "NILESTHUMP_LOG_FMT_ERROR:    " <<
+		std::chrono::duration<double, std::nano>(end - begin).count() / count << " ns/event" << std::endl;
+
+	begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		NILESTHUMP_LOG_PRINT_ERROR(logger, "player {} hp {} scene {} frame {}", player, hp, scene, i);
+	}
+	end = std::chrono::steady_clock::now();
+	std::cout << "NILESTHUMP_LOG_PRINT_ERROR:  " <<
+		std::chrono::duration<double, std::nano>(end - begin).count() / count << " ns/event" << std::endl;
+
+	logger->addAppender(std::make_shared<StdoutLogAppender>());
+	NILESTHUMP_LOG_FMT_ERROR(logger, "player %d hp %f scene %s frame %d", player, hp, scene, 1);
+	NILESTHUMP_LOG_PRINT_ERROR(logger, "player {} hp {} scene {} frame {} {{escaped}}", player, hp, scene, 1);
+	return 0;
+}
\ No newline at end of file
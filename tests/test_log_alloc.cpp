@@ -0,0 +1,49 @@
+#include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include "Util.h"
+#include "Log.h"
+#define NILESTHUMP_TEST_COUNT_ALLOC
+#include "LogTestUtil.h"
+
+/***************************************************
+	统计日志热路径上的内存分配次数
+	预热之后，同步输出的
+	NILESTHUMP_LOG_INFO(logger) << "x" << 42;
+	不应再调用malloc
+***************************************************/
+
+//预热与计数使用同一个调用点，首次执行时的注册不计入
+static void LogOnce(const GameProjectServer::Logger::ptr& logger)
+{
+	NILESTHUMP_LOG_INFO(logger) << "x" << 42;
+}
+
+int main(int argc, char** argv)
+{
+	GameProjectServer::Logger::ptr logger = std::make_shared<GameProjectServer::Logger>("alloc_logger");
+	logger->addAppender(std::make_shared<GameProjectServer::FileLogAppender>("test_log_alloc.txt"));
+
+	for (int i = 0; i < 100; ++i)
+	{
+		LogOnce(logger);
+	}
+
+	const int count = 100000;
+	s_counting = true;
+	for (int i = 0; i < count; ++i)
+	{
+		LogOnce(logger);
+	}
+	s_counting = false;
+
+	uint64_t allocs = s_alloc_count.load();
+	std::cout << "allocations in " << count << " log statements: " << allocs << std::endl;
+	if (allocs != 0)
+	{
+		std::cout << "FAILED: steady state log statement allocates" << std::endl;
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	二进制日志：写出后用BinaryLogDecoder还原，
+	检查文本与直接{}格式化的结果一致，
+	并对比调用线程上二进制日志与文本日志的耗时
+***************************************************/
+
+int main(int argc, char** argv)
+{
+	using namespace GameProjectServer;
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	const char* filename = "test_log_binary.bin";
+
+	{
+		Logger::ptr logger = std::make_shared<Logger>("binary_logger");
+		logger->addAppender(std::make_shared<BinaryLogAppender>(filename));
+
+		std::string scene = "dungeon";
+		NILESTHUMP_LOG_BIN_INFO(logger, "player {} hp {} scene {}", 10086, 97.5, scene);
+		NILESTHUMP_LOG_BIN_WARN(logger, "flag {} char {} u {} f {} {{}}", true, 'x', 42u, 0.25f);
+		NILESTHUMP_LOG_BIN_ERROR(logger, "null {} neg {}", static_cast<const char*>(nullptr), -7);
+		NILESTHUMP_LOG_INFO(logger) << "text event " << 1;
+	}
+
+	std::ifstream in(filename, std::ios_base::in | std::ios_base::binary);
+	std::stringstream out;
+	BinaryLogDecoder decoder(std::make_shared<LogFormatter>("%p [%c] %m%n"));
+	Check(decoder.decode(in, out), "decode: " + decoder.getError());
+	Check(decoder.getCount() == 4, "decoded event count");
+	std::string expected =
+		"INFO [binary_logger] player 10086 hp 97.5 scene dungeon\n"
+		"WARN [binary_logger] flag true char x u 42 f 0.25 {}\n"
+		"ERROR [binary_logger] null (null) neg -7\n"
+		"INFO [binary_logger] text event 1\n";
+	Check(out.str() == expected, "decoded text:\n" + out.str());
+
+	//损坏的调用点/日志器id被拒绝，不按其分配内存
+	for (char type : { static_cast<char>(LogBinaryRecord::SITE), static_cast<char>(LogBinaryRecord::LOGGER) })
+	{
+		std::string data(kLogBinaryMagic, sizeof(kLogBinaryMagic));
+		data += type;
+		data.append(4, '\xff');
+		data.append(32, '\0');
+		std::istringstream bad(data);
+		std::stringstream bad_out;
+		BinaryLogDecoder bad_decoder(std::make_shared<LogFormatter>("%m%n"));
+		Check(!bad_decoder.decode(bad, bad_out) && bad_decoder.getError().find("bad") == 0,
+			"bad id rejected: " + bad_decoder.getError());
+	}
+
+	//调用线程耗时
+	Logger::ptr logger = std::make_shared<Logger>("bench_logger");
+	BinaryLogAppender::ptr appender = std::make_shared<BinaryLogAppender>("bench_log_binary.bin");
+	logger->addAppender(appender);
+	int player = 10086;
+	double hp = 97.5;
+	const char* scene = "dungeon";
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		NILESTHUMP_LOG_BIN_INFO(logger, "player {} hp {} scene {} frame {}", player, hp, scene, i);
+	}
+	auto end = std::chrono::steady_clock::now();
+	std::cout << "binary:          " << std::chrono::duration<double, std::nano>(end - begin).count() / count
+		<< " ns/event" << std::endl;
+
+	Logger::ptr text_logger = std::make_shared<Logger>("bench_logger");
+	text_logger->addAppender(std::make_shared<AsyncLogAppender>("bench_log_text.txt"));
+	begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		NILESTHUMP_LOG_PRINT_INFO(text_logger, "player {} hp {} scene {} frame {}", player, hp, scene, i);
+	}
+	end = std::chrono::steady_clock::now();
+	std::cout << "text (async):    " << std::chrono::duration<double, std::nano>(end - begin).count() / count
+		<< " ns/event" << std::endl;
+	std::cout << "binary dropped bytes: " << appender->getDroppedBytes() << std::endl;
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
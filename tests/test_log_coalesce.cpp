@@ -0,0 +1,119 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	重复日志合并：同一调用点连续相同的消息只写出一条，
+	之后写出重复次数；不同调用点或不同消息不合并，
+	重复持续时按间隔写出计数；并比较日志风暴时的写入量与耗时
+***************************************************/
+using namespace GameProjectServer;
+
+static std::vector<std::string> ReadLines(const std::string& file)
+{
+	std::vector<std::string> lines;
+	std::ifstream in(file);
+	std::string line;
+	while (std::getline(in, line))
+	{
+		lines.push_back(line);
+	}
+	return lines;
+}
+
+static Logger::ptr MakeLogger(const std::string& file, uint32_t coalesce, FileLogAppender::ptr& appender)
+{
+	std::remove(file.c_str());
+	Logger::ptr logger = std::make_shared<Logger>("coalesce_logger");
+	appender = std::make_shared<FileLogAppender>(file);
+	appender->setFormatter(std::make_shared<LogFormatter>("%m%n"));
+	appender->setCoalesce(coalesce);
+	logger->addAppender(appender);
+	return logger;
+}
+
+static void Storm(Logger::ptr logger, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		NILESTHUMP_LOG_PRINT_ERROR(logger, "decode failed {}", 42);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+
+	//合并规则
+	{
+		const std::string file = "test_log_coalesce.txt";
+		FileLogAppender::ptr appender;
+		Logger::ptr logger = MakeLogger(file, LogRepeatFilter::kDefaultInterval, appender);
+		Storm(logger, 1000);
+		//其他调用点的相同消息
+		NILESTHUMP_LOG_PRINT_ERROR(logger, "decode failed {}", 42);
+		Storm(logger, 3);
+		//同一调用点的不同消息
+		for (int i = 0; i < 3; ++i)
+		{
+			NILESTHUMP_LOG_PRINT_ERROR(logger, "decode failed {}", i / 2);
+		}
+		Storm(logger, 2);
+		appender->flush();
+		std::vector<std::string> lines = ReadLines(file);
+		std::vector<std::string> expected = {
+			"decode failed 42", "last message repeated 999 times",
+			"decode failed 42",
+			"decode failed 42", "last message repeated 2 times",
+			"decode failed 0", "last message repeated 1 times", "decode failed 1",
+			"decode failed 42", "last message repeated 1 times" };
+		Check(lines == expected, "coalesced lines");
+		Check(appender->getCoalescedCount() == 1003, "coalesced count");
+		Check(appender->toYamlString().find("coalesce: true") != std::string::npos, "coalesce in yaml");
+	}
+
+	//重复持续时按间隔写出计数
+	{
+		const std::string file = "test_log_coalesce_interval.txt";
+		FileLogAppender::ptr appender;
+		Logger::ptr logger = MakeLogger(file, 50, appender);
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(230);
+		while (std::chrono::steady_clock::now() < deadline)
+		{
+			Storm(logger, 1);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		appender->flush();
+		std::vector<std::string> lines = ReadLines(file);
+		Check(lines.size() >= 4 && lines.size() <= 7, "repeat count written every interval");
+	}
+
+	//日志风暴
+	for (uint32_t coalesce : { 0u, LogRepeatFilter::kDefaultInterval })
+	{
+		const std::string file = "test_log_coalesce_storm.txt";
+		FileLogAppender::ptr appender;
+		Logger::ptr logger = MakeLogger(file, coalesce, appender);
+		auto begin = std::chrono::steady_clock::now();
+		Storm(logger, count);
+		auto end = std::chrono::steady_clock::now();
+		appender->flush();
+		std::cout << (coalesce ? "coalesced storm:  " : "plain storm:      ")
+			<< std::chrono::duration<double, std::nano>(end - begin).count() / count << " ns/event, "
+			<< appender->getWriter()->getFileSize() << " bytes" << std::endl;
+	}
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	按级别分发表：检查每个appender只收到其级别接受的日志，
+	appender加入后调低级别时仍能收到日志，
+	并统计5个appender中只有1个接受DEBUG时的分发耗时
+***************************************************/
+using namespace GameProjectServer;
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	Logger::ptr logger = std::make_shared<Logger>("dispatch_logger");
+	std::vector<CountLogAppender::ptr> appenders;
+	LogLevel::Level levels[] = { LogLevel::DEBUG, LogLevel::INFO, LogLevel::WARN, LogLevel::ERROR, LogLevel::FATAL };
+	for (auto level : levels)
+	{
+		CountLogAppender::ptr appender = std::make_shared<CountLogAppender>();
+		appender->setLevel(level);
+		logger->addAppender(appender);
+		appenders.push_back(appender);
+	}
+
+	NILESTHUMP_LOG_DEBUG(logger) << "debug";
+	NILESTHUMP_LOG_WARN(logger) << "warn";
+	NILESTHUMP_LOG_FATAL(logger) << "fatal";
+	uint64_t expected[] = { 3, 2, 2, 1, 1 };
+	for (size_t i = 0; i < appenders.size(); ++i)
+	{
+		Check(appenders[i]->getCount() == expected[i], "appender " + std::to_string(i) + " count");
+	}
+
+	//加入后调低级别
+	appenders[4]->setLevel(LogLevel::DEBUG);
+	NILESTHUMP_LOG_DEBUG(logger) << "debug";
+	Check(appenders[4]->getCount() == 2, "lowered appender level takes effect");
+	logger->setLevel(LogLevel::INFO);
+	NILESTHUMP_LOG_INFO(logger) << "info";
+	Check(appenders[4]->getCount() == 3 && appenders[1]->getCount() == 3, "rebuild after setLevel");
+	logger->setLevel(LogLevel::DEBUG);
+	appenders[4]->setLevel(LogLevel::FATAL);
+	logger->delAppender(appenders[4]);
+	logger->addAppender(appenders[4]);
+
+	//只有第一个appender接受DEBUG
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		NILESTHUMP_LOG_DEBUG(logger) << "debug";
+	}
+	auto end = std::chrono::steady_clock::now();
+	std::cout << "dispatch table:   " << std::chrono::duration<double, std::nano>(end - begin).count() / count
+		<< " ns/event" << std::endl;
+
+	//appender级别版本变化后，首次分发回退为遍历全部appender并重新发布快照
+	appenders[4]->setLevel(LogLevel::FATAL);
+	begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		NILESTHUMP_LOG_DEBUG(logger) << "debug";
+	}
+	end = std::chrono::steady_clock::now();
+	std::cout << "after level bump: " << std::chrono::duration<double, std::nano>(end - begin).count() / count
+		<< " ns/event" << std::endl;
+	Check(appenders[0]->getCount() == 5 + 2 * static_cast<uint64_t>(count), "debug appender total");
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
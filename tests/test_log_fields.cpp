@@ -0,0 +1,174 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+#include "Util.h"
+#include "Log.h"
+#define NILESTHUMP_TEST_COUNT_ALLOC
+#include "LogTestUtil.h"
+
+/***************************************************
+	结构化字段：kv按类型编码，%J输出合法的JSON对象，
+	%K/%k输出logfmt，字符串按各自规则转义；
+	预热后带字段的日志与JSON格式化不分配内存；
+	并比较手工拼接JSON与kv+%J的耗时
+***************************************************/
+using namespace GameProjectServer;
+
+//按格式器输出到内存，keep为false时只格式化不保存
+class CaptureLogAppender : public LogAppender
+{
+public:
+	using ptr = std::shared_ptr<CaptureLogAppender>;
+	void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override
+	{
+		const LogBuffer& line = formatter()->render(level, *event);
+		if (keep)
+		{
+			lines.push_back(line.toString());
+		}
+	}
+	std::string toYamlString() override { return ""; }
+
+	bool keep = true;
+	std::vector<std::string> lines;
+};
+
+struct Position
+{
+	int x;
+	int y;
+};
+
+static std::ostream& operator<<(std::ostream& os, const Position& p)
+{
+	return os << '(' << p.x << ',' << p.y << ')';
+}
+
+enum class Zone { EU = 3 };
+
+static std::string EscapeJson(const std::string& str)
+{
+	LogBuffer buf;
+	LogEscapeJson(buf, str.data(), str.size());
+	return buf.toString();
+}
+
+static std::string LogfmtValue(const std::string& str)
+{
+	LogBuffer buf;
+	LogAppendLogfmtValue(buf, str);
+	return buf.toString();
+}
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	Logger::ptr logger = std::make_shared<Logger>("fields \"logger\"");
+	CaptureLogAppender::ptr appender = std::make_shared<CaptureLogAppender>();
+	logger->addAppender(appender);
+
+	//转义
+	Check(EscapeJson("plain text that is long enough") == "plain text that is long enough", "json plain");
+	Check(EscapeJson(std::string("a\"b\\c\n\t\x01\x1f") + "\xe4\xbd\xa0") == "a\\\"b\\\\c\\n\\t\\u0001\\u001f\xe4\xbd\xa0",
+		"json escape");
+	Check(EscapeJson("0123456789abcdef\"0123456789abcdef") == "0123456789abcdef\\\"0123456789abcdef", "json escape mid word");
+	Check(LogfmtValue("abc") == "abc" && LogfmtValue("") == "\"\"" && LogfmtValue("a b") == "\"a b\""
+		&& LogfmtValue("k=v") == "\"k=v\"" && LogfmtValue("say \"hi\"\n") == "\"say \\\"hi\\\"\\n\"", "logfmt quoting");
+
+	//各类型字段的编码与JSON输出
+	appender->setFormatter(std::make_shared<LogFormatter>("%J{%Y-%m-%d %H:%M:%S.%3N}"));
+	const char* null_str = nullptr;
+	NILESTHUMP_LOG_KV_INFO(logger).kv("player_id", 42u).kv("delta", -7).kv("ratio", 0.5).kv("bad", NAN)
+		.kv("ok", true).kv("none", nullptr).kv("null_str", null_str).kv("zone", Zone::EU)
+		.kv("name", std::string("a\"b\n")).kv("pos", Position{ 1, -2 }).kv("c", 'x')
+		.getSS() << "login \t\"ok\"";
+	Check(appender->lines.size() == 1, "json line written");
+	if (appender->lines.size() == 1)
+	{
+		const std::string& json = appender->lines[0];
+		Check(json.find(",\"msg\":\"login \\t\\\"ok\\\"\",\"player_id\":42,\"delta\":-7,\"ratio\":0.5,\"bad\":\"nan\","
+			"\"ok\":true,\"none\":null,\"null_str\":null,\"zone\":3,\"name\":\"a\\\"b\\n\",\"pos\":\"(1,-2)\",\"c\":\"x\"}")
+			!= std::string::npos, "json fields");
+		YAML::Node node = YAML::Load(json);
+		Check(node.IsMap() && node["level"].as<std::string>() == "INFO"
+			&& node["logger"].as<std::string>() == "fields \"logger\""
+			&& node["msg"].as<std::string>() == "login \t\"ok\""
+			&& node["name"].as<std::string>() == "a\"b\n"
+			&& node["line"].as<int>() > 0 && node["time"].as<std::string>().size() == 23,
+			"json parses back");
+	}
+
+	//logfmt整行与附在文本格式后的字段
+	appender->lines.clear();
+	appender->setFormatter(std::make_shared<LogFormatter>("%K"));
+	NILESTHUMP_LOG_KV_WARN(logger).kv("player id", 7).kv("zone", "eu west").getSS() << "lag";
+	appender->setFormatter(std::make_shared<LogFormatter>("[%p] %m%k"));
+	NILESTHUMP_LOG_KV_WARN(logger).kv("k", "v").kv("empty", "").getSS() << "text";
+	//事件放回对象池后字段被清空
+	NILESTHUMP_LOG_WARN(logger) << "no fields";
+	Check(appender->lines.size() == 3, "logfmt lines written");
+	if (appender->lines.size() == 3)
+	{
+		const std::string& logfmt = appender->lines[0];
+		Check(logfmt.compare(0, 5, "time=") == 0
+			&& logfmt.find(" level=WARN logger=\"fields \\\"logger\\\"\" thread=") != std::string::npos
+			&& logfmt.find(" msg=lag player_id=7 zone=\"eu west\"") != std::string::npos
+			&& logfmt.back() == '"', "logfmt line");
+		Check(appender->lines[1] == "[WARN] text k=v empty=\"\"", "fields after text");
+		Check(appender->lines[2] == "[WARN] no fields", "pooled event fields cleared");
+	}
+
+	//稳定状态下不分配内存
+	appender->keep = false;
+	appender->setFormatter(std::make_shared<LogFormatter>("%J%n"));
+	const std::string zone = "eu-west-1";
+	auto kv_json = [&](int i) {
+		NILESTHUMP_LOG_KV_INFO(logger).kv("player_id", i).kv("zone", zone).kv("hp", 0.75).getSS() << "tick";
+	};
+	for (int i = 0; i < 100; ++i)
+	{
+		kv_json(i);
+	}
+	s_counting = true;
+	for (int i = 0; i < 10000; ++i)
+	{
+		kv_json(i);
+	}
+	s_counting = false;
+	Check(s_alloc_count.load() == 0, "structured log statement allocates");
+
+	auto measure = [&](const char* what, auto&& f) {
+		auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			f(i);
+		}
+		auto end = std::chrono::steady_clock::now();
+		std::cout << what << std::chrono::duration<double, std::nano>(end - begin).count() / count
+			<< " ns" << std::endl;
+	};
+	measure("kv + %J:          ", kv_json);
+	appender->setFormatter(std::make_shared<LogFormatter>("%m%n"));
+	measure("hand-built json:  ", [&](int i) {
+		NILESTHUMP_LOG_INFO(logger) << "{\"player_id\":" << i << ",\"zone\":\"" << zone
+			<< "\",\"hp\":" << 0.75 << ",\"msg\":\"tick\"}";
+	});
+	const std::string text(4096, 'x');
+	LogBuffer escaped;
+	measure("escape 4KB:       ", [&](int i) {
+		escaped.clear();
+		LogEscapeJson(escaped, text.data(), text.size());
+	});
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
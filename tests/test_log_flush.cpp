@@ -0,0 +1,120 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	统计不同刷新策略下写入文件的系统调用次数：
+	按字节数刷新时每个缓冲区只写一次，
+	按行刷新时每条日志写一次，
+	ERROR日志立即写出，按时间刷新时由后台线程写出
+	Linux上同时用/proc/self/io的syscw核对实际的系统调用数
+***************************************************/
+using namespace GameProjectServer;
+
+//当前进程发起的写系统调用总数，不支持时返回0
+static uint64_t GetProcessWriteCalls()
+{
+#ifdef __linux__
+	std::ifstream io("/proc/self/io");
+	std::string key;
+	uint64_t value = 0;
+	while (io >> key >> value)
+	{
+		if (key == "syscw:")
+		{
+			return value;
+		}
+	}
+#endif
+	return 0;
+}
+
+static FileLogAppender::ptr MakeLogger(Logger::ptr& logger, const char* file, const LogFlushPolicy& policy)
+{
+	logger = std::make_shared<Logger>("flush_logger");
+	FileLogAppender::ptr appender = std::make_shared<FileLogAppender>(file);
+	appender->setFlushPolicy(policy);
+	logger->addAppender(appender);
+	return appender;
+}
+
+int main(int argc, char** argv)
+{
+	const int count = 10000;
+	Logger::ptr logger;
+
+	//按缓冲区大小写出
+	{
+		LogFlushPolicy policy;
+		policy.interval = 0;
+		policy.level = LogLevel::UNKNOW;
+		FileLogAppender::ptr appender = MakeLogger(logger, "test_log_flush_bytes.txt", policy);
+		uint64_t syscw = GetProcessWriteCalls();
+		for (int i = 0; i < count; ++i)
+		{
+			NILESTHUMP_LOG_INFO(logger) << "player " << i << " moved to scene " << i % 64;
+		}
+		appender->flush();
+		syscw = GetProcessWriteCalls() - syscw;
+		uint64_t calls = appender->getWriter()->getWriteCalls();
+		uint64_t bytes = appender->getWriter()->getWrittenBytes();
+		uint64_t expected = bytes / LogFileWriter::kDefaultBufferSize + 1;
+		std::cout << "bytes policy: " << count << " lines, " << bytes << " bytes, "
+			<< calls << " write calls, syscw " << syscw << std::endl;
+		Check(calls <= expected, "bytes policy writes once per buffer");
+		Check(syscw == 0 || syscw <= expected, "bytes policy syscall count");
+	}
+
+	//每行写出
+	{
+		LogFlushPolicy policy;
+		policy.newline = true;
+		policy.interval = 0;
+		FileLogAppender::ptr appender = MakeLogger(logger, "test_log_flush_newline.txt", policy);
+		for (int i = 0; i < count; ++i)
+		{
+			NILESTHUMP_LOG_INFO(logger) << "player " << i;
+		}
+		uint64_t calls = appender->getWriter()->getWriteCalls();
+		std::cout << "newline policy: " << calls << " write calls" << std::endl;
+		Check(calls == static_cast<uint64_t>(count), "newline policy writes every line");
+	}
+
+	//ERROR立即写出
+	{
+		LogFlushPolicy policy;
+		policy.interval = 0;
+		FileLogAppender::ptr appender = MakeLogger(logger, "test_log_flush_level.txt", policy);
+		for (int i = 0; i < 100; ++i)
+		{
+			NILESTHUMP_LOG_INFO(logger) << "player " << i;
+		}
+		Check(appender->getWriter()->getWriteCalls() == 0, "info lines stay buffered");
+		NILESTHUMP_LOG_ERROR(logger) << "disconnect";
+		Check(appender->getWriter()->getWriteCalls() == 1, "error line flushes the buffer");
+	}
+
+	//按时间写出
+	{
+		LogFlushPolicy policy;
+		policy.interval = 50;
+		policy.level = LogLevel::UNKNOW;
+		FileLogAppender::ptr appender = MakeLogger(logger, "test_log_flush_interval.txt", policy);
+		NILESTHUMP_LOG_INFO(logger) << "idle line";
+		Check(appender->getWriter()->getWriteCalls() == 0, "interval policy buffers the line");
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		Check(appender->getWriter()->getWriteCalls() == 1, "interval policy flushes idle data");
+	}
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
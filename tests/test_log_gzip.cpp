@@ -0,0 +1,185 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	分块压缩的日志文件：整个文件可按gzip解压，
+	每块是独立的gzip成员，可从任一成员开始解压，
+	文件末尾被截断时之前的块完整保留；
+	停留超过刷新间隔的块由后台线程写出；
+	并比较压缩前后的写入量与耗时
+***************************************************/
+using namespace GameProjectServer;
+
+static std::string ReadFile(const std::string& file)
+{
+	std::ifstream in(file, std::ios::binary);
+	std::stringstream ss;
+	ss << in.rdbuf();
+	return ss.str();
+}
+
+//按gzip成员依次解压，遇到不完整的成员时停止，offsets为各成员的起始位置
+static std::string Gunzip(const std::string& data, std::vector<size_t>* offsets = nullptr)
+{
+	std::string out;
+	size_t pos = 0;
+	char buf[16384];
+	while (pos < data.size())
+	{
+		z_stream zs = {};
+		inflateInit2(&zs, 15 + 16);
+		zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + pos));
+		zs.avail_in = static_cast<uInt>(data.size() - pos);
+		std::string member;
+		int ret;
+		do
+		{
+			zs.next_out = reinterpret_cast<Bytef*>(buf);
+			zs.avail_out = sizeof(buf);
+			ret = inflate(&zs, Z_NO_FLUSH);
+			member.append(buf, sizeof(buf) - zs.avail_out);
+		} while (ret == Z_OK);
+		size_t used = data.size() - pos - zs.avail_in;
+		inflateEnd(&zs);
+		if (ret != Z_STREAM_END)
+		{
+			break;
+		}
+		if (offsets)
+		{
+			offsets->push_back(pos);
+		}
+		out += member;
+		pos += used;
+	}
+	return out;
+}
+
+static FileLogAppender::ptr MakeAppender(const std::string& file, size_t block_size, Logger::ptr& logger)
+{
+	std::remove(file.c_str());
+	LogCompressPolicy compress;
+	compress.enabled = block_size != 0;
+	compress.block_size = block_size;
+	FileLogAppender::ptr appender = std::make_shared<FileLogAppender>(file,
+		LogFileWriter::kDefaultBufferSize, compress);
+	appender->setFormatter(std::make_shared<LogFormatter>("%m%n"));
+	logger = std::make_shared<Logger>("gzip_logger");
+	logger->addAppender(appender);
+	return appender;
+}
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+
+	//整个文件可解压，内容与顺序不变，每块为独立的成员
+	{
+		const std::string file = "test_log_gzip.log.gz";
+		Logger::ptr logger;
+		FileLogAppender::ptr appender = MakeAppender(file, 4096, logger);
+		std::string expected;
+		for (int i = 0; i < 10000; ++i)
+		{
+			NILESTHUMP_LOG_PRINT_INFO(logger, "player {} moved to zone {}", i, i % 7);
+			expected += "player " + std::to_string(i) + " moved to zone " + std::to_string(i % 7) + "\n";
+		}
+		appender->flush();
+		const LogGzipWriter::ptr& gzip = appender->getGzipWriter();
+		Check(gzip && gzip->getRawBytes() == expected.size(), "all bytes compressed");
+		Check(gzip && gzip->getCompressedBytes() * 4 < gzip->getRawBytes(), "compression ratio");
+
+		std::string data = ReadFile(file);
+		std::vector<size_t> offsets;
+		Check(Gunzip(data, &offsets) == expected, "whole file decompresses");
+		Check(gzip && offsets.size() == gzip->getBlockCount() && offsets.size() > 10, "one member per block");
+
+		gzFile gz = gzopen(file.c_str(), "rb");
+		std::string via_zlib;
+		char buf[16384];
+		int n;
+		while (gz && (n = gzread(gz, buf, sizeof(buf))) > 0)
+		{
+			via_zlib.append(buf, n);
+		}
+		if (gz)
+		{
+			gzclose(gz);
+		}
+		Check(via_zlib == expected, "readable as a multi-member gzip file");
+
+		//从中间的成员开始解压
+		if (offsets.size() > 2)
+		{
+			std::string tail = Gunzip(data.substr(offsets[2]));
+			Check(!tail.empty() && expected.size() >= tail.size()
+				&& expected.compare(expected.size() - tail.size(), tail.size(), tail) == 0, "member decompresses alone");
+		}
+
+		//末尾的成员写了一半时，之前的块完整保留
+		if (offsets.size() > 1)
+		{
+			size_t cut = offsets.back() + (data.size() - offsets.back()) / 2;
+			std::string prefix = Gunzip(data.substr(0, cut));
+			Check(!prefix.empty() && prefix.back() == '\n' && expected.compare(0, prefix.size(), prefix) == 0
+				&& expected.size() - prefix.size() <= 4096 + 64, "truncated file keeps earlier blocks");
+		}
+
+		Check(appender->toYamlString().find("compress: true") != std::string::npos
+			&& appender->toYamlString().find("compress_block_size: 4096") != std::string::npos, "compress in yaml");
+	}
+
+	//按刷新间隔写出未满的块
+	{
+		const std::string file = "test_log_gzip_interval.log.gz";
+		Logger::ptr logger;
+		FileLogAppender::ptr appender = MakeAppender(file, LogCompressPolicy::kDefaultBlockSize, logger);
+		LogFlushPolicy policy;
+		policy.interval = 20;
+		appender->setFlushPolicy(policy);
+		NILESTHUMP_LOG_INFO(logger) << "idle";
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		Check(Gunzip(ReadFile(file)) == "idle\n", "partial block written after interval");
+		//不按间隔刷新时，达到刷新级别的日志立即封块
+		policy.interval = 0;
+		appender->setFlushPolicy(policy);
+		NILESTHUMP_LOG_ERROR(logger) << "boom";
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		Check(Gunzip(ReadFile(file)) == "idle\nboom\n", "error level seals block");
+	}
+
+	//写入量与耗时
+	for (size_t block_size : { size_t(0), LogCompressPolicy::kDefaultBlockSize })
+	{
+		const std::string file = "test_log_gzip_storm.log";
+		Logger::ptr logger;
+		FileLogAppender::ptr appender = MakeAppender(file, block_size, logger);
+		auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			NILESTHUMP_LOG_PRINT_INFO(logger, "player {} moved to zone {} hp {}", i, i % 7, 0.5);
+		}
+		appender->flush();
+		auto end = std::chrono::steady_clock::now();
+		std::cout << (block_size ? "gzip file:   " : "plain file:  ")
+			<< std::chrono::duration<double, std::nano>(end - begin).count() / count << " ns/event, "
+			<< appender->getWriter()->getFileSize() << " bytes" << std::endl;
+	}
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	日志文件的旁路索引：每块记录起始位置、时间范围与最高级别，
+	块边界在行首且首尾相接；按时间范围与级别查找时
+	选中的区间包含所有满足条件的行；没有索引的尾部总被选中；
+	追加打开时继续使用已有索引；并比较整文件扫描与按索引查找的耗时
+***************************************************/
+using namespace GameProjectServer;
+
+static std::string ReadFile(const std::string& file)
+{
+	std::ifstream in(file, std::ios::binary);
+	std::stringstream ss;
+	ss << in.rdbuf();
+	return ss.str();
+}
+
+static std::string ReadRanges(const std::string& file, const std::vector<LogIndexRange>& ranges)
+{
+	std::ifstream in(file, std::ios::binary);
+	std::string out;
+	for (auto& r : ranges)
+	{
+		std::string buf(r.end - r.begin, '\0');
+		in.seekg(static_cast<std::streamoff>(r.begin));
+		in.read(&buf[0], buf.size());
+		out += buf;
+	}
+	return out;
+}
+
+static uint64_t RangeBytes(const std::vector<LogIndexRange>& ranges)
+{
+	uint64_t bytes = 0;
+	for (auto& r : ranges)
+	{
+		bytes += r.end - r.begin;
+	}
+	return bytes;
+}
+
+static const uint64_t kBase = 1700000000ULL * 1000000000ULL;
+static const uint64_t kMS = 1000000ULL;
+
+//第i条日志的时间为kBase + i毫秒，每5000条有一条ERROR
+static void WriteEvents(const Logger::ptr& logger, int begin, int end)
+{
+	for (int i = begin; i < end; ++i)
+	{
+		LogLevel::Level level = i % 5000 == 4321 ? LogLevel::ERROR : LogLevel::INFO;
+		LogEvent::ptr event = std::make_shared<LogEvent>(logger, level, __FILE__, __LINE__, 0, 0, 0, kBase + i * kMS);
+		event->getSS() << "event " << i << " payload payload payload";
+		logger->log(level, event);
+	}
+}
+
+static Logger::ptr MakeLogger(const std::string& file, uint32_t index_interval, FileLogAppender::ptr& appender)
+{
+	Logger::ptr logger = std::make_shared<Logger>("index_logger");
+	appender = std::make_shared<FileLogAppender>(file, LogFileWriter::kDefaultBufferSize,
+		LogCompressPolicy(), index_interval);
+	appender->setFormatter(std::make_shared<LogFormatter>("%N [%p] %m%n"));
+	logger->addAppender(appender);
+	return logger;
+}
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	const std::string file = "test_log_index.txt";
+	std::remove(file.c_str());
+	std::remove(LogFileIndex::GetIndexName(file).c_str());
+
+	{
+		FileLogAppender::ptr appender;
+		Logger::ptr logger = MakeLogger(file, 4096, appender);
+		WriteEvents(logger, 0, 20000);
+		Check(appender->toYamlString().find("index_interval: 4096") != std::string::npos, "index in yaml");
+	}
+
+	std::string data = ReadFile(file);
+	std::vector<LogIndexEntry> entries;
+	Check(LogFileIndex::Load(LogFileIndex::GetIndexName(file), entries), "index loads");
+	Check(entries.size() > data.size() / 4200 && entries.size() <= data.size() / 4096 + 1, "one entry per interval");
+	bool contiguous = !entries.empty() && entries[0].offset == 0;
+	uint32_t lines = 0;
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		lines += entries[i].count;
+		uint64_t end = entries[i].offset + entries[i].length;
+		contiguous = contiguous && data[end - 1] == '\n' && entries[i].minTime <= entries[i].maxTime
+			&& (i + 1 == entries.size() ? end == data.size() : end == entries[i + 1].offset);
+	}
+	Check(contiguous && lines == 20000, "entries cover the file at line boundaries");
+
+	//时间范围
+	std::vector<LogIndexRange> ranges = LogFileIndex::Select(entries, data.size(),
+		kBase + 10000 * kMS, kBase + 10100 * kMS, 0);
+	std::string selected = ReadRanges(file, ranges);
+	bool all_found = true;
+	for (int i = 10000; i <= 10100; ++i)
+	{
+		all_found = all_found && selected.find("event " + std::to_string(i) + " ") != std::string::npos;
+	}
+	Check(all_found && RangeBytes(ranges) <= 3 * 4096 + 256, "time range selects few blocks");
+
+	//只看ERROR
+	ranges = LogFileIndex::Select(entries, data.size(), 0, UINT64_MAX, LogLevel::ERROR);
+	selected = ReadRanges(file, ranges);
+	Check(ranges.size() == 4 && selected.find("event 14321 ") != std::string::npos
+		&& selected.find("[ERROR]") != std::string::npos && RangeBytes(ranges) <= 4 * (4096 + 256), "error blocks selected");
+
+	//没有索引的尾部总被选中
+	{
+		std::ofstream out(file, std::ios::binary | std::ios::app);
+		out << "unindexed tail\n";
+	}
+	data = ReadFile(file);
+	ranges = LogFileIndex::Select(entries, data.size(), 0, 1, LogLevel::FATAL);
+	Check(ranges.size() == 1 && ReadRanges(file, ranges) == "unindexed tail\n", "unindexed tail selected");
+
+	//追加打开时继续写已有的索引
+	{
+		FileLogAppender::ptr appender;
+		Logger::ptr logger = MakeLogger(file, 4096, appender);
+		WriteEvents(logger, 20000, 30000);
+	}
+	std::vector<LogIndexEntry> appended;
+	LogFileIndex::Load(LogFileIndex::GetIndexName(file), appended);
+	Check(appended.size() > entries.size() && appended[entries.size()].offset == data.size(), "index appended");
+	ranges = LogFileIndex::Select(appended, ReadFile(file).size(), kBase + 25000 * kMS, kBase + 25000 * kMS, 0);
+	Check(ReadRanges(file, ranges).find("event 25000 ") != std::string::npos, "appended entries searchable");
+
+	//写入耗时与查找耗时
+	for (uint32_t interval : { 0u, LogFileIndex::kDefaultInterval })
+	{
+		const std::string big = "test_log_index_big.txt";
+		std::remove(big.c_str());
+		std::remove(LogFileIndex::GetIndexName(big).c_str());
+		auto begin = std::chrono::steady_clock::now();
+		{
+			FileLogAppender::ptr appender;
+			Logger::ptr logger = MakeLogger(big, interval, appender);
+			WriteEvents(logger, 0, count);
+		}
+		auto end = std::chrono::steady_clock::now();
+		std::cout << (interval ? "indexed write: " : "plain write:   ")
+			<< std::chrono::duration<double, std::nano>(end - begin).count() / count << " ns/event" << std::endl;
+		if (!interval)
+		{
+			continue;
+		}
+		const std::string target = "event " + std::to_string(count / 2) + " ";
+		begin = std::chrono::steady_clock::now();
+		bool found = ReadFile(big).find(target) != std::string::npos;
+		end = std::chrono::steady_clock::now();
+		std::cout << "full scan:     " << std::chrono::duration<double, std::micro>(end - begin).count()
+			<< " us" << std::endl;
+		Check(found, "full scan finds line");
+		begin = std::chrono::steady_clock::now();
+		std::vector<LogIndexEntry> big_entries;
+		LogFileIndex::Load(LogFileIndex::GetIndexName(big), big_entries);
+		uint64_t t = kBase + (count / 2) * kMS;
+		std::ifstream in(big, std::ios::binary | std::ios::ate);
+		ranges = LogFileIndex::Select(big_entries, static_cast<uint64_t>(in.tellg()), t, t, 0);
+		found = ReadRanges(big, ranges).find(target) != std::string::npos;
+		end = std::chrono::steady_clock::now();
+		std::cout << "indexed seek:  " << std::chrono::duration<double, std::micro>(end - begin).count()
+			<< " us, " << RangeBytes(ranges) << " bytes read" << std::endl;
+		Check(found, "indexed seek finds line");
+	}
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include <iostream>
+//去掉DEBUG级别的日志语句
+#define NILESTHUMP_LOG_COMPILE_LEVEL 2
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	检查日志宏的级别判断：
+	低于编译期级别的语句不求值参数，
+	低于运行期级别的语句不求值参数，
+	宏后面的else与用户自己的if配对
+***************************************************/
+static int s_evaluated = 0;
+
+static int Touch()
+{
+	++s_evaluated;
+	return s_evaluated;
+}
+
+int main(int argc, char** argv)
+{
+	using namespace GameProjectServer;
+	Logger::ptr logger = std::make_shared<Logger>("level_logger");
+	logger->addAppender(std::make_shared<StdoutLogAppender>());
+
+	NILESTHUMP_LOG_DEBUG(logger) << Touch();
+	NILESTHUMP_LOG_FMT_DEBUG(logger, "%d", Touch());
+	NILESTHUMP_LOG_PRINT_DEBUG(logger, "{}", Touch());
+	Check(s_evaluated == 0, "debug statement stripped at compile time");
+
+	NILESTHUMP_LOG_INFO(logger) << Touch();
+	NILESTHUMP_LOG_FMT_INFO(logger, "%d", Touch());
+	NILESTHUMP_LOG_PRINT_INFO(logger, "{}", Touch());
+	Check(s_evaluated == 3, "info statement enabled");
+
+	logger->setLevel(LogLevel::ERROR);
+	NILESTHUMP_LOG_WARN(logger) << Touch();
+	NILESTHUMP_LOG_FMT_WARN(logger, "%d", Touch());
+	NILESTHUMP_LOG_PRINT_WARN(logger, "{}", Touch());
+	Check(s_evaluated == 3, "warn statement disabled at runtime");
+
+	bool else_taken = false;
+	if (argc < 0)
+		NILESTHUMP_LOG_ERROR(logger) << "unreachable";
+	else
+		else_taken = true;
+	Check(else_taken, "else binds to the user's if");
+
+	else_taken = false;
+	if (argc > 0)
+		NILESTHUMP_LOG_WARN(logger) << "disabled";
+	else
+		else_taken = true;
+	Check(!else_taken, "disabled log statement does not take the user's else");
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	按时间合并的线程缓冲区：多个线程同时写日志，
+	文件中的日志按时间戳排列且不丢失，同一线程的日志保持先后；
+	退出线程的缓冲区被之后的线程复用；并统计每条日志的耗时
+***************************************************/
+using namespace GameProjectServer;
+
+static void RunThreads(Logger::ptr logger, int threads, int count)
+{
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t)
+	{
+		workers.emplace_back([=]() {
+			for (int i = 0; i < count; ++i)
+			{
+				NILESTHUMP_LOG_PRINT_INFO(logger, "thread {} event {}", t, i);
+			}
+		});
+	}
+	for (auto& i : workers)
+	{
+		i.join();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 50000;
+	const int threads = 4;
+	const std::string file = "test_log_merge.txt";
+
+	MergeLogAppender::ptr appender = std::make_shared<MergeLogAppender>(file, 16 * 1024 * 1024);
+	appender->setFormatter(std::make_shared<LogFormatter>("%d{%H:%M:%S.%9N}%T%m%n"));
+	Logger::ptr logger = std::make_shared<Logger>("merge_logger");
+	logger->addAppender(appender);
+
+	RunThreads(logger, threads, count);
+	//退出线程的缓冲区被复用
+	RunThreads(logger, threads, count);
+	Check(appender->getBufferCount() == threads, "buffers of exited threads reused");
+	appender->flush();
+	Check(appender->getDroppedCount() == 0, "no events dropped");
+	Check(appender->getWrittenCount() == 2ull * threads * count, "flush writes every event");
+
+	std::ifstream in(file);
+	std::string line;
+	long long last_time = 0;
+	std::vector<int> next(threads, 0);
+	bool time_ordered = true;
+	bool thread_ordered = true;
+	int total = 0;
+	while (std::getline(in, line))
+	{
+		int h = 0, m = 0, sec = 0, t = -1, i = -1;
+		long long ns = 0;
+		if (sscanf(line.c_str(), "%d:%d:%d.%lld\tthread %d event %d", &h, &m, &sec, &ns, &t, &i) != 6
+			|| t < 0 || t >= threads)
+		{
+			thread_ordered = false;
+			continue;
+		}
+		//第二轮从0重新开始
+		if (i != next[t] % count)
+		{
+			thread_ordered = false;
+		}
+		++next[t];
+		//日志时钟重新校准时时间戳会有微秒级的回退，不计为乱序
+		long long time = ((h * 60LL + m) * 60 + sec) * 1000000000LL + ns;
+		if (time < last_time - 1000000)
+		{
+			time_ordered = false;
+		}
+		last_time = time;
+		++total;
+	}
+	std::cout << "merged lines:     " << total << std::endl;
+	Check(total == 2 * threads * count, "no lines lost");
+	Check(thread_ordered, "per-thread order kept");
+	Check(time_ordered, "lines ordered by timestamp");
+
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		NILESTHUMP_LOG_PRINT_INFO(logger, "bench {}", i);
+	}
+	auto end = std::chrono::steady_clock::now();
+	std::cout << "merge append:     " << std::chrono::duration<double, std::nano>(end - begin).count() / count
+		<< " ns/event" << std::endl;
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/***************************************************
+	内存映射日志：段写满后滚动到下一个段，各段按顺序
+	读出全部日志；写日志的进程被SIGKILL杀死后，
+	已提交的日志仍完整地留在段文件中；并统计每条日志的耗时
+***************************************************/
+using namespace GameProjectServer;
+
+static void RemoveSegments(const std::string& file)
+{
+	for (int i = 1; i < 1000; ++i)
+	{
+		std::remove((file + "." + std::to_string(i)).c_str());
+	}
+}
+
+static Logger::ptr MakeLogger(const std::string& file, uint64_t segment_size)
+{
+	RemoveSegments(file);
+	Logger::ptr logger = std::make_shared<Logger>("mmap_logger");
+	MmapLogAppender::ptr appender = std::make_shared<MmapLogAppender>(file, segment_size);
+	appender->setFormatter(std::make_shared<LogFormatter>("%m%n"));
+	logger->addAppender(appender);
+	return logger;
+}
+
+//按顺序读出各段，检查内容为line 0..count-1
+static void CheckSegments(const std::string& file, int count, const std::string& what)
+{
+	std::string all;
+	int segments = 0;
+	std::string data;
+	while (LogMmapSegment::Read(file + "." + std::to_string(segments + 1), data))
+	{
+		all += data;
+		++segments;
+	}
+	std::istringstream in(all);
+	std::string line;
+	int expected = 0;
+	bool ordered = true;
+	while (std::getline(in, line))
+	{
+		if (line != "line " + std::to_string(expected))
+		{
+			ordered = false;
+		}
+		++expected;
+	}
+	std::cout << what << ": " << segments << " segments, " << expected << " lines" << std::endl;
+	Check(ordered && expected == count, what + " lines complete and in order");
+}
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 100000;
+
+	//段滚动
+	{
+		const std::string file = "test_log_mmap.txt";
+		Logger::ptr logger = MakeLogger(file, 64 * 1024);
+		auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			NILESTHUMP_LOG_PRINT_INFO(logger, "line {}", i);
+		}
+		auto end = std::chrono::steady_clock::now();
+		std::cout << "mmap append:      " << std::chrono::duration<double, std::nano>(end - begin).count() / count
+			<< " ns/event" << std::endl;
+		//关闭段文件，截断未使用的空间
+		logger->clearAppenders();
+		LogEpoch::Reclaim();
+		CheckSegments(file, count, "rolled");
+	}
+
+#ifndef _WIN32
+	//进程被杀死后段文件中的日志仍然完整
+	{
+		const std::string file = "test_log_mmap_crash.txt";
+		const int crash_count = 10000;
+		RemoveSegments(file);
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			Logger::ptr logger = MakeLogger(file, 1024 * 1024);
+			for (int i = 0; i < crash_count; ++i)
+			{
+				NILESTHUMP_LOG_PRINT_INFO(logger, "line {}", i);
+			}
+			kill(getpid(), SIGKILL);
+		}
+		int status = 0;
+		waitpid(pid, &status, 0);
+		Check(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL, "child killed");
+		CheckSegments(file, crash_count, "killed");
+	}
+#endif
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
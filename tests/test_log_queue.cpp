@@ -0,0 +1,116 @@
+#include <iostream>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	异步输出不丢失日志：AsyncLogAppender的入队与丢弃字节数
+	之和等于写入的字节数，析构后全部入队的日志都在文件中；
+	日志器事件队列的送达与丢弃条数之和等于发送条数；
+	多个线程持续写入时反复切换同步/异步，
+	切换回同步后没有日志留在队列中
+***************************************************/
+using namespace GameProjectServer;
+
+int main(int argc, char** argv)
+{
+	//AsyncLogAppender
+	{
+		const std::string file = "test_log_queue_async.txt";
+		std::remove(file.c_str());
+		Logger::ptr logger = std::make_shared<Logger>("queue_logger");
+		AsyncLogAppender::ptr appender = std::make_shared<AsyncLogAppender>(file, 4096, 100);
+		appender->setFormatter(std::make_shared<LogFormatter>("%m%n"));
+		logger->addAppender(appender);
+		uint64_t sent = 0;
+		for (int i = 0; i < 100; ++i)
+		{
+			NILESTHUMP_LOG_INFO(logger) << "async log message " << i;
+			sent += std::string("async log message " + std::to_string(i) + "\n").size();
+		}
+		appender->flush();
+		logger->delAppender(appender);
+		uint64_t queued = appender->getQueuedBytes();
+		Check(queued + appender->getDroppedBytes() == sent, "async queued plus dropped");
+		appender.reset();
+		std::ifstream in(file, std::ios::binary | std::ios::ate);
+		Check(static_cast<uint64_t>(in.tellg()) == queued, "async queued bytes written");
+	}
+
+	//日志器事件队列，低于WARN的日志在队列满时丢弃
+	{
+		Logger::ptr logger = std::make_shared<Logger>("queue_logger");
+		CountLogAppender::ptr appender = std::make_shared<CountLogAppender>();
+		logger->addAppender(appender);
+		logger->setAsync(256, LogOverflowPolicy::DROP_BELOW_LEVEL, LogLevel::WARN);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([logger, t]() {
+				for (int i = 0; i < 250; ++i)
+				{
+					NILESTHUMP_LOG_DEBUG(logger) << "queued log message " << t << " " << i;
+				}
+			});
+		}
+		for (auto& t : threads)
+		{
+			t.join();
+		}
+		logger->setSync();
+		Check(appender->getCount() + logger->getDroppedCount() == 1000, "queue delivered plus dropped");
+	}
+
+	//写入期间切换同步/异步及队列长度，阻塞策略下不丢失
+	{
+		Logger::ptr logger = std::make_shared<Logger>("queue_logger");
+		CountLogAppender::ptr appender = std::make_shared<CountLogAppender>();
+		logger->addAppender(appender);
+		std::atomic<bool> running{ true };
+		std::atomic<uint64_t> sent{ 0 };
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([&]() {
+				while (running.load(std::memory_order_relaxed))
+				{
+					NILESTHUMP_LOG_INFO(logger) << "toggle";
+					sent.fetch_add(1, std::memory_order_relaxed);
+				}
+			});
+		}
+		for (int i = 0; i < 50; ++i)
+		{
+			logger->setAsync(16);
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			//异步期间修改长度，换成新队列
+			logger->setAsync(i % 2 ? 64 : 256);
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			logger->setSync();
+		}
+		logger->setAsync(16);
+		logger->setAsync(64);
+		Check(logger->toYamlString().find("queue_size: 64") != std::string::npos, "queue size change applied");
+		running = false;
+		for (auto& t : threads)
+		{
+			t.join();
+		}
+		logger->setSync();
+		Check(appender->getCount() == sent.load() && logger->getDroppedCount() == 0, "no event left in queue");
+		std::cout << "toggled with " << sent.load() << " events, blocked " << logger->getBlockedCount() << std::endl;
+	}
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	限流日志宏：每n条、前n条、按时间间隔与令牌桶输出，
+	输出的日志附上被丢弃的条数，多线程下总数不丢失；
+	并统计被丢弃的日志语句的耗时
+***************************************************/
+using namespace GameProjectServer;
+
+//输出的条数加上附带的丢弃条数
+static uint64_t CountWithSuppressed(const std::vector<std::string>& lines)
+{
+	uint64_t total = 0;
+	for (auto& i : lines)
+	{
+		++total;
+		size_t pos = i.find(" (");
+		if (pos != std::string::npos)
+		{
+			total += strtoull(i.c_str() + pos + 2, nullptr, 10);
+		}
+	}
+	return total;
+}
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	CollectLogAppender::ptr appender = std::make_shared<CollectLogAppender>();
+	Logger::ptr logger = std::make_shared<Logger>("ratelimit_logger");
+	logger->setLevel(LogLevel::INFO);
+	logger->addAppender(appender);
+
+	//每n条
+	for (int i = 0; i < 25; ++i)
+	{
+		NILESTHUMP_LOG_EVERY_N(logger, LogLevel::INFO, 10) << "every " << i;
+	}
+	std::vector<std::string> lines = appender->take();
+	Check(lines.size() == 3 && lines[0] == "every 0" && lines[1] == "every 10 (9 suppressed)"
+		&& lines[2] == "every 20 (9 suppressed)", "EVERY_N");
+
+	//级别不满足时不计入限流
+	for (int i = 0; i < 25; ++i)
+	{
+		NILESTHUMP_LOG_FIRST_N(logger, LogLevel::DEBUG, 2) << "debug " << i;
+		NILESTHUMP_LOG_FIRST_N(logger, LogLevel::INFO, 2) << "first " << i;
+	}
+	lines = appender->take();
+	Check(lines.size() == 2 && lines[0] == "first 0" && lines[1] == "first 1", "FIRST_N");
+
+	//按时间间隔
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(250);
+	uint64_t calls = 0;
+	while (std::chrono::steady_clock::now() < deadline)
+	{
+		NILESTHUMP_LOG_EVERY_MS(logger, LogLevel::INFO, 100) << "tick";
+		++calls;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	NILESTHUMP_LOG_EVERY_MS(logger, LogLevel::INFO, 0) << "unlimited";
+	lines = appender->take();
+	Check(lines.size() == 4 && lines[0] == "tick" && lines[1].compare(0, 6, "tick (") == 0
+		&& lines[3] == "unlimited", "EVERY_MS");
+	Check(CountWithSuppressed(lines) - 1 <= calls && CountWithSuppressed(lines) - 1 + 100 > calls,
+		"EVERY_MS reports suppressed count");
+
+	//令牌桶：先允许burst条，之后按速率
+	for (int i = 0; i < 20; ++i)
+	{
+		if (i == 10)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(120));
+		}
+		NILESTHUMP_LOG_RATE(logger, LogLevel::INFO, 10, 3) << "bucket " << i;
+	}
+	lines = appender->take();
+	Check(lines.size() == 4 && lines[0] == "bucket 0" && lines[2] == "bucket 2"
+		&& lines[3] == "bucket 10 (7 suppressed)", "token bucket");
+
+	//多线程下输出与丢弃的总数等于调用次数
+	const int threads = 4;
+	const int per_thread = 100000;
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t)
+	{
+		workers.emplace_back([&]() {
+			for (int i = 0; i < per_thread; ++i)
+			{
+				NILESTHUMP_LOG_EVERY_N(logger, LogLevel::INFO, 1000) << "concurrent";
+			}
+		});
+	}
+	for (auto& i : workers)
+	{
+		i.join();
+	}
+	lines = appender->take();
+	Check(lines.size() == threads * per_thread / 1000, "EVERY_N concurrent lines");
+	Check(CountWithSuppressed(lines) == threads * per_thread - 999, "EVERY_N concurrent suppressed count");
+
+	auto measure = [&](const char* what, auto&& f) {
+		auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			f(i);
+		}
+		auto end = std::chrono::steady_clock::now();
+		std::cout << what << std::chrono::duration<double, std::nano>(end - begin).count() / count
+			<< " ns" << std::endl;
+	};
+	measure("suppressed every_n: ", [&](int i) { NILESTHUMP_LOG_EVERY_N(logger, LogLevel::INFO, 1u << 30) << "n " << i; });
+	measure("suppressed first_n: ", [&](int i) { NILESTHUMP_LOG_FIRST_N(logger, LogLevel::INFO, 0) << "n " << i; });
+	measure("suppressed every_ms:", [&](int i) { NILESTHUMP_LOG_EVERY_MS(logger, LogLevel::INFO, 100000) << "n " << i; });
+	measure("suppressed rate:    ", [&](int i) { NILESTHUMP_LOG_RATE(logger, LogLevel::INFO, 0.001, 1) << "n " << i; });
+	appender->take();
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
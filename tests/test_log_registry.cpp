@@ -0,0 +1,99 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	日志器注册表：多线程同时创建同名日志器得到同一个，
+	_STATIC宏在调用点缓存句柄，其他名称每次查找，
+	并比较缓存句柄、注册表查找的耗时
+***************************************************/
+using namespace GameProjectServer;
+
+template<class F>
+static double Measure(int count, F&& f)
+{
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		f();
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - begin).count() / count;
+}
+
+static const Logger::ptr& SystemLogger()
+{
+	return NILESTHUMP_LOG_GET_LOGGER_STATIC("system");
+}
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+
+	//并发创建
+	const int threads = 4;
+	const int names = 200;
+	std::vector<std::vector<Logger::ptr>> results(threads);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t)
+	{
+		workers.emplace_back([&, t]() {
+			for (int i = 0; i < names; ++i)
+			{
+				results[t].push_back(LoggerMgr::GetInstance()->getLogger("registry_" + std::to_string(i)));
+			}
+		});
+	}
+	for (auto& i : workers)
+	{
+		i.join();
+	}
+	for (int i = 0; i < names; ++i)
+	{
+		for (int t = 1; t < threads; ++t)
+		{
+			Check(results[t][i] == results[0][i], "same logger for registry_" + std::to_string(i));
+		}
+	}
+	Check(LoggerMgr::GetInstance()->findLogger("registry_7") == results[0][7], "findLogger");
+	Check(!LoggerMgr::GetInstance()->findLogger("registry_missing"), "findLogger missing");
+
+	//调用点句柄
+	Check(&SystemLogger() == &SystemLogger(), "call site handle cached");
+	Check(SystemLogger() == LoggerMgr::GetInstance()->getLogger("system"), "handle is the registered logger");
+	Check(NILESTHUMP_LOG_ROOT() == LoggerMgr::GetInstance()->getRoot(), "root handle");
+	std::string name = "registry_runtime";
+	Logger::ptr runtime = NILESTHUMP_LOG_GET_LOGGER(name);
+	name = "registry_runtime2";
+	Check(NILESTHUMP_LOG_GET_LOGGER(name)->getName() == "registry_runtime2"
+		&& runtime->getName() == "registry_runtime", "runtime names are not cached");
+	//字符数组的内容可以变化，同样不缓存
+	for (const char* i : { "registry_buffer1", "registry_buffer2" })
+	{
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "%s", i);
+		Check(NILESTHUMP_LOG_GET_LOGGER(buffer)->getName() == i, "char arrays are not cached");
+	}
+
+	volatile size_t sink = 0;
+	double cached = Measure(count, [&]() { sink += (size_t)NILESTHUMP_LOG_GET_LOGGER_STATIC("system").get(); });
+	double lookup = Measure(count, [&]() { sink += (size_t)LoggerMgr::GetInstance()->getLogger("system").get(); });
+	double root = Measure(count, [&]() { sink += (size_t)NILESTHUMP_LOG_ROOT().get(); });
+	std::cout << "cached handle:    " << cached << " ns" << std::endl;
+	std::cout << "registry lookup:  " << lookup << " ns" << std::endl;
+	std::cout << "root handle:      " << root << " ns" << std::endl;
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Util.h"
+#include "Config.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	配置热更新：多个线程持续写日志的同时，
+	主线程反复替换日志器的级别、格式器与appender集合，
+	检查每条日志恰好被一份完整配置中的appender收到，
+	被替换的appender在没有线程使用后才析构；
+	只修改级别的热更新也会重建appender，文件中已有的日志保留
+***************************************************/
+using namespace GameProjectServer;
+
+static std::atomic<uint64_t> s_received{ 0 };   //所有appender收到的日志数
+static std::atomic<uint64_t> s_bad{ 0 };        //已析构后仍被调用的次数
+static std::atomic<uint64_t> s_destroyed{ 0 };
+
+//格式化后计数的appender，析构后被调用时记录错误
+class ReloadLogAppender : public LogAppender
+{
+public:
+	using ptr = std::shared_ptr<ReloadLogAppender>;
+	static constexpr uint32_t kAlive = 0x5a5a5a5a;
+
+	~ReloadLogAppender()
+	{
+		m_magic = 0;
+		s_destroyed.fetch_add(1, std::memory_order_relaxed);
+	}
+	void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override
+	{
+		if (m_magic != kAlive)
+		{
+			s_bad.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		if (level >= m_level && formatter()->render(level, *event).size())
+		{
+			s_received.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	std::string toYamlString() override { return ""; }
+private:
+	volatile uint32_t m_magic = kAlive;
+};
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 100000;
+	const int threads = 3;
+	Logger::ptr logger = std::make_shared<Logger>("reload_logger");
+	logger->reconfigure(LogLevel::DEBUG, nullptr, { std::make_shared<ReloadLogAppender>(), std::make_shared<ReloadLogAppender>() });
+
+	std::atomic<int> running{ threads };
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t)
+	{
+		workers.emplace_back([&, t]() {
+			for (int i = 0; i < count; ++i)
+			{
+				NILESTHUMP_LOG_PRINT_INFO(logger, "thread {} event {}", t, i);
+			}
+			running.fetch_sub(1);
+		});
+	}
+
+	//每份配置都有两个接受INFO的appender
+	const char* patterns[] = { "%d%T%p%T%m%n", "%m%n", LogFormatter::kDefaultPattern };
+	uint64_t reloads = 0;
+	while (running.load())
+	{
+		LogFormatter::ptr formatter = std::make_shared<LogFormatter>(patterns[reloads % 3]);
+		logger->reconfigure(reloads % 2 ? LogLevel::DEBUG : LogLevel::INFO, formatter,
+			{ std::make_shared<ReloadLogAppender>(), std::make_shared<ReloadLogAppender>() });
+		logger->setFormatter(patterns[(reloads + 1) % 3]);
+		++reloads;
+		std::this_thread::yield();
+	}
+	for (auto& i : workers)
+	{
+		i.join();
+	}
+
+	Check(s_bad.load() == 0, "appender used after destruction");
+	Check(s_received.load() == 2ull * threads * count, "every event reaches both appenders of one snapshot");
+	logger->clearAppenders();
+	LogEpoch::Reclaim();
+	Check(LogEpoch::GetPendingCount() == 0, "retired snapshots reclaimed");
+	Check(s_destroyed.load() == 2 * (reloads + 1), "replaced appenders destroyed");
+	std::cout << "reloads: " << reloads << std::endl;
+
+	//读者临界区的开销
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		LogEpoch::Guard guard;
+	}
+	auto end = std::chrono::steady_clock::now();
+	std::cout << "epoch guard:      " << std::chrono::duration<double, std::nano>(end - begin).count() / count
+		<< " ns" << std::endl;
+
+	//热更新重建写文件的appender后，之前写入的日志保留
+	{
+		const std::string async_file = "test_log_reload_async.txt";
+		const std::string merge_file = "test_log_reload_merge.txt";
+		const std::string binary_file = "test_log_reload_binary.bin";
+		std::remove(async_file.c_str());
+		std::remove(merge_file.c_str());
+		std::remove(binary_file.c_str());
+		auto load = [&](const std::string& level) {
+			Config::LoadFromYaml(YAML::Load(
+				"logs:\n"
+				"  - name: reload_file_logger\n"
+				"    level: " + level + "\n"
+				"    appenders:\n"
+				"      - type: AsyncLogAppender\n"
+				"        file: " + async_file + "\n"
+				"        formatter: \"%m%n\"\n"
+				"      - type: MergeLogAppender\n"
+				"        file: " + merge_file + "\n"
+				"        formatter: \"%m%n\"\n"
+				"      - type: BinaryLogAppender\n"
+				"        file: " + binary_file + "\n"));
+		};
+		Logger::ptr file_logger = LoggerMgr::GetInstance()->getLogger("reload_file_logger");
+		load("info");
+		NILESTHUMP_LOG_INFO(file_logger) << "before reload";
+		load("debug");
+		NILESTHUMP_LOG_INFO(file_logger) << "after reload";
+		file_logger->clearAppenders();
+		LogEpoch::Reclaim();
+
+		auto read = [](const std::string& file) {
+			std::ifstream in(file, std::ios_base::binary);
+			std::stringstream ss;
+			ss << in.rdbuf();
+			return ss.str();
+		};
+		Check(read(async_file) == "before reload\nafter reload\n", "async appender keeps lines across reload");
+		Check(read(merge_file) == "before reload\nafter reload\n", "merge appender keeps lines across reload");
+		std::ifstream in(binary_file, std::ios_base::binary);
+		std::stringstream decoded;
+		BinaryLogDecoder decoder(std::make_shared<LogFormatter>("%m%n"));
+		Check(decoder.decode(in, decoded) && decoded.str() == "before reload\nafter reload\n",
+			"binary appender keeps records across reload");
+	}
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/***************************************************
+	飞行记录器：低级别日志只记录在各线程的环形缓冲区中，
+	出现ERROR时按时间顺序输出之前的上下文，每个线程只保留
+	最近capacity条，退出线程的记录环被复用；进程收到
+	致命信号时也输出记录，再交给之前安装的处理函数；
+	并统计记录一条日志的耗时
+***************************************************/
+using namespace GameProjectServer;
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+
+	//ERROR之前的上下文按顺序输出
+	{
+		CollectLogAppender::ptr target = std::make_shared<CollectLogAppender>();
+		RingBufferLogAppender::ptr recorder = std::make_shared<RingBufferLogAppender>(target, 16);
+		Logger::ptr logger = std::make_shared<Logger>("ring_logger");
+		logger->setLevel(LogLevel::DEBUG);
+		logger->addAppender(recorder);
+
+		std::thread worker([&]() {
+			for (int i = 0; i < 5; ++i)
+			{
+				NILESTHUMP_LOG_PRINT_DEBUG(logger, "worker {}", i);
+			}
+		});
+		worker.join();
+		for (int i = 0; i < 5; ++i)
+		{
+			NILESTHUMP_LOG_PRINT_DEBUG(logger, "main {}", i);
+		}
+		Check(target->take().empty() && recorder->getDumpCount() == 0, "debug events only recorded");
+
+		NILESTHUMP_LOG_ERROR(logger) << "boom";
+		std::vector<std::string> lines = target->take();
+		Check(recorder->getDumpCount() == 1, "error triggers dump");
+		Check(lines.size() == 11, "dump contains context of all threads");
+		if (lines.size() == 11)
+		{
+			bool ordered = true;
+			for (int i = 0; i < 5; ++i)
+			{
+				ordered = ordered && lines[i] == "worker " + std::to_string(i)
+					&& lines[i + 5] == "main " + std::to_string(i);
+			}
+			Check(ordered && lines[10] == "boom", "dump in time order");
+		}
+
+		//每个线程只保留最近capacity条，输出后清空
+		for (int i = 0; i < 100; ++i)
+		{
+			NILESTHUMP_LOG_PRINT_DEBUG(logger, "line {}", i);
+		}
+		recorder->dump();
+		lines = target->take();
+		Check(lines.size() == 16 && lines.front() == "line 84" && lines.back() == "line 99", "capacity bound");
+		recorder->dump();
+		Check(target->take().empty(), "dump clears records");
+
+		//目标借用本appender的格式器，本appender换格式器后跟随
+		LogFormatter::ptr formatter = std::make_shared<LogFormatter>("%m%n");
+		recorder->setFormatter(formatter);
+		NILESTHUMP_LOG_DEBUG(logger) << "borrowed";
+		recorder->dump();
+		Check(target->take().size() == 1 && target->getFormatter() == formatter, "target borrows recorder formatter");
+
+		//退出线程的记录环由之后的线程复用，记录保留到被覆盖
+		for (int i = 0; i < 10; ++i)
+		{
+			std::thread([&]() { NILESTHUMP_LOG_PRINT_DEBUG(logger, "short {}", i); }).join();
+		}
+		Check(recorder->getRingCount() == 2, "rings reused after thread exit");
+		recorder->dump();
+		lines = target->take();
+		Check(lines.size() == 10 && lines.front() == "short 0" && lines.back() == "short 9", "reused ring keeps records");
+
+		auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			NILESTHUMP_LOG_PRINT_DEBUG(logger, "record {}", i);
+		}
+		auto end = std::chrono::steady_clock::now();
+		std::cout << "ring record:      " << std::chrono::duration<double, std::nano>(end - begin).count() / count
+			<< " ns/event" << std::endl;
+		//记录持有日志器，移除后appender随作用域释放，不再参与之后的信号输出
+		logger->delAppender(recorder);
+	}
+
+#ifndef _WIN32
+	//致命信号时输出到文件
+	{
+		const std::string file = "test_log_ringbuffer_crash.txt";
+		std::remove(file.c_str());
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			FileLogAppender::ptr target = std::make_shared<FileLogAppender>(file);
+			target->setFormatter(std::make_shared<LogFormatter>("%m%n"));
+			RingBufferLogAppender::ptr recorder = std::make_shared<RingBufferLogAppender>(target);
+			RingBufferLogAppender::InstallSignalHandler();
+			Logger::ptr logger = std::make_shared<Logger>("ring_crash_logger");
+			logger->setLevel(LogLevel::DEBUG);
+			logger->addAppender(recorder);
+			for (int i = 0; i < 10; ++i)
+			{
+				NILESTHUMP_LOG_PRINT_DEBUG(logger, "before crash {}", i);
+			}
+			raise(SIGSEGV);
+			_exit(0);
+		}
+		int status = 0;
+		waitpid(pid, &status, 0);
+		Check(WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV, "child died of SIGSEGV");
+		std::ifstream in(file);
+		std::string line;
+		int expected = 0;
+		bool ordered = true;
+		while (std::getline(in, line))
+		{
+			//信号处理中不使用格式器，按固定格式输出
+			const std::string message = "\t[DEBUG]\t[ring_crash_logger]\t<";
+			const std::string tail = ">\tbefore crash " + std::to_string(expected);
+			ordered = ordered && line.size() > 26 + message.size() + tail.size()
+				&& line[4] == '-' && line[10] == ' ' && line[19] == '.'
+				&& line.find(message) != std::string::npos
+				&& line.compare(line.size() - tail.size(), tail.size(), tail) == 0;
+			++expected;
+		}
+		Check(ordered && expected == 10, "records dumped on signal");
+	}
+
+	//输出后交给之前安装的处理函数
+	{
+		const std::string file = "test_log_ringbuffer_chain.txt";
+		std::remove(file.c_str());
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			struct sigaction previous;
+			memset(&previous, 0, sizeof(previous));
+			sigemptyset(&previous.sa_mask);
+			previous.sa_handler = [](int) { _exit(42); };
+			sigaction(SIGABRT, &previous, nullptr);
+			FileLogAppender::ptr target = std::make_shared<FileLogAppender>(file);
+			target->setFormatter(std::make_shared<LogFormatter>("%m%n"));
+			RingBufferLogAppender::ptr recorder = std::make_shared<RingBufferLogAppender>(target);
+			RingBufferLogAppender::InstallSignalHandler();
+			Logger::ptr logger = std::make_shared<Logger>("ring_chain_logger");
+			logger->setLevel(LogLevel::DEBUG);
+			logger->addAppender(recorder);
+			NILESTHUMP_LOG_DEBUG(logger) << "before abort";
+			abort();
+		}
+		int status = 0;
+		waitpid(pid, &status, 0);
+		Check(WIFEXITED(status) && WEXITSTATUS(status) == 42, "previous handler chained");
+		std::ifstream in(file);
+		std::string line;
+		const std::string tail = "\tbefore abort";
+		Check(std::getline(in, line) && line.size() > tail.size()
+			&& line.compare(line.size() - tail.size(), tail.size(), tail) == 0, "records dumped before previous handler");
+	}
+#endif
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	日志文件轮转：按长度轮转时日志按顺序分布在各文件中且不丢失，
+	超出保留数的旧文件被删除，按时间间隔轮转
+***************************************************/
+using namespace GameProjectServer;
+
+static bool Exists(const std::string& file)
+{
+	return std::ifstream(file).good();
+}
+
+static void RemoveFiles(const std::string& file)
+{
+	std::remove(file.c_str());
+	for (int i = 1; i < 100; ++i)
+	{
+		std::remove((file + "." + std::to_string(i)).c_str());
+	}
+}
+
+static Logger::ptr MakeLogger(const std::string& file, const LogRotatePolicy& policy, FileLogAppender::ptr& appender)
+{
+	RemoveFiles(file);
+	Logger::ptr logger = std::make_shared<Logger>("rotate_logger");
+	appender = std::make_shared<FileLogAppender>(file);
+	appender->setFormatter(std::make_shared<LogFormatter>("%m%n"));
+	appender->setRotatePolicy(policy);
+	logger->addAppender(appender);
+	return logger;
+}
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 20000;
+
+	//按长度轮转，不限保留数，所有行按顺序出现一次
+	{
+		const std::string file = "test_log_rotate_size.txt";
+		LogRotatePolicy policy;
+		policy.size = 64 * 1024;
+		policy.preallocate = 128 * 1024;
+		FileLogAppender::ptr appender;
+		Logger::ptr logger = MakeLogger(file, policy, appender);
+		for (int i = 0; i < count; ++i)
+		{
+			NILESTHUMP_LOG_PRINT_INFO(logger, "line {} 0123456789abcdefghijklmnopqrstuvwxyz", i);
+			if (i % 1000 == 999)
+			{
+				//单核环境下让出CPU，给轮转线程运行的机会
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			}
+		}
+		appender->flush();
+		uint64_t rotated = appender->getWriter()->getRotateCount();
+		std::cout << "size rotations:   " << rotated << std::endl;
+		Check(rotated >= 3, "rotated by size");
+
+		int expected = 0;
+		bool ordered = true;
+		for (int i = static_cast<int>(rotated); i >= 0; --i)
+		{
+			std::ifstream in(i ? file + "." + std::to_string(i) : file);
+			Check(in.good(), "rotated file " + std::to_string(i) + " exists");
+			std::string line;
+			while (std::getline(in, line))
+			{
+				if (line.compare(0, 5, "line ") != 0 || atoi(line.c_str() + 5) != expected)
+				{
+					ordered = false;
+				}
+				++expected;
+			}
+		}
+		Check(ordered, "lines in order across rotated files");
+		Check(expected == count, "no lines lost across rotation");
+	}
+
+	//保留数
+	{
+		const std::string file = "test_log_rotate_keep.txt";
+		LogRotatePolicy policy;
+		policy.size = 4096;
+		policy.max_files = 2;
+		FileLogAppender::ptr appender;
+		Logger::ptr logger = MakeLogger(file, policy, appender);
+		for (int i = 0; i < 10; ++i)
+		{
+			for (int j = 0; j < 100; ++j)
+			{
+				NILESTHUMP_LOG_PRINT_INFO(logger, "line {} 0123456789abcdefghijklmnopqrstuvwxyz", j);
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(150));
+		}
+		appender->flush();
+		Check(appender->getWriter()->getRotateCount() >= 3, "rotated with max_files");
+		Check(Exists(file) && Exists(file + ".1") && Exists(file + ".2") && !Exists(file + ".3"),
+			"only max_files old files kept");
+	}
+
+	//按时间轮转
+	{
+		const std::string file = "test_log_rotate_time.txt";
+		LogRotatePolicy policy;
+		policy.interval = 1;
+		FileLogAppender::ptr appender;
+		Logger::ptr logger = MakeLogger(file, policy, appender);
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(2500);
+		while (std::chrono::steady_clock::now() < deadline)
+		{
+			NILESTHUMP_LOG_INFO(logger) << "tick";
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		}
+		appender->flush();
+		Check(appender->getWriter()->getRotateCount() >= 2, "rotated by interval");
+		Check(Exists(file + ".1") && Exists(file + ".2"), "interval rotated files exist");
+	}
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
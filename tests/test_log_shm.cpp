@@ -0,0 +1,285 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+#ifdef _WIN32
+#include <process.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+/***************************************************
+	共享内存日志通道：多个进程写入同一通道，
+	唯一的收集器把各进程的日志按时间顺序写入一个文件，
+	每个进程的日志不丢失且保持先后；第二个收集器被拒绝；
+	进程没有归还槽就退出时，收集器取出剩余日志后回收槽；
+	环形缓冲区已满时丢弃并计数；
+	并比较与FileLogAppender的写入耗时
+***************************************************/
+using namespace GameProjectServer;
+
+static std::string ReadFile(const std::string& file)
+{
+	std::ifstream in(file, std::ios::binary);
+	std::stringstream ss;
+	ss << in.rdbuf();
+	return ss.str();
+}
+
+static Logger::ptr MakeLogger(LogAppender::ptr appender)
+{
+	Logger::ptr logger = std::make_shared<Logger>("shm_logger");
+	appender->setFormatter(std::make_shared<LogFormatter>("%N %m%n"));
+	logger->addAppender(appender);
+	return logger;
+}
+
+//子进程：向通道写入count条日志，abandon时不归还槽直接退出
+static int RunChild(const std::string& channel, int id, int count, bool abandon)
+{
+	ShmLogAppender::ptr appender = std::make_shared<ShmLogAppender>(channel, 8, 256 * 1024);
+	Logger::ptr logger = MakeLogger(appender);
+	for (int i = 0; i < count; ++i)
+	{
+		NILESTHUMP_LOG_PRINT_INFO(logger, "proc {} seq {}", id, i);
+		//等待收集器取出，不因环形缓冲区写满而丢弃
+		while (appender->getSlot() >= 0 && appender->getChannel()->getPendingBytes(appender->getSlot()) > 128 * 1024)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+	if (abandon)
+	{
+		std::_Exit(appender->getDroppedCount() ? 1 : 0);
+	}
+	return appender->getDroppedCount() ? 1 : 0;
+}
+
+#ifdef _WIN32
+using ChildHandle = intptr_t;
+#else
+using ChildHandle = pid_t;
+#endif
+
+static ChildHandle SpawnChild(const char* self, const std::string& channel, int id, int count, bool abandon)
+{
+	std::string id_str = std::to_string(id);
+	std::string count_str = std::to_string(count);
+	const char* args[] = { self, "child", channel.c_str(), id_str.c_str(), count_str.c_str(),
+		abandon ? "abandon" : "release", nullptr };
+#ifdef _WIN32
+	return _spawnv(_P_NOWAIT, self, args);
+#else
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		execv(self, const_cast<char* const*>(args));
+		std::_Exit(127);
+	}
+	return pid;
+#endif
+}
+
+//子进程退出时返回true并取得退出码
+static bool TryWaitChild(ChildHandle child, int& code)
+{
+#ifdef _WIN32
+	if (WaitForSingleObject(reinterpret_cast<HANDLE>(child), 0) != WAIT_OBJECT_0)
+	{
+		return false;
+	}
+	_cwait(&code, child, 0);
+	return true;
+#else
+	int status = 0;
+	if (waitpid(child, &status, WNOHANG) != child)
+	{
+		return false;
+	}
+	code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	return true;
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	if (argc == 6 && std::string(argv[1]) == "child")
+	{
+		return RunChild(argv[2], atoi(argv[3]), atoi(argv[4]), std::string(argv[5]) == "abandon");
+	}
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	const std::string channel = "nst_test_log_shm_" + std::to_string(GetCurrentTimeNS() % 1000000);
+	const std::string file = "test_log_shm.txt";
+	LogShmChannel::Remove(channel);
+
+	//多个进程写入，一个收集器按时间顺序写入文件
+	{
+		const int procs = 4;
+		const int per_proc = 20000;
+		LogFileWriter::ptr writer = std::make_shared<LogFileWriter>();
+		writer->open(file);
+		LogShmCollector::ptr collector = LogShmCollector::Open(channel, writer, 500, 8, 256 * 1024);
+		Check(collector != nullptr, "collector opens");
+		if (!collector)
+		{
+			return 1;
+		}
+		Check(!LogShmCollector::Open(channel, writer), "second collector refused");
+
+		std::vector<ChildHandle> children;
+		for (int i = 0; i < procs; ++i)
+		{
+			children.push_back(SpawnChild(argv[0], channel, i, per_proc, i == procs - 1));
+		}
+		size_t running = children.size();
+		while (running)
+		{
+			collector->poll();
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			for (auto& child : children)
+			{
+				int code = 0;
+				if (child && TryWaitChild(child, code))
+				{
+					Check(code == 0, "child logged without drops");
+					child = 0;
+					--running;
+				}
+			}
+		}
+		collector->poll(true);
+		Check(collector->getDroppedCount() == 0 && collector->getLostBytes() == 0, "nothing dropped");
+		Check(collector->getWrittenCount() == procs * per_proc, "all events collected");
+		bool released = true;
+		for (uint32_t i = 0; i < collector->getChannel().getSlotCount(); ++i)
+		{
+			released = released && collector->getChannel().getOwner(i) == 0;
+		}
+		Check(released, "abandoned slot reclaimed");
+		collector.reset();
+		writer->close();
+
+		//按时间排序，每个进程的日志不缺失且保持先后
+		std::istringstream in(ReadFile(file));
+		std::vector<int> next(procs, 0);
+		std::string line;
+		uint64_t last_time = 0;
+		bool ordered = true;
+		bool sequential = true;
+		while (std::getline(in, line))
+		{
+			uint64_t time = 0;
+			int id = -1;
+			int seq = -1;
+			if (sscanf(line.c_str(), "%llu proc %d seq %d", reinterpret_cast<unsigned long long*>(&time), &id, &seq) != 3
+				|| id < 0 || id >= procs)
+			{
+				sequential = false;
+				break;
+			}
+			//时钟重新校准时时间戳可能略微回退
+			ordered = ordered && time + 1000000 >= last_time;
+			last_time = time;
+			sequential = sequential && seq == next[id]++;
+		}
+		Check(ordered, "merged in time order");
+		bool complete = sequential;
+		for (int i = 0; i < procs; ++i)
+		{
+			complete = complete && next[i] == per_proc;
+		}
+		Check(complete, "every process complete and in order");
+	}
+
+	//环形缓冲区已满时丢弃，已写入的日志完整
+	{
+		const std::string small = channel + "_small";
+		LogShmChannel::Remove(small);
+		ShmLogAppender::ptr appender = std::make_shared<ShmLogAppender>(small, 2, 4096);
+		Logger::ptr logger = MakeLogger(appender);
+		Check(appender->getSlot() >= 0, "slot acquired");
+		for (int i = 0; i < 1000; ++i)
+		{
+			NILESTHUMP_LOG_PRINT_INFO(logger, "overflow {}", i);
+		}
+		Check(appender->getDroppedCount() > 0 && appender->getChannel()->getDroppedCount(appender->getSlot())
+			== appender->getDroppedCount(), "full ring drops");
+		Check(appender->toYamlString().find("ring_size: 4096") != std::string::npos, "shm in yaml");
+
+		LogFileWriter::ptr writer = std::make_shared<LogFileWriter>();
+		writer->open(file);
+		LogShmCollector::ptr collector = LogShmCollector::Open(small, writer, 0);
+		collector->poll(true);
+		uint64_t kept = collector->getWrittenCount();
+		Check(kept > 0 && kept + appender->getDroppedCount() == 1000, "kept plus dropped");
+		//取出后又有空间
+		NILESTHUMP_LOG_PRINT_INFO(logger, "after drain");
+		collector->poll(true);
+		Check(collector->getWrittenCount() == kept + 1, "space reused after drain");
+		collector.reset();
+		writer->close();
+		std::string data = ReadFile(file);
+		Check(data.find("overflow 0\n") != std::string::npos && data.find("after drain\n") != std::string::npos
+			&& data.back() == '\n', "complete lines");
+		appender.reset();
+		LogShmChannel::Remove(small);
+	}
+
+	//写入耗时：共享内存通道(收集器在另一线程) / 文件
+	{
+		LogFileWriter::ptr writer = std::make_shared<LogFileWriter>();
+		writer->open(file);
+		LogShmCollector::ptr collector = LogShmCollector::Open(channel, writer);
+		std::atomic<bool> running{ true };
+		std::thread collect([&]() {
+			while (running.load())
+			{
+				collector->poll();
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		});
+		ShmLogAppender::ptr appender = std::make_shared<ShmLogAppender>(channel);
+		Logger::ptr logger = MakeLogger(appender);
+		auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			NILESTHUMP_LOG_PRINT_INFO(logger, "player {} moved to zone {}", i, i % 7);
+		}
+		auto end = std::chrono::steady_clock::now();
+		running = false;
+		collect.join();
+		collector->poll(true);
+		std::cout << "shm appender:  " << std::chrono::duration<double, std::nano>(end - begin).count() / count
+			<< " ns/event, dropped " << appender->getDroppedCount() << std::endl;
+
+		FileLogAppender::ptr file_appender = std::make_shared<FileLogAppender>(file);
+		logger = MakeLogger(file_appender);
+		begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			NILESTHUMP_LOG_PRINT_INFO(logger, "player {} moved to zone {}", i, i % 7);
+		}
+		file_appender->flush();
+		end = std::chrono::steady_clock::now();
+		std::cout << "file appender: " << std::chrono::duration<double, std::nano>(end - begin).count() / count
+			<< " ns/event" << std::endl;
+	}
+	LogShmChannel::Remove(channel);
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+#include "Util.h"
+#include "Log.h"
+#include "LogTestUtil.h"
+
+/***************************************************
+	日志调用点统计：每个调用点分别统计输出条数、
+	被级别跳过的条数与消息字节数，多线程与已退出线程的计数
+	都被汇总；按开销输出前N个调用点；并统计调用点计数的耗时
+***************************************************/
+using namespace GameProjectServer;
+
+static LogSiteStats FindSite(int line)
+{
+	for (auto& i : LogSiteCollect())
+	{
+		if (i.line == line && i.file.find("test_log_sites.cpp") != std::string::npos)
+		{
+			return i;
+		}
+	}
+	return LogSiteStats();
+}
+
+int main(int argc, char** argv)
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	Logger::ptr logger = std::make_shared<Logger>("sites_logger");
+	logger->setLevel(LogLevel::INFO);
+	logger->addAppender(std::make_shared<NullLogAppender>());
+
+	const std::string payload(100, 'x');
+	int noisy_line = 0;
+	int quiet_line = 0;
+	int debug_line = 0;
+	for (int i = 0; i < 1000; ++i)
+	{
+		noisy_line = __LINE__ + 1;
+		NILESTHUMP_LOG_INFO(logger) << payload;
+		if (i % 100 == 0)
+		{
+			quiet_line = __LINE__ + 1;
+			NILESTHUMP_LOG_PRINT_WARN(logger, "quiet {}", i % 10);
+		}
+		debug_line = __LINE__ + 1;
+		NILESTHUMP_LOG_DEBUG(logger) << "skipped";
+	}
+
+	//多个线程写同一个调用点，线程退出后计数仍保留
+	const int thread_line = __LINE__ + 7;
+	std::vector<std::thread> workers;
+	for (int t = 0; t < 4; ++t)
+	{
+		workers.emplace_back([&]() {
+			for (int i = 0; i < 5000; ++i)
+			{
+				NILESTHUMP_LOG_FMT_INFO(logger, "%d", 7);
+			}
+		});
+	}
+	for (auto& i : workers)
+	{
+		i.join();
+	}
+
+	LogSiteStats noisy = FindSite(noisy_line);
+	LogSiteStats quiet = FindSite(quiet_line);
+	LogSiteStats debug = FindSite(debug_line);
+	LogSiteStats threaded = FindSite(thread_line);
+	Check(noisy.emitted == 1000 && noisy.bytes == 100000 && noisy.suppressed == 0, "noisy site counted");
+	Check(quiet.emitted == 10 && quiet.bytes == 70 && quiet.level == LogLevel::WARN, "quiet site counted");
+	Check(debug.emitted == 0 && debug.suppressed == 1000, "suppressed by level counted");
+	Check(threaded.emitted == 20000 && threaded.bytes == 20000, "exited threads counted");
+
+	YAML::Node top = YAML::Load(LoggerMgr::GetInstance()->toSiteStatsYamlString(2));
+	Check(top.IsSequence() && top.size() == 2, "top-n size");
+	if (top.IsSequence() && top.size() == 2)
+	{
+		Check(top[0]["line"].as<int>() == noisy_line && top[0]["bytes"].as<uint64_t>() == 100000
+			&& top[1]["line"].as<int>() == thread_line && top[1]["level"].as<std::string>() == "INFO",
+			"top-n ordered by cost");
+	}
+
+	auto measure = [&](const char* what, auto&& f) {
+		auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			f(i);
+		}
+		auto end = std::chrono::steady_clock::now();
+		std::cout << what << std::chrono::duration<double, std::nano>(end - begin).count() / count
+			<< " ns" << std::endl;
+	};
+	measure("disabled statement: ", [&](int i) { NILESTHUMP_LOG_DEBUG(logger) << i; });
+	measure("enabled statement:  ", [&](int i) { NILESTHUMP_LOG_INFO(logger) << i; });
+
+	if (s_failed)
+	{
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
\ No newline at end of file
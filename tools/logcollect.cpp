@@ -0,0 +1,125 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "Log.h"
+
+/***************************************************
+	共享内存日志收集进程
+	logcollect <channel> <log file> [--size bytes] [--interval seconds]
+		[--max-files n] [--poll ms] [--delay ms] [--slots n] [--ring-size bytes] [--remove]
+	取出通道中各进程(ShmLogAppender)写入的日志，
+	按时间顺序追加到一个文件中，并按--size/--interval轮转；
+	--poll为取出的间隔，--delay为写出前等待迟到日志的时间，
+	--slots/--ring-size只在通道还不存在时使用；
+	收到SIGINT/SIGTERM后写出剩余的日志退出，--remove时同时删除通道
+***************************************************/
+using namespace GameProjectServer;
+
+static std::atomic<bool> s_running{ true };
+
+static void OnSignal(int)
+{
+	s_running.store(false);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cerr << "usage: " << argv[0] << " <channel> <log file> [--size bytes] [--interval seconds]"
+			<< " [--max-files n] [--poll ms] [--delay ms] [--slots n] [--ring-size bytes] [--remove]" << std::endl;
+		return 2;
+	}
+	std::string channel = argv[1];
+	std::string file = argv[2];
+	LogRotatePolicy rotate;
+	uint32_t poll = 10;
+	uint32_t delay = LogShmCollector::kDefaultDelay;
+	uint32_t slots = LogShmChannel::kDefaultSlotCount;
+	uint64_t ring_size = LogShmChannel::kDefaultRingSize;
+	bool remove = false;
+	for (int i = 3; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--remove")
+		{
+			remove = true;
+			continue;
+		}
+		if (i + 1 >= argc)
+		{
+			std::cerr << "missing value for " << arg << std::endl;
+			return 2;
+		}
+		uint64_t value = std::strtoull(argv[++i], nullptr, 10);
+		if (arg == "--size")
+		{
+			rotate.size = value;
+		}
+		else if (arg == "--interval")
+		{
+			rotate.interval = static_cast<uint32_t>(value);
+		}
+		else if (arg == "--max-files")
+		{
+			rotate.max_files = static_cast<uint32_t>(value);
+		}
+		else if (arg == "--poll")
+		{
+			poll = static_cast<uint32_t>(value);
+		}
+		else if (arg == "--delay")
+		{
+			delay = static_cast<uint32_t>(value);
+		}
+		else if (arg == "--slots")
+		{
+			slots = static_cast<uint32_t>(value);
+		}
+		else if (arg == "--ring-size")
+		{
+			ring_size = value;
+		}
+		else
+		{
+			std::cerr << "unknown argument: " << arg << std::endl;
+			return 2;
+		}
+	}
+
+	LogFileWriter::ptr writer = std::make_shared<LogFileWriter>();
+	if (!writer->open(file, true))
+	{
+		std::cerr << "open file=" << file << " failed" << std::endl;
+		return 1;
+	}
+	writer->setRotatePolicy(rotate);
+	LogShmCollector::ptr collector = LogShmCollector::Open(channel, writer, delay, slots, ring_size);
+	if (!collector)
+	{
+		std::cerr << "open channel=" << channel << " failed" << std::endl;
+		return 1;
+	}
+	std::signal(SIGINT, OnSignal);
+	std::signal(SIGTERM, OnSignal);
+
+	while (s_running.load())
+	{
+		collector->poll();
+		std::this_thread::sleep_for(std::chrono::milliseconds(poll));
+	}
+	collector->poll(true);
+	std::cerr << "written " << collector->getWrittenCount() << " events, dropped " << collector->getDroppedCount()
+		<< " events, lost " << collector->getLostBytes() << " bytes from crashed processes" << std::endl;
+	collector.reset();
+	writer->close();
+	if (remove)
+	{
+		LogShmChannel::Remove(channel);
+	}
+	return 0;
+}
\ No newline at end of file
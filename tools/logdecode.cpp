@@ -0,0 +1,43 @@
+#include <iostream>
+#include <fstream>
+#include "Log.h"
+
+/***************************************************
+	二进制日志解码工具
+	logdecode <binary log file> [pattern]
+	按pattern(默认为日志器的默认格式)把
+	BinaryLogAppender写出的文件还原为文本，输出到标准输出
+***************************************************/
+int main(int argc, char** argv)
+{
+	using namespace GameProjectServer;
+	if (argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " <binary log file> [pattern]" << std::endl;
+		return 2;
+	}
+	std::ifstream in(argv[1], std::ios_base::in | std::ios_base::binary);
+	if (!in)
+	{
+		std::cerr << "open file=" << argv[1] << " failed" << std::endl;
+		return 1;
+	}
+	LogFormatter::ptr formatter(new LogFormatter(argc > 2 ? argv[2] : LogFormatter::kDefaultPattern));
+	if (formatter->isError())
+	{
+		std::cerr << "invalid pattern: " << argv[2] << std::endl;
+		return 2;
+	}
+
+	BinaryLogDecoder decoder(formatter);
+	bool ok = decoder.decode(in, std::cout);
+	std::cout.flush();
+	if (!ok)
+	{
+		//进程崩溃时文件尾部的记录可能不完整，之前的内容已输出
+		std::cerr << "decode stopped after " << decoder.getCount() << " events: "
+			<< decoder.getError() << std::endl;
+		return 1;
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include <iostream>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Log.h"
+
+/***************************************************
+	按旁路索引查找日志文件
+	logseek <log file> [--from time] [--to time] [--level level] [--list]
+	time为本地时间"YYYY-mm-dd HH:MM:SS"或纳秒时间戳，
+	只读取时间范围与级别可能满足的块并原样输出到标准输出，
+	输出以块为单位，块边缘可能带有范围外的行；
+	--list只列出选中的区间(起始 结束)
+***************************************************/
+using namespace GameProjectServer;
+
+//解析时间参数，失败返回false
+static bool ParseTime(std::string str, uint64_t& ns)
+{
+	if (!str.empty() && str.find_first_not_of("0123456789") == std::string::npos)
+	{
+		ns = std::strtoull(str.c_str(), nullptr, 10);
+		return true;
+	}
+	for (auto& c : str)
+	{
+		if (c == 'T')
+		{
+			c = ' ';
+		}
+	}
+	std::tm tm = {};
+	std::istringstream ss(str);
+	ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+	if (ss.fail())
+	{
+		return false;
+	}
+	tm.tm_isdst = -1;
+	std::time_t t = std::mktime(&tm);
+	if (t < 0)
+	{
+		return false;
+	}
+	ns = static_cast<uint64_t>(t) * 1000000000ULL;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: " << argv[0]
+			<< " <log file> [--from time] [--to time] [--level level] [--list]" << std::endl;
+		return 2;
+	}
+	std::string file = argv[1];
+	uint64_t from = 0;
+	uint64_t to = UINT64_MAX;
+	uint8_t level = 0;
+	bool list = false;
+	for (int i = 2; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if ((arg == "--from" || arg == "--to") && i + 1 < argc)
+		{
+			if (!ParseTime(argv[++i], arg == "--from" ? from : to))
+			{
+				std::cerr << "invalid time: " << argv[i] << std::endl;
+				return 2;
+			}
+		}
+		else if (arg == "--level" && i + 1 < argc)
+		{
+			level = static_cast<uint8_t>(LogLevel::FromString(argv[++i]));
+			if (level == LogLevel::UNKNOW)
+			{
+				std::cerr << "invalid level: " << argv[i] << std::endl;
+				return 2;
+			}
+		}
+		else if (arg == "--list")
+		{
+			list = true;
+		}
+		else
+		{
+			std::cerr << "unknown argument: " << arg << std::endl;
+			return 2;
+		}
+	}
+
+	std::ifstream in(file, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+	if (!in)
+	{
+		std::cerr << "open file=" << file << " failed" << std::endl;
+		return 1;
+	}
+	uint64_t file_size = static_cast<uint64_t>(in.tellg());
+	std::vector<LogIndexEntry> entries;
+	if (!LogFileIndex::Load(LogFileIndex::GetIndexName(file), entries))
+	{
+		//没有索引时整个文件都要读取
+		std::cerr << "no index for " << file << ", reading the whole file" << std::endl;
+	}
+	std::vector<LogIndexRange> ranges = LogFileIndex::Select(entries, file_size, from, to, level);
+
+	uint64_t selected = 0;
+	std::vector<char> buf(1024 * 1024);
+	for (auto& r : ranges)
+	{
+		selected += r.end - r.begin;
+		if (list)
+		{
+			std::cout << r.begin << ' ' << r.end << '\n';
+			continue;
+		}
+		in.seekg(static_cast<std::streamoff>(r.begin));
+		uint64_t left = r.end - r.begin;
+		while (left && in)
+		{
+			size_t n = static_cast<size_t>(left < buf.size() ? left : buf.size());
+			in.read(buf.data(), n);
+			std::cout.write(buf.data(), in.gcount());
+			left -= static_cast<uint64_t>(in.gcount());
+		}
+	}
+	std::cout.flush();
+	std::cerr << "read " << selected << " of " << file_size << " bytes in " << ranges.size()
+		<< " ranges, " << entries.size() << " index entries" << std::endl;
+	return 0;
+}
\ No newline at end of file